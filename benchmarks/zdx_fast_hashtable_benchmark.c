@@ -1,7 +1,11 @@
+// glibc hides clock_gettime behind feature macros when compiling with -std=c17
+#define _DEFAULT_SOURCE
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 
 typedef struct {
@@ -11,6 +15,7 @@ typedef struct {
 #define ZDX_FAST_HASHTABLE_IMPLEMENTATION
 #define FHT_VALUE_TYPE my_type_t
 /* #define FHT_MAX_KEYLEN 13 */
+#define FHT_MAX_KEYCOUNT_BITS 22 // so that run_growable() can grow past 2^20
 #include "../zdx_fast_hashtable.h"
 
 // we want to use assertm for test like asserts so we
@@ -22,12 +27,51 @@ typedef struct {
 #endif
 
 
-void run(const uint32_t insert_count, const uint32_t lookup_count, const uint8_t max_key_len)
+// Lookups before and after the control byte groups in fht_get_index_(), in seconds for the runs in main()
+// (gcc -O2, x86_64). Before, a miss walked every slot of the table as nothing marked a slot as free.
+//
+// | inserts / capacity | lookups |  before | SSE2 | scalar (FHT_NO_SIMD) | misses |  before |  SSE2 | scalar |
+// |--------------------|---------|---------|------|----------------------|--------|---------|-------|--------|
+// |         10 / 10    |   30M   |   1.73  | 1.28 |         1.45         |    -   |     -   |    -  |    -   |
+// |        100 / 100   |   25M   |   2.22  | 1.20 |         1.56         |    -   |     -   |    -  |    -   |
+// |         1K / 1K    |   18.5M |   2.11  | 0.93 |         1.71         |    -   |     -   |    -  |    -   |
+// |        10K / 10K   |   11.7M |   4.57  | 0.89 |         2.59         |    -   |     -   |    -  |    -   |
+// |       100K / 100K  |    3.8M |   4.11  | 0.54 |         1.90         |    -   |     -   |    -  |    -   |
+// |         1M / 1M    |    1M   |   3.34  | 0.50 |         2.17         |    -   |     -   |    -  |    -   |
+// |        10K / 11.4K |   11.7M |   0.87  | 0.59 |         0.75         |  1.17M |   33.6  | 0.088 |  0.178 |
+// |       100K / 114K  |    3.8M |   0.37  | 0.31 |         0.43         |   380K |  126.7  | 0.035 |  0.060 |
+// |       900K / 1.03M |    1M   |   0.20  | 0.18 |         0.28         |   100K | not run | 0.013 |  0.035 |
+//
+// Robin Hood placement with fht_remove() after that, same runs but with misses for half as many keys as lookups
+// in every table. Misses in full tables used to go on until every group was checked, they now stop after the
+// longest probe length in the table. Inserts into an almost full table and hits in a full table get slower
+// as keys are moved around to keep every key about as far from its slot as the others. Columns are before / after.
+//
+// | inserts / capacity |   inserts   |   lookups   |     misses     | remove/add | removes |
+// |--------------------|-------------|-------------|----------------|------------|---------|
+// |            10 / 10 | 0.00 / 0.00 | 1.23 / 1.28 |  0.73 / 0.85   |     -      |  0.000  |
+// |          100 / 100 | 0.00 / 0.00 | 1.22 / 1.19 |  0.95 / 0.76   |     -      |  0.000  |
+// |            1K / 1K | 0.00 / 0.00 | 1.00 / 1.15 |  2.88 / 0.55   |     -      |  0.000  |
+// |          10K / 10K | 0.00 / 0.01 | 0.89 / 1.17 | not run / 0.63 |     -      |  0.002  |
+// |        100K / 100K | 0.04 / 0.16 | 0.55 / 0.72 | not run / 0.43 |     -      |  0.050  |
+// |            1M / 1M | 0.61 / 5.87 | 0.54 / 0.67 | not run / 0.41 |     -      |   2.73  |
+// |        10K / 11.4K | 0.00 / 0.00 | 0.64 / 0.59 |  0.44 / 0.41   |    0.34    |  0.001  |
+// |        100K / 114K | 0.04 / 0.04 | 0.31 / 0.32 |  0.15 / 0.15   |    0.15    |  0.007  |
+// |       900K / 1.03M | 0.54 / 0.58 | 0.20 / 0.19 | 0.057 / 0.060  |    0.07    |   0.15  |
+
+void run(const uint32_t insert_count, const uint32_t cap, const uint32_t lookup_count, const uint8_t max_key_len)
 {
-  fht_t fht = fht_init(insert_count);
+  fht_t fht = fht_init(cap);
+  // slots can be empty and keys move around on fht_add() and fht_remove() so keep a copy of every key
+  fht_key_t *keys = malloc(sizeof(*keys) * insert_count);
+  const uint32_t miss_count = lookup_count / 2;
+  // every slot of a full table is part of one long run of keys which a removal shifts back and the add after
+  // it walks through to reach the freed slot, so only churn tables with some room left
+  const uint32_t churn_count = cap > insert_count ? lookup_count / 10 : 0;
 
   printf("\n--------------------------------------------INFO--------------------------------------------\n");
-  printf("Table: Fast hashtable, Max key length: %u, Unique Inserts: %u, Random Lookups: %u\n", max_key_len, insert_count, lookup_count);
+  printf("Table: Fast hashtable, Max key length: %u, Unique Inserts: %u, Capacity: %u, Random Lookups: %u, Misses: %u, "
+         "Remove/Add: %u\n", max_key_len, insert_count, cap, lookup_count, miss_count, churn_count);
   printf("--------------------------------------------------------------------------------------------\n");
 
   srand(1337);
@@ -59,14 +103,16 @@ void run(const uint32_t insert_count, const uint32_t lookup_count, const uint8_t
       log(L_ERROR, "Error: Failed to set key `%s` due to `%s`", key, fht_err_str(add_ret_val.err));
       exit(1);
     }
+
+    keys[i].key_len = key_len;
+    memcpy(keys[i].key, key, key_len);
   }
   PROF_END(INSERTS);
 
   PROF_START(LOOKUPS);
   for (uint32_t i = 0; i < lookup_count; i++) {
     // mimic random access of hashtable
-    uint32_t random_key_index = (uint32_t)rand() % insert_count;
-    fht_key_t *key_obj = &fht.keys[random_key_index];
+    fht_key_t *key_obj = &keys[(uint32_t)rand() % insert_count];
     char *key = key_obj->key;
     uint8_t key_len = key_obj->key_len;
 
@@ -84,11 +130,145 @@ void run(const uint32_t insert_count, const uint32_t lookup_count, const uint8_t
   }
   PROF_END(LOOKUPS);
 
+  PROF_START(MISSES);
+  for (uint32_t i = 0; i < miss_count; i++) {
+    // inserted keys never contain '~' (126) so this is always a miss for a key of an existing length
+    fht_key_t *key_obj = &keys[(uint32_t)rand() % insert_count];
+    char key[FHT_MAX_KEYLEN];
+    uint8_t key_len = key_obj->key_len;
+
+    memcpy(key, key_obj->key, key_len);
+    key[i % key_len] = '~';
+
+    const fht_ret_val_t get_ret_val = fht_get(&fht, key, key_len);
+
+    assertm(get_ret_val.err == FHT_ERR_KEY_NOT_FOUND, "Expected: FHT_ERR_KEY_NOT_FOUND, Received: %u", get_ret_val.err);
+  }
+  PROF_END(MISSES);
+
   assertm(fht.count == insert_count, "Expected: %u, Received: %u", insert_count, fht.count);
 
+  // delete heavy: keys keep getting removed and added back so every removal shifts its neighbours
+  PROF_START(CHURN);
+  for (uint32_t i = 0; i < churn_count; i++) {
+    fht_key_t *key_obj = &keys[(uint32_t)rand() % insert_count];
+
+    const fht_ret_val_t remove_ret_val = fht_remove(&fht, key_obj->key, key_obj->key_len);
+    assertm(remove_ret_val.err == FHT_ERR_NONE, "Expected: key to be removed, Received: %s", fht_err_str(remove_ret_val.err));
+
+    const fht_ret_index_t add_ret_val = fht_add(&fht, key_obj->key, key_obj->key_len, remove_ret_val.val);
+    assertm(add_ret_val.err == FHT_ERR_NONE, "Expected: key to be added, Received: %s", fht_err_str(add_ret_val.err));
+  }
+  PROF_END(CHURN);
+
+  PROF_START(REMOVES);
+  for (uint32_t i = 0; i < insert_count; i++) {
+    const fht_ret_val_t remove_ret_val = fht_remove(&fht, keys[i].key, keys[i].key_len);
+
+    assertm(remove_ret_val.err == FHT_ERR_NONE, "Expected: key to be removed, Received: %s", fht_err_str(remove_ret_val.err));
+    assertm(memcmp(remove_ret_val.val.val, keys[i].key, keys[i].key_len) == 0,
+            "Expected: `%.*s` as val, Received: `%s` as val", keys[i].key_len, keys[i].key, remove_ret_val.val.val);
+    free(remove_ret_val.val.val);
+  }
+  PROF_END(REMOVES);
+
+  assertm(fht.count == 0, "Expected: 0, Received: %u", fht.count);
+
+  free(keys);
   fht_deinit(&fht);
 }
 
+static uint64_t now_ns(void)
+{
+  struct timespec ts = {0};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+  const uint32_t x = *(const uint32_t *)a;
+  const uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Latency of every single fht_add() into a hashtable from fht_init_growable(initial_cap) compared to one
+// from fht_init() with room for every key up front, reported for every doubling of the key count.
+// The growable p99 stays at a few microseconds in every row instead of growing with the table, since no
+// fht_add() ever moves every key at once: fht_grow_() itself took 14us at 2^17 keys and 44us at 2^22,
+// the keys are then moved FHT_MIGRATE_SLOTS slots per fht_add(). Those adds (about one in six here) are
+// what the growable p99 is made of, together with first touching the pages of the new table.
+// A stop-the-world rehash of the last growth would have moved ~1.8M keys in one call (~200ms).
+// The max column is page faults and scheduler noise in both cases.
+//
+// |      inserts      | growable p50 |  p99  | p99.9 |   max   | presized p50 |  p99  | p99.9 |   max   | (ns)
+// |-------------------|--------------|-------|-------|---------|--------------|-------|-------|---------|
+// |   65536 -  131071 |          177 |  3758 |  9255 |   38393 |          205 |   540 |  2380 |   25353 |
+// |  131072 -  262143 |          186 |  3129 |  6177 | 1129812 |          202 |   407 |   692 |   43051 |
+// |  262144 -  524287 |          232 |  3223 |  6455 |  336801 |          203 |   413 |   910 |  246513 |
+// |  524288 - 1048575 |          263 |  2523 |  4808 | 1341101 |          207 |   421 |   749 |  219384 |
+// | 1048576 - 2097151 |          264 |  3166 |  8649 | 2536950 |          217 |   464 |   880 |  287481 |
+// | 2097152 - 2999999 |          246 |   849 |  2172 | 1500026 |          235 |   596 |  1137 | 1013305 |
+void run_growable(const uint32_t insert_count, const uint32_t initial_cap)
+{
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Table: Fast hashtable, Growable from %u vs presized, Unique Inserts: %u\n", initial_cap, insert_count);
+  printf("--------------------------------------------------------------------------------------------\n");
+
+  fht_key_t *keys = malloc(sizeof(*keys) * insert_count);
+  uint32_t *latencies[2] = { malloc(sizeof(uint32_t) * insert_count), malloc(sizeof(uint32_t) * insert_count) };
+
+  // the counter makes every key unique and the random chars spread them out
+  srand(1337);
+  for (uint32_t i = 0; i < insert_count; i++) {
+    int len = snprintf(keys[i].key, FHT_MAX_KEYLEN, "%x", i);
+    for (; len < FHT_MAX_KEYLEN - 1; len++) {
+      keys[i].key[len] = (char)(33 + rand() % 93);
+    }
+    keys[i].key_len = (unsigned int)len;
+  }
+
+  for (uint8_t growable = 0; growable < 2; growable++) {
+    fht_t fht = growable ? fht_init_growable(initial_cap) : fht_init(FHT_MAX_KEYCOUNT);
+    uint32_t *latency = latencies[growable];
+
+    PROF_START(GROWABLE_INSERTS);
+    for (uint32_t i = 0; i < insert_count; i++) {
+      const uint64_t start = now_ns();
+      const fht_ret_index_t add_ret_val = fht_add(&fht, keys[i].key, keys[i].key_len, (my_type_t){0});
+      latency[i] = (uint32_t)(now_ns() - start);
+
+      assertm(add_ret_val.err == FHT_ERR_NONE, "Expected: key to be added, Received: %s", fht_err_str(add_ret_val.err));
+    }
+    PROF_END(GROWABLE_INSERTS);
+
+    for (uint32_t i = 0; i < insert_count; i += insert_count / 1000) {
+      const fht_ret_val_t get_ret_val = fht_get(&fht, keys[i].key, keys[i].key_len);
+      assertm(get_ret_val.err == FHT_ERR_NONE, "Expected: key to be found, Received: %s", fht_err_str(get_ret_val.err));
+    }
+
+    fht_deinit(&fht);
+  }
+
+  printf("|      inserts      | growable p50 |  p99  | p99.9 |   max   | presized p50 |  p99  | p99.9 |   max   |\n");
+  for (uint32_t from = 1 << 16; from < insert_count; from *= 2) {
+    const uint32_t to = from * 2 < insert_count ? from * 2 : insert_count;
+    const uint32_t n = to - from;
+
+    printf("| %7u - %7u |", from, to - 1);
+    for (uint8_t growable = 2; growable-- > 0;) {
+      uint32_t *window = latencies[growable] + from;
+      qsort(window, n, sizeof(*window), cmp_u32);
+      printf(" %12u | %5u | %5u | %7u |", window[n / 2], window[n - n / 100], window[n - n / 1000], window[n - 1]);
+    }
+    printf("\n");
+  }
+
+  free(latencies[0]);
+  free(latencies[1]);
+  free(keys);
+}
+
 int main(void)
 {
   printf("\n--------------------------------------------HEADER------------------------------------------\n");
@@ -99,11 +279,19 @@ int main(void)
   printf("sizeof(fht_ret_val_t): %zu bytes\n", sizeof(fht_ret_val_t));
   printf("--------------------------------------------------------------------------------------------\n");
 
-  run(1e1, 3e7, FHT_MAX_KEYLEN);
-  run(1e2, 2e7+5e6, FHT_MAX_KEYLEN);
-  run(1e3, 1e7+8e6+5e5, FHT_MAX_KEYLEN);
-  run(1e4, 1e7+1e6+7e5+2e4, FHT_MAX_KEYLEN);
-  run(1e5, 3e6+8e5, FHT_MAX_KEYLEN);
-  run(1e6, 1e6, FHT_MAX_KEYLEN);
+  // full tables
+  run(1e1, 1e1, 3e7, FHT_MAX_KEYLEN);
+  run(1e2, 1e2, 2e7+5e6, FHT_MAX_KEYLEN);
+  run(1e3, 1e3, 1e7+8e6+5e5, FHT_MAX_KEYLEN);
+  run(1e4, 1e4, 1e7+1e6+7e5+2e4, FHT_MAX_KEYLEN);
+  run(1e5, 1e5, 3e6+8e5, FHT_MAX_KEYLEN);
+  run(1e6, 1e6, 1e6, FHT_MAX_KEYLEN);
+
+  // 7/8 full tables
+  run(1e4, 1e4 * 8 / 7, 1e7+1e6+7e5+2e4, FHT_MAX_KEYLEN);
+  run(1e5, 1e5 * 8 / 7, 3e6+8e5, FHT_MAX_KEYLEN);
+  run(9e5, 9e5 * 8 / 7, 1e6, FHT_MAX_KEYLEN);
+
+  run_growable(3e6, 16);
   printf("\nDone!\n");
 }
@@ -0,0 +1,300 @@
+// glibc hides MAP_ANONYMOUS and clock_gettime behind feature macros when compiling with -std=c17
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// mem_static_*() in this file call the arena adapter directly, see bench_static_binding()
+#define MEM_STATIC_BACKEND arena_adapter
+#define ZDX_MEMORY_IMPLEMENTATION_AUTO
+#include "../zdx_memory.h"
+
+// we want to use assertm for test like asserts so we
+// enable assertm by undef-ing NDEBUG if it's defined
+#ifdef NDEBUG
+#undef NDEBUG
+#include "../zdx_util.h"
+#define NDEBUG
+#endif
+
+
+static double now_secs(void)
+{
+  struct timespec ts = {0};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift64(uint64_t *state)
+{
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+// ------------------------- MULTI-THREADED CHURN -------------------------
+
+#define CHURN_OPS_PER_THREAD (1 << 20)
+#define CHURN_LIVE_OBJS 1024
+#define CHURN_MAX_THREADS 16
+
+static const size_t churn_sizes[] = { 16, 24, 32, 48, 64, 96, 128, 256 };
+#define CHURN_SIZES_COUNT (sizeof(churn_sizes) / sizeof(churn_sizes[0]))
+
+typedef struct {
+  mem_allocator_t *al;
+  const int *go;
+  uint64_t seed;
+} churn_worker_t;
+
+static void *churn_worker(void *arg)
+{
+  churn_worker_t *worker = arg;
+  mem_allocator_t *al = worker->al;
+  void *live[CHURN_LIVE_OBJS] = {0};
+  uint64_t rng = worker->seed;
+
+  while (!__atomic_load_n(worker->go, __ATOMIC_ACQUIRE)) {}
+
+  // each op frees a random live object and allocates a new one of a random size in its place
+  for (size_t i = 0; i < CHURN_OPS_PER_THREAD; i++) {
+    const uint64_t r = xorshift64(&rng);
+    const size_t idx = r % CHURN_LIVE_OBJS;
+
+    al->free(al, live[idx]);
+    live[idx] = al->alloc(al, churn_sizes[(r >> 32) % CHURN_SIZES_COUNT]);
+    assertm(live[idx] != NULL, "Expected: allocation to succeed, Received: NULL");
+    *(char *)live[idx] = (char)i; // touch the allocation like a real user would
+  }
+
+  for (size_t i = 0; i < CHURN_LIVE_OBJS; i++) {
+    al->free(al, live[i]);
+  }
+
+  return NULL;
+}
+
+static double run_churn(mem_allocator_t *const al, const size_t thread_count)
+{
+  churn_worker_t workers[CHURN_MAX_THREADS] = {0};
+  pthread_t threads[CHURN_MAX_THREADS] = {0};
+  int go = 0;
+
+  for (size_t i = 0; i < thread_count; i++) {
+    workers[i] = (churn_worker_t){ .al = al, .go = &go, .seed = 0x9E3779B97F4A7C15ull * (i + 1) };
+    pthread_create(&threads[i], NULL, churn_worker, &workers[i]);
+  }
+
+  const double start = now_secs();
+  __atomic_store_n(&go, 1, __ATOMIC_RELEASE);
+
+  for (size_t i = 0; i < thread_count; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  const double elapsed = now_secs() - start;
+
+  return (double)(thread_count * CHURN_OPS_PER_THREAD) / elapsed / 1e6;
+}
+
+static void bench_churn(void)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t max_threads = cpus > 0 ? (size_t)cpus * 2 : 8;
+  max_threads = max_threads > CHURN_MAX_THREADS ? CHURN_MAX_THREADS : max_threads;
+
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Multi-threaded free + alloc churn, Online CPUs: %ld, Ops per thread: %d, Live objects per thread: %d\n",
+         cpus, CHURN_OPS_PER_THREAD, CHURN_LIVE_OBJS);
+  printf("gpa    = mem_gpa_init() i.e. malloc(3)/free(3)\n");
+  printf("tcache = mem_tcache_init() with per-thread caches over a central depot\n");
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%8s | %16s | %19s | %10s\n", "threads", "gpa (M ops/s)", "tcache (M ops/s)", "tcache/gpa");
+
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    mem_allocator_t gpa = mem_gpa_init("gpa");
+    mem_allocator_t tcache = mem_tcache_init("tcache");
+    assertm(tcache.ctx != NULL, "Expected: tcache allocator to be created, Received: NULL ctx");
+
+    const double gpa_ops = run_churn(&gpa, threads);
+    const double tcache_ops = run_churn(&tcache, threads);
+
+    printf("%8zu | %16.2f | %19.2f | %10.2f\n", threads, gpa_ops, tcache_ops, tcache_ops / gpa_ops);
+
+    tcache.deinit(&tcache);
+    gpa.deinit(&gpa);
+  }
+}
+
+// ------------------------- LONG-LIVED MIXED-SIZE FRAGMENTATION -------------------------
+
+#define FRAG_LIVE_OBJS 4096
+#define FRAG_OPS (1 << 20)
+#define FRAG_SAMPLES 8
+#define FRAG_MIN_SHIFT 4   // 16 bytes
+#define FRAG_MAX_SHIFT 16  // 64 KB
+#define FRAG_REGION_SIZE ((size_t)64 * 1024 * 1024)
+
+// log uniform i.e. as many 16-32 byte requests as 32-64 KB ones, roughly what long-lived session state looks like
+static size_t frag_size(uint64_t *rng)
+{
+  const uint64_t r = xorshift64(rng);
+  const size_t shift = FRAG_MIN_SHIFT + (size_t)(r % (FRAG_MAX_SHIFT - FRAG_MIN_SHIFT));
+  const size_t lo = (size_t)1 << shift;
+
+  return lo + (size_t)((r >> 32) % lo);
+}
+
+static void frag_report(const mem_allocator_t *const buddy, const size_t ops, const size_t live_bytes)
+{
+  const mem_buddy_stats_t stats = mem_buddy_stats(buddy);
+  const double internal = stats.allocated_bytes ? 1.0 - (double)live_bytes / (double)stats.allocated_bytes : 0;
+  const double external = stats.free_bytes ? 1.0 - (double)stats.largest_free / (double)stats.free_bytes : 0;
+
+  printf("%10zu | %13zu | %15zu | %13.1f%% | %10zu | %15zu | %13.1f%% | %8zu\n",
+         ops, live_bytes / 1024, stats.allocated_bytes / 1024, internal * 100,
+         stats.free_bytes / 1024, stats.largest_free / 1024, external * 100, stats.failed_count);
+}
+
+// frees a random live object and allocates one of a random size in its place, FRAG_OPS times
+static double run_frag(const mem_allocator_t *const al, const bool report)
+{
+  void **live = calloc(FRAG_LIVE_OBJS, sizeof(*live));
+  size_t *sizes = calloc(FRAG_LIVE_OBJS, sizeof(*sizes));
+  assertm(live && sizes, "Expected: bookkeeping to be allocated, Received: NULL");
+
+  uint64_t rng = 0x2545F4914F6CDD1Dull;
+  size_t live_bytes = 0;
+
+  const double start = now_secs();
+  for (size_t i = 0; i < FRAG_OPS; i++) {
+    const size_t idx = xorshift64(&rng) % FRAG_LIVE_OBJS;
+
+    al->free(al, live[idx]);
+    live_bytes -= sizes[idx];
+
+    sizes[idx] = frag_size(&rng);
+    live[idx] = al->alloc(al, sizes[idx]);
+    if (live[idx]) {
+      *(char *)live[idx] = (char)i; // touch the allocation like a real user would
+      live_bytes += sizes[idx];
+    } else {
+      sizes[idx] = 0;
+    }
+
+    if (report && (i + 1) % (FRAG_OPS / FRAG_SAMPLES) == 0) {
+      frag_report(al, i + 1, live_bytes);
+    }
+  }
+  const double elapsed = now_secs() - start;
+
+  for (size_t i = 0; i < FRAG_LIVE_OBJS; i++) {
+    al->free(al, live[i]);
+  }
+  free(sizes);
+  free(live);
+
+  return (double)FRAG_OPS / elapsed / 1e6;
+}
+
+static void bench_fragmentation(void)
+{
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Long-lived mixed-size churn, Live objects: %d, Ops: %d, Sizes: %d B to %d KB (log uniform)\n",
+         FRAG_LIVE_OBJS, FRAG_OPS, 1 << FRAG_MIN_SHIFT, (1 << FRAG_MAX_SHIFT) / 1024);
+  printf("buddy = mem_buddy_init() over a %zu MB region, stats sampled every %d ops\n",
+         FRAG_REGION_SIZE / (1024 * 1024), FRAG_OPS / FRAG_SAMPLES);
+  printf("internal frag = 1 - requested / allocated, external frag = 1 - largest free block / free bytes\n");
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%10s | %13s | %15s | %14s | %10s | %15s | %14s | %8s\n", "ops", "live KB", "allocated KB",
+         "internal frag", "free KB", "largest free KB", "external frag", "failed");
+
+  mem_allocator_t gpa = mem_gpa_init("gpa");
+  mem_allocator_t slab = mem_slab_init("slab");
+  mem_allocator_t buddy = mem_buddy_init("buddy", FRAG_REGION_SIZE);
+  assertm(slab.ctx != NULL && buddy.ctx != NULL, "Expected: allocators to be created, Received: NULL ctx");
+
+  const double buddy_ops = run_frag(&buddy, true);
+  const double gpa_ops = run_frag(&gpa, false);
+  const double slab_ops = run_frag(&slab, false);
+
+  printf("\n%-10s | %10s\n", "allocator", "M ops/s");
+  printf("%-10s | %10.2f\n", "gpa", gpa_ops);
+  printf("%-10s | %10.2f\n", "slab", slab_ops);
+  printf("%-10s | %10.2f\n", "buddy", buddy_ops);
+
+  buddy.deinit(&buddy);
+  slab.deinit(&slab);
+  gpa.deinit(&gpa);
+}
+
+// ------------------------- VTABLE VS STATIC BINDING -------------------------
+
+#define BINDING_ALLOCS (1 << 24)
+#define BINDING_ALLOCS_PER_RESET 4096
+#define BINDING_ALLOC_SIZE 32
+
+// read through a volatile pointer so the compiler can't see which allocator it is and devirtualise the vtable calls
+static const mem_allocator_t *volatile binding_al;
+
+static double run_binding(const bool use_static)
+{
+  arena_t arena = arena_create((size_t)BINDING_ALLOCS_PER_RESET * BINDING_ALLOC_SIZE * 2);
+  assertm(!arena.err, "Expected: arena to be created, Received: %s", arena.err);
+  mem_allocator_t adapter = mem_arena_init("arena", &arena);
+
+  binding_al = &adapter;
+  const mem_allocator_t *al = binding_al;
+  uintptr_t sink = 0;
+
+  const double start = now_secs();
+  for (size_t i = 0; i < BINDING_ALLOCS; i++) {
+    if (i % BINDING_ALLOCS_PER_RESET == 0) {
+      use_static ? mem_static_empty(al) : al->empty(al);
+    }
+
+    char *ptr = use_static ? mem_static_alloc(al, BINDING_ALLOC_SIZE) : al->alloc(al, BINDING_ALLOC_SIZE);
+    *ptr = (char)i;
+    sink ^= (uintptr_t)ptr;
+  }
+  const double elapsed = now_secs() - start;
+
+  assertm(sink != 1, "Expected: sink to be used, Received: %zu", (size_t)sink);
+
+  adapter.deinit(&adapter);
+  arena_free(&arena);
+
+  return elapsed;
+}
+
+static void bench_static_binding(void)
+{
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Vtable vs static binding over mem_arena_init(), Allocations: %d of %d bytes, Reset every %d allocations\n",
+         BINDING_ALLOCS, BINDING_ALLOC_SIZE, BINDING_ALLOCS_PER_RESET);
+  printf("vtable = al->alloc(al, sz), static = mem_static_alloc(al, sz) with MEM_STATIC_BACKEND arena_adapter\n");
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%-20s | %10s | %14s\n", "binding", "ms", "ns per alloc");
+
+  const double vtable_secs = run_binding(false);
+  const double static_secs = run_binding(true);
+
+  printf("%-20s | %10.2f | %14.2f\n", "vtable", vtable_secs * 1e3, vtable_secs * 1e9 / BINDING_ALLOCS);
+  printf("%-20s | %10.2f | %14.2f\n", "static", static_secs * 1e3, static_secs * 1e9 / BINDING_ALLOCS);
+}
+
+int main(void)
+{
+  bench_churn();
+  bench_fragmentation();
+  bench_static_binding();
+
+  printf("\nDone!\n");
+  return 0;
+}
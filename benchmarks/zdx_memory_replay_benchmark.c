@@ -0,0 +1,344 @@
+// glibc hides MAP_ANONYMOUS and clock_gettime behind feature macros when compiling with -std=c17
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define ZDX_MEMORY_IMPLEMENTATION_AUTO
+#include "../zdx_memory.h"
+
+// we want to use assertm for test like asserts so we
+// enable assertm by undef-ing NDEBUG if it's defined
+#ifdef NDEBUG
+#undef NDEBUG
+#include "../zdx_util.h"
+#define NDEBUG
+#endif
+
+/*
+ * Replays an allocation trace recorded with mem_trace_init() against each allocator in a forked child
+ * so that peak RSS is measured from a clean slate for every allocator.
+ *
+ * Usage: zdx_memory_replay_benchmark [trace file]
+ *   Without a trace file, a synthetic request/response style workload is recorded and replayed.
+ */
+
+static double now_secs(void)
+{
+  struct timespec ts = {0};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift64(uint64_t *state)
+{
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+static size_t max_rss_kb(void)
+{
+  struct rusage usage = {0};
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return (size_t)usage.ru_maxrss / 1024; // bytes on macos
+#else
+  return (size_t)usage.ru_maxrss;        // kilobytes on linux
+#endif
+}
+
+// ------------------------- SYNTHETIC WORKLOAD -------------------------
+
+#define SYNTH_REQUESTS 20000
+#define SYNTH_OBJS_PER_REQUEST 64
+#define SYNTH_LONG_LIVED 4096
+
+/* every request allocates a bunch of small objects and a growing buffer and frees almost all of it,
+   a few objects survive into a long lived set that evicts older ones at random */
+static void record_synthetic_trace(const char *const path)
+{
+  mem_allocator_t gpa = mem_gpa_init("gpa");
+  mem_allocator_t trace = mem_trace_init("trace", &gpa, path);
+  assertm(trace.ctx != NULL, "Expected: trace file %s to be created, Received: NULL ctx", path);
+
+  static void *long_lived[SYNTH_LONG_LIVED] = {0};
+  void *objs[SYNTH_OBJS_PER_REQUEST] = {0};
+  uint64_t rng = 0x2545F4914F6CDD1Dull;
+
+  for (size_t req = 0; req < SYNTH_REQUESTS; req++) {
+    for (size_t i = 0; i < SYNTH_OBJS_PER_REQUEST; i++) {
+      const uint64_t r = xorshift64(&rng);
+      // mostly small objects with the occasional page sized one
+      const size_t sz = (r & 0xff) == 0 ? 4096 + (r >> 8) % 8192 : 8 + (r >> 8) % 248;
+      objs[i] = i % 8 == 0 ? trace.calloc(&trace, 1, sz) : trace.alloc(&trace, sz);
+    }
+
+    size_t buf_sz = 32;
+    char *buf = trace.alloc(&trace, buf_sz);
+    const size_t buf_max = 64 << (req % 8);
+    while (buf_sz < buf_max) {
+      buf = trace.realloc(&trace, buf, buf_sz, buf_sz * 2);
+      buf_sz *= 2;
+    }
+    trace.free(&trace, buf);
+
+    for (size_t i = 0; i < SYNTH_OBJS_PER_REQUEST; i++) {
+      const uint64_t r = xorshift64(&rng);
+
+      if (r % 16 == 0) {
+        const size_t slot = (r >> 8) % SYNTH_LONG_LIVED;
+        trace.free(&trace, long_lived[slot]);
+        long_lived[slot] = objs[i];
+      } else {
+        trace.free(&trace, objs[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < SYNTH_LONG_LIVED; i++) {
+    trace.free(&trace, long_lived[i]);
+  }
+
+  trace.deinit(&trace);
+  gpa.deinit(&gpa);
+}
+
+// ------------------------- TRACE LOADING -------------------------
+
+typedef struct {
+  mem_trace_record_t *records;
+  size_t count;
+  uint32_t max_id;
+  size_t peak_live_bytes;
+} trace_t;
+
+static trace_t load_trace(const char *const path)
+{
+  trace_t trace = {0};
+  FILE *file = fopen(path, "rb");
+  assertm(file != NULL, "Expected: trace file %s to be readable", path);
+
+  mem_trace_header_t header = {0};
+  assertm(fread(&header, sizeof(header), 1, file) == 1, "Expected: trace header in %s", path);
+  assertm(memcmp(header.magic, MEM_TRACE_MAGIC, sizeof(header.magic)) == 0, "Expected: %s to be a trace file", path);
+  assertm(header.version == MEM_TRACE_VERSION && header.record_size == sizeof(mem_trace_record_t),
+          "Expected: trace version %d, Received: version %u with %u byte records",
+          MEM_TRACE_VERSION, header.version, header.record_size);
+
+  fseek(file, 0, SEEK_END);
+  const long file_sz = ftell(file);
+  fseek(file, (long)sizeof(header), SEEK_SET);
+
+  trace.count = ((size_t)file_sz - sizeof(header)) / sizeof(mem_trace_record_t);
+  trace.records = malloc(trace.count * sizeof(mem_trace_record_t));
+  assertm(trace.records != NULL, "Expected: %zu records to fit in memory", trace.count);
+  assertm(fread(trace.records, sizeof(mem_trace_record_t), trace.count, file) == trace.count,
+          "Expected: %zu records to be readable", trace.count);
+  fclose(file);
+
+  for (size_t i = 0; i < trace.count; i++) {
+    trace.max_id = trace.records[i].id > trace.max_id ? trace.records[i].id : trace.max_id;
+  }
+
+  // a dry run to know how many bytes the workload itself needed at its peak
+  size_t *sizes = calloc((size_t)trace.max_id + 1, sizeof(*sizes));
+  size_t live = 0;
+
+  for (size_t i = 0; i < trace.count; i++) {
+    const mem_trace_record_t *r = &trace.records[i];
+
+    switch ((mem_trace_op_t)r->op) {
+    case MEM_TRACE_ALLOC:
+    case MEM_TRACE_CALLOC:
+    case MEM_TRACE_REALLOC:
+      live = live - sizes[r->id] + r->size;
+      sizes[r->id] = r->size;
+      break;
+    case MEM_TRACE_FREE:
+      live -= sizes[r->id];
+      sizes[r->id] = 0;
+      break;
+    case MEM_TRACE_EMPTY:
+      memset(sizes, 0, ((size_t)trace.max_id + 1) * sizeof(*sizes));
+      live = 0;
+      break;
+    }
+
+    trace.peak_live_bytes = live > trace.peak_live_bytes ? live : trace.peak_live_bytes;
+  }
+
+  free(sizes);
+  return trace;
+}
+
+// ------------------------- REPLAY -------------------------
+
+typedef enum {
+  REPLAY_GPA,
+  REPLAY_SLAB,
+  REPLAY_TCACHE,
+  REPLAY_ARENA,
+  REPLAY_COUNT,
+} replay_allocator_t;
+
+static const char *const replay_names[REPLAY_COUNT] = {
+  [REPLAY_GPA] = "gpa",
+  [REPLAY_SLAB] = "slab",
+  [REPLAY_TCACHE] = "tcache",
+  [REPLAY_ARENA] = "arena (growable)",
+};
+
+static void replay(const trace_t *const trace, const replay_allocator_t which)
+{
+  const size_t table_sz = ((size_t)trace->max_id + 1) * sizeof(void *);
+  void **ptrs = calloc(1, table_sz);
+  size_t *sizes = calloc(1, table_sz);
+  assertm(ptrs && sizes, "Expected: id tables for %u ids to fit in memory", trace->max_id);
+
+  // fault the id tables in now so they don't count towards the allocator's RSS. A plain memset gets
+  // folded into the calloc by the compiler, hence the volatile writes
+  const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  for (size_t i = 0; i < table_sz; i += page_size) {
+    ((volatile char *)ptrs)[i] = 0;
+    ((volatile char *)sizes)[i] = 0;
+  }
+
+  arena_t arena = {0};
+  mem_allocator_t al = {0};
+
+  switch (which) {
+  case REPLAY_GPA: al = mem_gpa_init(replay_names[which]); break;
+  case REPLAY_SLAB: al = mem_slab_init(replay_names[which]); break;
+  case REPLAY_TCACHE: al = mem_tcache_init(replay_names[which]); break;
+  case REPLAY_ARENA:
+    arena = arena_create_growable(1 MB);
+    al = mem_arena_init(replay_names[which], &arena);
+    break;
+  case REPLAY_COUNT: break;
+  }
+
+  const size_t rss_before = max_rss_kb();
+  const double start = now_secs();
+
+  for (size_t i = 0; i < trace->count; i++) {
+    const mem_trace_record_t *r = &trace->records[i];
+
+    switch ((mem_trace_op_t)r->op) {
+    case MEM_TRACE_ALLOC:
+      ptrs[r->id] = al.alloc(&al, r->size);
+      sizes[r->id] = r->size;
+      break;
+    case MEM_TRACE_CALLOC:
+      ptrs[r->id] = al.calloc(&al, 1, r->size);
+      sizes[r->id] = r->size;
+      break;
+    case MEM_TRACE_REALLOC:
+      ptrs[r->id] = al.realloc(&al, ptrs[r->id], sizes[r->id], r->size);
+      sizes[r->id] = r->size;
+      break;
+    case MEM_TRACE_FREE:
+      al.free(&al, ptrs[r->id]);
+      ptrs[r->id] = NULL;
+      break;
+    case MEM_TRACE_EMPTY:
+      // empty() is a no-op for some allocators so drop every live object explicitly first
+      for (size_t id = 0; id <= trace->max_id; id++) {
+        al.free(&al, ptrs[id]);
+      }
+      al.empty(&al);
+      memset(ptrs, 0, ((size_t)trace->max_id + 1) * sizeof(*ptrs));
+      break;
+    }
+
+    if (r->op != MEM_TRACE_FREE && r->op != MEM_TRACE_EMPTY) {
+      assertm(ptrs[r->id] != NULL, "Expected: %s to satisfy record %zu, Received: NULL", replay_names[which], i);
+      *(char *)ptrs[r->id] = 1; // touch the allocation like a real user would
+    }
+  }
+
+  const double elapsed = now_secs() - start;
+  const size_t rss_kb = max_rss_kb() - rss_before;
+  const size_t peak_live_kb = trace->peak_live_bytes / 1024;
+
+  printf("%-18s | %10.2f | %12.2f | %14zu | %14zu | %9.2f\n",
+         replay_names[which], elapsed * 1e3, (double)trace->count / elapsed / 1e6,
+         peak_live_kb, rss_kb, peak_live_kb ? (double)rss_kb / (double)peak_live_kb : 0.0);
+
+  al.deinit(&al);
+  if (which == REPLAY_ARENA) {
+    arena_free(&arena);
+  }
+  free(sizes);
+  free(ptrs);
+}
+
+int main(int argc, char **argv)
+{
+  char synth_path[] = "/tmp/zdx_memory_replay_XXXXXX";
+  const char *path = argc > 1 ? argv[1] : NULL;
+
+  if (path == NULL) {
+    int fd = mkstemp(synth_path);
+    assertm(fd >= 0, "Expected: temp file to be created, Received: %d", fd);
+    close(fd);
+
+    // recorded in a child so that the heap it leaves behind doesn't get reused by the gpa replay
+    fflush(stdout);
+    const pid_t pid = fork();
+    assertm(pid >= 0, "Expected: fork to succeed, Received: %d", pid);
+
+    if (pid == 0) {
+      record_synthetic_trace(synth_path);
+      _exit(0);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assertm(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Expected: recording the synthetic trace to succeed");
+    path = synth_path;
+  }
+
+  const trace_t trace = load_trace(path);
+
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Trace replay, Trace: %s, Records: %zu, Allocations: %u\n",
+         argc > 1 ? path : "synthetic", trace.count, trace.max_id);
+  printf("peak RSS   = growth of the max resident set size of a fresh process replaying the trace\n");
+  printf("RSS / live = peak RSS over the peak bytes the trace had live, i.e. overhead + fragmentation\n");
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%-18s | %10s | %12s | %14s | %14s | %9s\n",
+         "allocator", "ms", "M ops/s", "peak live (KB)", "peak RSS (KB)", "RSS/live");
+
+  for (replay_allocator_t which = 0; which < REPLAY_COUNT; which++) {
+    fflush(stdout);
+    const pid_t pid = fork();
+    assertm(pid >= 0, "Expected: fork to succeed, Received: %d", pid);
+
+    if (pid == 0) {
+      replay(&trace, which);
+      fflush(stdout);
+      _exit(0);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assertm(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Expected: replay with %s to succeed", replay_names[which]);
+  }
+
+  free(trace.records);
+  if (argc <= 1) {
+    unlink(synth_path);
+  }
+
+  printf("\nDone!\n");
+  return 0;
+}
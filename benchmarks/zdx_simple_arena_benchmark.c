@@ -0,0 +1,386 @@
+// glibc hides MAP_ANONYMOUS and clock_gettime behind feature macros when compiling with -std=c17
+#define _DEFAULT_SOURCE
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#define ZDX_SIMPLE_ARENA_IMPLEMENTATION
+#include "../zdx_simple_arena.h"
+
+// we want to use assertm for test like asserts so we
+// enable assertm by undef-ing NDEBUG if it's defined
+#ifdef NDEBUG
+#undef NDEBUG
+#include "../zdx_util.h"
+#define NDEBUG
+#endif
+
+
+static double now_secs(void)
+{
+  struct timespec ts = {0};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// ------------------------- CONCURRENT BUMP ALLOCATION -------------------------
+
+#define CONCURRENT_ALLOCS_PER_THREAD (1 << 18)
+#define CONCURRENT_MAX_THREADS 16
+
+static const size_t alloc_sizes[] = { 8, 16, 24, 32, 48, 64, 100, 128 };
+#define ALLOC_SIZES_COUNT (sizeof(alloc_sizes) / sizeof(alloc_sizes[0]))
+
+typedef struct {
+  arena_t *arena; // shared arena or the thread's own arena
+  const int *go;
+  size_t failed;
+} concurrent_worker_t;
+
+static void *concurrent_shared_worker(void *arg)
+{
+  concurrent_worker_t *worker = arg;
+
+  while (!__atomic_load_n(worker->go, __ATOMIC_ACQUIRE)) {}
+
+  for (size_t i = 0; i < CONCURRENT_ALLOCS_PER_THREAD; i++) {
+    char *ptr = arena_alloc_concurrent(worker->arena, alloc_sizes[i % ALLOC_SIZES_COUNT]);
+
+    if (!ptr) {
+      worker->failed++;
+      continue;
+    }
+    *ptr = (char)i; // touch the allocation like a real user would
+  }
+
+  return NULL;
+}
+
+static void *concurrent_own_arena_worker(void *arg)
+{
+  concurrent_worker_t *worker = arg;
+
+  while (!__atomic_load_n(worker->go, __ATOMIC_ACQUIRE)) {}
+
+  for (size_t i = 0; i < CONCURRENT_ALLOCS_PER_THREAD; i++) {
+    char *ptr = arena_alloc(worker->arena, alloc_sizes[i % ALLOC_SIZES_COUNT]);
+
+    if (!ptr) {
+      worker->failed++;
+      continue;
+    }
+    *ptr = (char)i;
+  }
+
+  return NULL;
+}
+
+static size_t concurrent_arena_size_per_thread(void)
+{
+  size_t total = 0;
+
+  for (size_t i = 0; i < ALLOC_SIZES_COUNT; i++) {
+    total += alloc_sizes[i] + SA_DEFAULT_ALIGNMENT; // worst case padding
+  }
+
+  return (total / ALLOC_SIZES_COUNT + 1) * CONCURRENT_ALLOCS_PER_THREAD;
+}
+
+static double run_concurrent(const size_t thread_count, const bool shared)
+{
+  static arena_t arenas[CONCURRENT_MAX_THREADS] = {0};
+  concurrent_worker_t workers[CONCURRENT_MAX_THREADS] = {0};
+  pthread_t threads[CONCURRENT_MAX_THREADS] = {0};
+  int go = 0;
+
+  const size_t per_thread_sz = concurrent_arena_size_per_thread();
+
+  if (shared) {
+    arenas[0] = arena_create(per_thread_sz * thread_count);
+    assertm(!arenas[0].err, "Expected: arena to be created, Received: %s", arenas[0].err);
+  }
+
+  for (size_t i = 0; i < thread_count; i++) {
+    if (!shared) {
+      arenas[i] = arena_create(per_thread_sz);
+      assertm(!arenas[i].err, "Expected: arena to be created, Received: %s", arenas[i].err);
+    }
+
+    workers[i].arena = shared ? &arenas[0] : &arenas[i];
+    workers[i].go = &go;
+    pthread_create(&threads[i], NULL, shared ? concurrent_shared_worker : concurrent_own_arena_worker, &workers[i]);
+  }
+
+  const double start = now_secs();
+  __atomic_store_n(&go, 1, __ATOMIC_RELEASE);
+
+  for (size_t i = 0; i < thread_count; i++) {
+    pthread_join(threads[i], NULL);
+    assertm(workers[i].failed == 0, "Expected: no failed allocations, Received: %zu", workers[i].failed);
+  }
+  const double elapsed = now_secs() - start;
+
+  for (size_t i = 0; i < (shared ? 1 : thread_count); i++) {
+    arena_free(&arenas[i]);
+  }
+
+  return (double)(thread_count * CONCURRENT_ALLOCS_PER_THREAD) / elapsed / 1e6;
+}
+
+static void bench_concurrent(void)
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t max_threads = cpus > 0 ? (size_t)cpus * 2 : 8;
+  max_threads = max_threads > CONCURRENT_MAX_THREADS ? CONCURRENT_MAX_THREADS : max_threads;
+
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Concurrent bump allocation, Online CPUs: %ld, Allocations per thread: %d\n", cpus, CONCURRENT_ALLOCS_PER_THREAD);
+  printf("shared = one arena_t shared by all threads via arena_alloc_concurrent()\n");
+  printf("own    = one arena_t per thread via arena_alloc() (no sharing, upper bound)\n");
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%8s | %19s | %18s | %10s\n", "threads", "shared (M allocs/s)", "own (M allocs/s)", "shared/own");
+
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    const double shared = run_concurrent(threads, true);
+    const double own = run_concurrent(threads, false);
+
+    printf("%8zu | %19.2f | %18.2f | %10.2f\n", threads, shared, own, shared / own);
+  }
+}
+
+// ------------------------- HUGE PAGES AND PRE-FAULTING -------------------------
+
+#define FAULTS_ARENA_SIZE ((size_t)256 * 1024 * 1024)
+#define FAULTS_ALLOC_SIZE 64
+
+static long minor_faults(void)
+{
+  struct rusage usage = {0};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt;
+}
+
+static const char *create_flags_str(const unsigned flags, char *const buf, const size_t buf_sz)
+{
+  snprintf(buf, buf_sz, "%s%s%s%s",
+           flags == ARENA_CREATE_DEFAULT ? "default" : "",
+           flags & ARENA_CREATE_HUGETLB ? "hugetlb " : "",
+           flags & ARENA_CREATE_THP ? "thp " : "",
+           flags & ARENA_CREATE_PREFAULT ? "prefault" : "");
+  return buf;
+}
+
+static void bench_faults(void)
+{
+  const unsigned modes[] = {
+    ARENA_CREATE_DEFAULT,
+    ARENA_CREATE_PREFAULT,
+    ARENA_CREATE_THP,
+    ARENA_CREATE_THP | ARENA_CREATE_PREFAULT,
+    ARENA_CREATE_HUGETLB,
+    ARENA_CREATE_HUGETLB | ARENA_CREATE_PREFAULT,
+  };
+  char requested[64] = {0};
+  char applied[64] = {0};
+
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Arena creation flags, Arena size: %zu MiB, Allocation size: %d bytes (each allocation is written to)\n",
+         FAULTS_ARENA_SIZE / (1024 * 1024), FAULTS_ALLOC_SIZE);
+  printf("faults = minor page faults (getrusage), fill = allocating and writing the whole arena\n");
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%-18s | %-18s | %10s | %13s | %10s | %12s | %10s\n",
+         "requested", "applied", "create ms", "create faults", "fill ms", "fill faults", "GB/s");
+
+  for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+    long faults = minor_faults();
+    double start = now_secs();
+
+    arena_t arena = arena_create_with_flags(FAULTS_ARENA_SIZE, modes[i]);
+    assertm(!arena.err, "Expected: arena to be created, Received: %s", arena.err);
+
+    const double create_secs = now_secs() - start;
+    const long create_faults = minor_faults() - faults;
+
+    faults = minor_faults();
+    start = now_secs();
+
+    size_t filled = 0;
+    for (char *ptr = arena_alloc(&arena, FAULTS_ALLOC_SIZE); ptr; ptr = arena_alloc(&arena, FAULTS_ALLOC_SIZE)) {
+      memset(ptr, (int)filled, FAULTS_ALLOC_SIZE);
+      filled += FAULTS_ALLOC_SIZE;
+    }
+
+    const double fill_secs = now_secs() - start;
+    const long fill_faults = minor_faults() - faults;
+
+    printf("%-18s | %-18s | %10.2f | %13ld | %10.2f | %12ld | %10.2f\n",
+           create_flags_str(modes[i], requested, sizeof(requested)),
+           create_flags_str(arena.create_flags, applied, sizeof(applied)),
+           create_secs * 1e3, create_faults, fill_secs * 1e3, fill_faults,
+           (double)filled / fill_secs / 1e9);
+
+    arena_free(&arena);
+  }
+}
+
+// ------------------------- REPEATED GROWTH VIA REALLOC -------------------------
+
+#define GROWTH_APPEND_SIZE 256
+#define GROWTH_APPENDS 1024
+
+typedef enum {
+  GROWTH_ARENA_LAST,        // the growing buffer is always the most recent arena allocation
+  GROWTH_ARENA_INTERLEAVED, // another allocation lands after the buffer between appends so it has to move
+  GROWTH_LIBC,
+  GROWTH_MODE_COUNT,
+} growth_mode_t;
+
+static const char *growth_mode_str[GROWTH_MODE_COUNT] = {
+  [GROWTH_ARENA_LAST] = "arena (last alloc)",
+  [GROWTH_ARENA_INTERLEAVED] = "arena (interleaved)",
+  [GROWTH_LIBC] = "libc realloc",
+};
+
+static void bench_realloc_growth(void)
+{
+  char chunk[GROWTH_APPEND_SIZE] = {0};
+  memset(chunk, 'z', sizeof(chunk));
+
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Growing one buffer by %d bytes at a time, %d times (string builder style appends)\n", GROWTH_APPEND_SIZE, GROWTH_APPENDS);
+  printf("moves = number of times realloc returned a different pointer, used = arena memory used up (buffer size for libc)\n");
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%-20s | %10s | %8s | %14s\n", "mode", "ms", "moves", "used (KiB)");
+
+  for (growth_mode_t mode = 0; mode < GROWTH_MODE_COUNT; mode++) {
+    arena_t arena = arena_create_reserved(SA_DEFAULT_RESERVE_SIZE, SA_DEFAULT_COMMIT_SIZE);
+    assertm(!arena.err, "Expected: arena to be created, Received: %s", arena.err);
+
+    char *buf = NULL;
+    size_t len = 0;
+    size_t moves = 0;
+    const double start = now_secs();
+
+    for (size_t i = 0; i < GROWTH_APPENDS; i++) {
+      char *new_buf = mode == GROWTH_LIBC
+        ? realloc(buf, len + GROWTH_APPEND_SIZE)
+        : arena_realloc(&arena, buf, len, len + GROWTH_APPEND_SIZE);
+      assertm(new_buf, "Expected: realloc to succeed, Received: NULL (%s)", arena.err);
+
+      moves += buf && new_buf != buf;
+      buf = new_buf;
+      memcpy(buf + len, chunk, GROWTH_APPEND_SIZE);
+      len += GROWTH_APPEND_SIZE;
+
+      if (mode == GROWTH_ARENA_INTERLEAVED) {
+        char *other = arena_alloc(&arena, 16);
+        assertm(other, "Expected: arena_alloc to succeed, Received: NULL (%s)", arena.err);
+        *other = 'o';
+      }
+    }
+
+    const double elapsed = now_secs() - start;
+    assertm(buf[0] == 'z' && buf[len - 1] == 'z', "Expected: 'z', Received: %c and %c", buf[0], buf[len - 1]);
+
+    printf("%-20s | %10.2f | %8zu | %14zu\n", growth_mode_str[mode], elapsed * 1e3, moves,
+           mode == GROWTH_LIBC ? len / 1024 : arena.offset / 1024);
+
+    if (mode == GROWTH_LIBC) {
+      free(buf);
+    }
+    arena_free(&arena);
+  }
+}
+
+// ------------------------- FIXED SIZE POOL VS MALLOC -------------------------
+
+#define POOL_OBJ_SIZE 48
+#define POOL_LIVE_OBJS (1 << 16)
+#define POOL_CHURN_OPS (1 << 22)
+
+static uint64_t xorshift64(uint64_t *state)
+{
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+static double run_pool_churn(const bool use_pool)
+{
+  static void *live[POOL_LIVE_OBJS] = {0};
+  arena_t arena = arena_create_growable((size_t)POOL_LIVE_OBJS * POOL_OBJ_SIZE);
+  assertm(!arena.err, "Expected: arena to be created, Received: %s", arena.err);
+  arena_pool_t pool = arena_pool_init(&arena, POOL_OBJ_SIZE, 0);
+  uint64_t rng = 0x9e3779b97f4a7c15;
+
+  const double start = now_secs();
+
+  for (size_t i = 0; i < POOL_LIVE_OBJS; i++) {
+    live[i] = use_pool ? arena_pool_alloc(&pool) : malloc(POOL_OBJ_SIZE);
+    memset(live[i], (int)i, POOL_OBJ_SIZE);
+  }
+
+  // free a random live object and allocate a replacement, like nodes churning in a container
+  for (size_t i = 0; i < POOL_CHURN_OPS; i++) {
+    size_t idx = xorshift64(&rng) % POOL_LIVE_OBJS;
+
+    if (use_pool) {
+      arena_pool_free(&pool, live[idx]);
+      live[idx] = arena_pool_alloc(&pool);
+    } else {
+      free(live[idx]);
+      live[idx] = malloc(POOL_OBJ_SIZE);
+    }
+    *(char *)live[idx] = (char)i;
+  }
+
+  // bulk release
+  if (use_pool) {
+    arena_reset(&arena);
+    arena_pool_reset(&pool);
+  } else {
+    for (size_t i = 0; i < POOL_LIVE_OBJS; i++) {
+      free(live[i]);
+    }
+  }
+
+  const double elapsed = now_secs() - start;
+  arena_free(&arena);
+
+  return elapsed;
+}
+
+static void bench_pool(void)
+{
+  printf("\n--------------------------------------------INFO--------------------------------------------\n");
+  printf("Fixed size object churn, Object size: %d bytes, Live objects: %d, Free + alloc pairs: %d\n",
+         POOL_OBJ_SIZE, POOL_LIVE_OBJS, POOL_CHURN_OPS);
+  printf("--------------------------------------------------------------------------------------------\n");
+  printf("%-20s | %10s | %14s\n", "allocator", "ms", "ns per op");
+
+  const size_t ops = POOL_LIVE_OBJS + 2 * (size_t)POOL_CHURN_OPS;
+  const double pool_secs = run_pool_churn(true);
+  const double malloc_secs = run_pool_churn(false);
+
+  printf("%-20s | %10.2f | %14.2f\n", "arena_pool_t", pool_secs * 1e3, pool_secs * 1e9 / (double)ops);
+  printf("%-20s | %10.2f | %14.2f\n", "malloc/free", malloc_secs * 1e3, malloc_secs * 1e9 / (double)ops);
+}
+
+int main(void)
+{
+  bench_concurrent();
+  bench_faults();
+  bench_realloc_growth();
+  bench_pool();
+
+  printf("\nDone!\n");
+  return 0;
+}
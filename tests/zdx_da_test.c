@@ -4,6 +4,11 @@
 #include <stdlib.h>
 #include <stdbool.h>
 
+#ifdef DA_ALLOCATOR_ENABLE
+#define ZDX_MEMORY_IMPLEMENTATION_AUTO
+#include "../zdx_memory.h"
+#endif // DA_ALLOCATOR_ENABLE
+
 #include "../zdx_da.h"
 #include "../zdx_test_utils.h"
 
@@ -16,6 +21,9 @@ typedef struct {
   size_t length;
   size_t capacity;
   ReplHistoryItem *items;
+#ifdef DA_ALLOCATOR_ENABLE
+  mem_allocator_t *allocator;
+#endif // DA_ALLOCATOR_ENABLE
 } ReplHistory;
 
 #pragma GCC diagnostic ignored "-Wmacro-redefined"
@@ -164,6 +172,55 @@ int main(void)
 
   assertm(replHistory.i == 1090, "After free(), other members of dyn array container should still work as expected");
 
+#ifdef DA_ALLOCATOR_ENABLE
+  {
+    mem_allocator_t gpa = mem_gpa_init("gpa");
+    mem_allocator_t prof = mem_prof_init("da", &gpa);
+    ReplHistory allocatorHistory = { .allocator = &prof };
+
+    for (int i = 0; i < 9; i++) {
+      da_push(&allocatorHistory, (ReplHistoryItem){ .input = "1 + 1", .output = "2" });
+    }
+
+    mem_prof_stats_t stats = mem_prof_stats(&prof);
+    assertm(allocatorHistory.length == 9, "Expected: 9, Received: %zu", allocatorHistory.length);
+    assertm(allocatorHistory.capacity == 16, "Expected: 16, Received: %zu", allocatorHistory.capacity);
+    assertm(strcmp(allocatorHistory.items[8].output, "2") == 0, "Expected: \"2\", Received: \"%s\"", allocatorHistory.items[8].output);
+    assertm(stats.live_bytes == 16 * sizeof(ReplHistoryItem),
+            "Expected: items to be allocated with the container allocator, Received: %zu live bytes", stats.live_bytes);
+
+    da_deinit(&allocatorHistory);
+
+    stats = mem_prof_stats(&prof);
+    assertm(stats.live_bytes == 0, "Expected: 0 live bytes after da_deinit, Received: %zu", stats.live_bytes);
+    assertm(stats.free_count == 1, "Expected: 1 free, Received: %zu", stats.free_count);
+    assertm(allocatorHistory.allocator == &prof, "Expected: da_deinit to keep the allocator, Received: %p",
+            (void *)allocatorHistory.allocator);
+
+    prof.deinit(&prof);
+    gpa.deinit(&gpa);
+  }
+
+  {
+    arena_t arena = arena_create(4 KB);
+    mem_allocator_t al = mem_arena_init("request", &arena);
+    ReplHistory requestHistory = { .allocator = &al };
+
+    da_push(&requestHistory, tempItem);
+    da_push(&requestHistory, tempItem);
+    da_push(&requestHistory, tempItem);
+
+    const char *base = arena.arena;
+    const char *items = (const char *)requestHistory.items;
+    assertm(items >= base && items < base + arena.offset, "Expected: items to live in the request arena, Received: %p",
+            (void *)requestHistory.items);
+
+    // the whole request is freed in bulk with the arena
+    al.deinit(&al);
+    arena_free(&arena);
+  }
+#endif // DA_ALLOCATOR_ENABLE
+
   testlog(L_INFO, "<zdx_da_test> All ok!\n");
 
   return 0;
@@ -0,0 +1,340 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../zdx_test_utils.h"
+
+#define ZDX_FAST_HASHTABLE_IMPLEMENTATION
+#define FHT_API static // fht_empty() is a C99 inline function otherwise which needs an external definition at -O0
+#define FHT_VALUE_TYPE uint32_t
+#include "../zdx_fast_hashtable.h"
+
+#ifdef FHT_NO_SIMD
+#define TEST_NAME "zdx_fast_hashtable_no_simd_test"
+#else
+#define TEST_NAME "zdx_fast_hashtable_test"
+#endif // FHT_NO_SIMD
+
+#define KEY_COUNT 2048
+
+typedef struct {
+  char key[FHT_MAX_KEYLEN + 1]; // NUL terminated as fht logs keys with %s in debug builds
+  uint8_t len;
+} test_key_t;
+
+static test_key_t keys[KEY_COUNT];
+
+static uint32_t home_index(const fht_t *const fht, const test_key_t *const key);
+static void check_keys(const fht_t *const fht, const uint8_t *const present, const uint32_t *const values, const uint32_t count);
+static void check_ctrl_mirror(const fht_t *const fht);
+
+int main(void)
+{
+  for (uint32_t i = 0; i < KEY_COUNT; i++) {
+    keys[i].len = (uint8_t)snprintf(keys[i].key, sizeof(keys[i].key), "key-%u", i);
+  }
+
+  /* fixed capacity, including ones smaller than FHT_GROUP_WIDTH where a group wraps around more than once */
+  {
+    for (uint32_t cap = 1; cap <= FHT_GROUP_WIDTH * 2 + 1; cap++) {
+      fht_t fht = fht_init(cap);
+      uint8_t present[FHT_GROUP_WIDTH * 2 + 1] = {0};
+      uint32_t values[FHT_GROUP_WIDTH * 2 + 1] = {0};
+
+      fht_ret_val_t get_ret = fht_get(&fht, keys[0].key, keys[0].len);
+      assertm(get_ret.err == FHT_ERR_HASHTABLE_EMPTY, "Expected: FHT_ERR_HASHTABLE_EMPTY, Received: %u", get_ret.err);
+
+      for (uint32_t i = 0; i < cap; i++) {
+        fht_ret_index_t add_ret = fht_add(&fht, keys[i].key, keys[i].len, i * 10);
+        assertm(add_ret.err == FHT_ERR_NONE, "Expected: add to work for cap %u, Received: %u", cap, add_ret.err);
+        present[i] = 1;
+        values[i] = i * 10;
+      }
+      check_keys(&fht, present, values, cap);
+      check_ctrl_mirror(&fht);
+
+      fht_ret_index_t add_ret = fht_add(&fht, keys[cap].key, keys[cap].len, 0);
+      assertm(add_ret.err == FHT_ERR_ADD_FAILED_OOM, "Expected: FHT_ERR_ADD_FAILED_OOM for cap %u, Received: %u", cap, add_ret.err);
+
+      /* a miss in a full table has to stop after max_dist instead of going around forever */
+      get_ret = fht_get(&fht, keys[cap].key, keys[cap].len);
+      assertm(get_ret.err == FHT_ERR_KEY_NOT_FOUND, "Expected: FHT_ERR_KEY_NOT_FOUND, Received: %u", get_ret.err);
+
+      /* removing from a full table shifts back runs that wrap around the end */
+      for (uint32_t i = 0; i < cap; i += 2) {
+        fht_ret_val_t remove_ret = fht_remove(&fht, keys[i].key, keys[i].len);
+        assertm(remove_ret.err == FHT_ERR_NONE && remove_ret.val == i * 10,
+                "Expected: %u, Received: %u (err %u)", i * 10, remove_ret.val, remove_ret.err);
+        present[i] = 0;
+      }
+      check_keys(&fht, present, values, cap);
+      check_ctrl_mirror(&fht);
+
+      fht_ret_val_t remove_ret = fht_remove(&fht, keys[0].key, keys[0].len);
+      assertm(remove_ret.err != FHT_ERR_NONE, "Expected: removing a removed key to fail, Received: %u", remove_ret.err);
+
+      /* removed keys can be added back with new values */
+      for (uint32_t i = 0; i < cap; i += 2) {
+        add_ret = fht_add(&fht, keys[i].key, keys[i].len, i + 1);
+        assertm(add_ret.err == FHT_ERR_NONE, "Expected: re-add to work for cap %u, Received: %u", cap, add_ret.err);
+        present[i] = 1;
+        values[i] = i + 1;
+      }
+      check_keys(&fht, present, values, cap);
+
+      fht_ret_index_t update_ret = fht_update(&fht, keys[cap - 1].key, keys[cap - 1].len, 42);
+      assertm(update_ret.err == FHT_ERR_NONE, "Expected: update to work, Received: %u", update_ret.err);
+      values[cap - 1] = 42;
+      update_ret = fht_update(&fht, keys[cap].key, keys[cap].len, 42);
+      assertm(update_ret.err == FHT_ERR_KEY_NOT_FOUND, "Expected: FHT_ERR_KEY_NOT_FOUND, Received: %u", update_ret.err);
+      check_keys(&fht, present, values, cap);
+
+      for (uint32_t i = 0; i < cap; i++) {
+        remove_ret = fht_remove(&fht, keys[i].key, keys[i].len);
+        assertm(remove_ret.err == FHT_ERR_NONE, "Expected: remove to work, Received: %u", remove_ret.err);
+      }
+      assertm(fht.count == 0, "Expected: 0, Received: %u", fht.count);
+      for (uint32_t i = 0; i < cap + FHT_GROUP_WIDTH; i++) {
+        assertm(fht.ctrl[i] == FHT_CTRL_EMPTY, "Expected: control byte %u to be empty for cap %u, Received: %u", i, cap, fht.ctrl[i]);
+      }
+
+      fht_deinit(&fht);
+    }
+
+    testlog(L_INFO, "[FHT FIXED CAPACITY TESTS] OK!");
+  }
+
+  /* a run of keys that hash to the last slot wraps around to the start and is shifted back across the end on remove */
+  {
+    const uint32_t cap = 8;
+    fht_t fht = fht_init(cap);
+
+    uint32_t run[3] = {0};
+    uint32_t found = 0;
+    for (uint32_t i = 0; i < KEY_COUNT && found < 3; i++) {
+      if (home_index(&fht, &keys[i]) == cap - 1) {
+        run[found++] = i;
+      }
+    }
+    assertm(found == 3, "Expected: 3 keys hashing to slot %u, Received: %u", cap - 1, found);
+
+    for (uint32_t i = 0; i < 3; i++) {
+      fht_ret_index_t add_ret = fht_add(&fht, keys[run[i]].key, keys[run[i]].len, run[i]);
+      assertm(add_ret.err == FHT_ERR_NONE, "Expected: add to work, Received: %u", add_ret.err);
+    }
+    assertm(fht.max_dist == 2, "Expected: 2, Received: %u", fht.max_dist);
+    assertm(fht.ctrl[cap - 1] != FHT_CTRL_EMPTY && fht.ctrl[0] != FHT_CTRL_EMPTY && fht.ctrl[1] != FHT_CTRL_EMPTY,
+            "Expected: slots %u, 0 and 1 to be used", cap - 1);
+    check_ctrl_mirror(&fht);
+
+    fht_ret_val_t remove_ret = fht_remove(&fht, keys[run[0]].key, keys[run[0]].len);
+    assertm(remove_ret.err == FHT_ERR_NONE && remove_ret.val == run[0], "Expected: %u, Received: %u", run[0], remove_ret.val);
+
+    /* the other two moved one slot closer to home and no tombstone is left behind */
+    assertm(fht.dists[cap - 1] == 0 && fht.dists[0] == 1, "Expected: dists 0 and 1, Received: %u and %u", fht.dists[cap - 1], fht.dists[0]);
+    assertm(fht.ctrl[1] == FHT_CTRL_EMPTY, "Expected: slot 1 to be empty, Received: %u", fht.ctrl[1]);
+    check_ctrl_mirror(&fht);
+
+    for (uint32_t i = 1; i < 3; i++) {
+      fht_ret_val_t get_ret = fht_get(&fht, keys[run[i]].key, keys[run[i]].len);
+      assertm(get_ret.err == FHT_ERR_NONE && get_ret.val == run[i], "Expected: %u, Received: %u (err %u)", run[i], get_ret.val, get_ret.err);
+    }
+
+    fht_ret_index_t add_ret = fht_add(&fht, keys[run[0]].key, keys[run[0]].len, 7);
+    assertm(add_ret.err == FHT_ERR_NONE && add_ret.index == 1, "Expected: index 1, Received: %u (err %u)", add_ret.index, add_ret.err);
+    fht_ret_val_t get_ret = fht_get(&fht, keys[run[0]].key, keys[run[0]].len);
+    assertm(get_ret.err == FHT_ERR_NONE && get_ret.val == 7, "Expected: 7, Received: %u (err %u)", get_ret.val, get_ret.err);
+
+    fht_deinit(&fht);
+
+    testlog(L_INFO, "[FHT WRAPPED RUN TESTS] OK!");
+  }
+
+  /* growable tables look up, update and remove keys in fht->old while they are still being migrated */
+  {
+    static uint8_t present[KEY_COUNT];
+    static uint32_t values[KEY_COUNT];
+    memset(present, 0, sizeof(present));
+
+    fht_t fht = fht_init_growable(4);
+    uint32_t migrations = 0;
+
+    for (uint32_t i = 0; i < KEY_COUNT; i++) {
+      fht_ret_index_t add_ret = fht_add(&fht, keys[i].key, keys[i].len, i);
+      assertm(add_ret.err == FHT_ERR_NONE, "Expected: add to work, Received: %u", add_ret.err);
+      present[i] = 1;
+      values[i] = i;
+
+      if (fht.old == NULL || fht.old->count < 2) {
+        continue;
+      }
+      migrations++;
+
+      /* a key that is still in the old table */
+      uint32_t in_old = UINT32_MAX;
+      for (uint32_t j = 0; j <= i && in_old == UINT32_MAX; j++) {
+        if (present[j] && fht_get_index_(fht.old, keys[j].key, keys[j].len, fht_hash_(&fht, keys[j].key, keys[j].len)).err == FHT_ERR_NONE) {
+          in_old = j;
+        }
+      }
+      assertm(in_old != UINT32_MAX, "Expected: a key in the old table");
+
+      fht_ret_val_t get_ret = fht_get(&fht, keys[in_old].key, keys[in_old].len);
+      assertm(get_ret.err == FHT_ERR_NONE && get_ret.val == values[in_old], "Expected: %u, Received: %u (err %u)", values[in_old], get_ret.val, get_ret.err);
+
+      fht_ret_index_t update_ret = fht_update(&fht, keys[in_old].key, keys[in_old].len, values[in_old] + 1);
+      assertm(update_ret.err == FHT_ERR_NONE, "Expected: update to work, Received: %u", update_ret.err);
+      values[in_old]++;
+
+      /* removes both from the old table and the new one */
+      if (fht.old && i % 3 == 0) {
+        fht_ret_val_t remove_ret = fht_remove(&fht, keys[in_old].key, keys[in_old].len);
+        assertm(remove_ret.err == FHT_ERR_NONE && remove_ret.val == values[in_old], "Expected: %u, Received: %u (err %u)", values[in_old], remove_ret.val, remove_ret.err);
+        present[in_old] = 0;
+
+        remove_ret = fht_remove(&fht, keys[i].key, keys[i].len);
+        assertm(remove_ret.err == FHT_ERR_NONE && remove_ret.val == i, "Expected: %u, Received: %u (err %u)", i, remove_ret.val, remove_ret.err);
+        present[i] = 0;
+
+        /* and back again */
+        add_ret = fht_add(&fht, keys[i].key, keys[i].len, i);
+        assertm(add_ret.err == FHT_ERR_NONE, "Expected: re-add to work, Received: %u", add_ret.err);
+        present[i] = 1;
+      }
+
+      check_keys(&fht, present, values, i + 1);
+    }
+    assertm(migrations > 0, "Expected: keys to be looked up mid migration");
+    assertm(fht.cap > KEY_COUNT, "Expected: cap > %u, Received: %u", KEY_COUNT, fht.cap);
+    check_keys(&fht, present, values, KEY_COUNT);
+
+    fht_deinit(&fht);
+
+    testlog(L_INFO, "[FHT GROWABLE MIGRATION TESTS] OK!");
+  }
+
+  /* fht_empty() and fht_deinit() while the old table is still being migrated */
+  {
+    static uint8_t present[KEY_COUNT];
+    static uint32_t values[KEY_COUNT];
+    memset(present, 0, sizeof(present));
+
+    fht_t fht = fht_init_growable(16);
+    uint32_t i = 0;
+    while (fht.old == NULL || fht.old->count < FHT_MIGRATE_SLOTS) {
+      fht_ret_index_t add_ret = fht_add(&fht, keys[i].key, keys[i].len, i);
+      assertm(add_ret.err == FHT_ERR_NONE, "Expected: add to work, Received: %u", add_ret.err);
+      i++;
+    }
+
+    fht_empty(&fht);
+    assertm(fht.count == 0 && fht.old == NULL && fht.max_dist == 0, "Expected: an empty table, Received: count %u, old %p", fht.count, (void *)fht.old);
+
+    fht_ret_val_t get_ret = fht_get(&fht, keys[0].key, keys[0].len);
+    assertm(get_ret.err == FHT_ERR_HASHTABLE_EMPTY, "Expected: FHT_ERR_HASHTABLE_EMPTY, Received: %u", get_ret.err);
+
+    /* still grows after being emptied */
+    const uint32_t cap = fht.cap;
+    for (i = 0; i < cap * 2; i++) {
+      fht_ret_index_t add_ret = fht_add(&fht, keys[i].key, keys[i].len, i * 3);
+      assertm(add_ret.err == FHT_ERR_NONE, "Expected: add to work, Received: %u", add_ret.err);
+      present[i] = 1;
+      values[i] = i * 3;
+    }
+    assertm(fht.cap > cap, "Expected: cap > %u, Received: %u", cap, fht.cap);
+    check_keys(&fht, present, values, cap * 2);
+
+    /* leaves nothing behind with ASan or leaks */
+    while (fht.old == NULL) {
+      fht_ret_index_t add_ret = fht_add(&fht, keys[i].key, keys[i].len, i);
+      assertm(add_ret.err == FHT_ERR_NONE, "Expected: add to work, Received: %u", add_ret.err);
+      i++;
+    }
+    fht_deinit(&fht);
+    assertm(fht.keys == NULL && fht.old == NULL, "Expected: a zeroed table after fht_deinit()");
+
+    testlog(L_INFO, "[FHT EMPTY MID MIGRATION TESTS] OK!");
+  }
+
+  /* random adds, updates and removes checked against a plain array */
+  {
+    static uint8_t present[KEY_COUNT];
+    static uint32_t values[KEY_COUNT];
+
+    srand(42);
+    for (uint8_t growable = 0; growable <= 1; growable++) {
+      const uint32_t key_count = growable ? KEY_COUNT : 97;
+      fht_t fht = growable ? fht_init_growable(2) : fht_init(key_count);
+      memset(present, 0, sizeof(present));
+
+      for (uint32_t op = 0; op < 20000; op++) {
+        const uint32_t k = (uint32_t)rand() % key_count;
+        const uint32_t val = (uint32_t)rand();
+
+        if (!present[k]) {
+          fht_ret_index_t add_ret = fht_add(&fht, keys[k].key, keys[k].len, val);
+          assertm(add_ret.err == FHT_ERR_NONE, "Expected: add to work, Received: %u", add_ret.err);
+          present[k] = 1;
+          values[k] = val;
+        } else if (rand() % 2) {
+          fht_ret_val_t remove_ret = fht_remove(&fht, keys[k].key, keys[k].len);
+          assertm(remove_ret.err == FHT_ERR_NONE && remove_ret.val == values[k], "Expected: %u, Received: %u (err %u)", values[k], remove_ret.val, remove_ret.err);
+          present[k] = 0;
+        } else {
+          fht_ret_index_t update_ret = fht_update(&fht, keys[k].key, keys[k].len, val);
+          assertm(update_ret.err == FHT_ERR_NONE, "Expected: update to work, Received: %u", update_ret.err);
+          values[k] = val;
+        }
+
+        if (op % 256 == 0) {
+          check_keys(&fht, present, values, key_count);
+          check_ctrl_mirror(&fht);
+        }
+      }
+      check_keys(&fht, present, values, key_count);
+
+      fht_deinit(&fht);
+    }
+
+    testlog(L_INFO, "[FHT RANDOM OPS TESTS] OK!");
+  }
+
+  testlog(L_INFO, "<"TEST_NAME"> All ok!\n");
+
+  return 0;
+}
+
+static uint32_t home_index(const fht_t *const fht, const test_key_t *const key)
+{
+  return fht_hash_index_(fht_hash_(fht, key->key, key->len), fht->cap);
+}
+
+/* every present key has its value, every other one is missing and count matches */
+static void check_keys(const fht_t *const fht, const uint8_t *const present, const uint32_t *const values, const uint32_t count)
+{
+  uint32_t expected_count = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    fht_ret_val_t get_ret = fht_get(fht, keys[i].key, keys[i].len);
+
+    if (present[i]) {
+      expected_count++;
+      assertm(get_ret.err == FHT_ERR_NONE && get_ret.val == values[i],
+              "Expected: %u for %s, Received: %u (err %u)", values[i], keys[i].key, get_ret.val, get_ret.err);
+    } else {
+      assertm(get_ret.err != FHT_ERR_NONE, "Expected: %s to be missing, Received: %u", keys[i].key, get_ret.val);
+    }
+  }
+
+  assertm(fht->count == expected_count, "Expected: %u, Received: %u", expected_count, fht->count);
+}
+
+/* the control bytes past the end mirror the first ones so that groups can be loaded without wrapping */
+static void check_ctrl_mirror(const fht_t *const fht)
+{
+  for (uint32_t i = 0; i < FHT_GROUP_WIDTH; i++) {
+    const uint8_t expected = fht->ctrl[i % fht->cap];
+    assertm(fht->ctrl[fht->cap + i] == expected, "Expected: %u at %u, Received: %u", expected, fht->cap + i, fht->ctrl[fht->cap + i]);
+  }
+}
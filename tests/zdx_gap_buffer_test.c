@@ -1,7 +1,13 @@
 #include "../zdx_test_utils.h"
 
+#ifdef GB_ALLOCATOR_ENABLE
+/* also brings in the implementation of zdx_simple_arena.h */
+#define ZDX_MEMORY_IMPLEMENTATION_AUTO
+#include "../zdx_memory.h"
+#else
 #define ZDX_SIMPLE_ARENA_IMPLEMENTATION
 #include "../zdx_simple_arena.h"
+#endif // GB_ALLOCATOR_ENABLE
 
 #define ZDX_FILE_IMPLEMENTATION
 #define FL_ARENA_TYPE arena_t
@@ -328,6 +334,34 @@ int main(void)
 
     gb_deinit(&gb);
   }
+
+#ifdef GB_ALLOCATOR_ENABLE
+  /* gb with a runtime allocator test */
+  {
+    mem_allocator_t gpa = mem_gpa_init("gpa");
+    mem_allocator_t prof = mem_prof_init("gb", &gpa);
+    gb_t prof_gb = { .allocator = &prof };
+
+    gb_init(&prof_gb);
+    gb_insert_cstr(&prof_gb, "hello world");
+    gb_move_cursor(&prof_gb, -5);
+    gb_insert_cstr(&prof_gb, "big wide ");
+    gb_as_cstr(&prof_gb, buf_cstr);
+    assertm(strcmp(buf_cstr, "hello big wide world") == 0, "Expected: \"hello big wide world\", Received: %s", buf_cstr);
+
+    mem_prof_stats_t stats = mem_prof_stats(&prof);
+    assertm(stats.alloc_count == 1, "Expected: gb_init to allocate with the gb allocator, Received: %zu allocs", stats.alloc_count);
+    assertm(stats.realloc_count > 0, "Expected: gap resizes to use the gb allocator, Received: %zu reallocs", stats.realloc_count);
+
+    gb_deinit(&prof_gb);
+    stats = mem_prof_stats(&prof);
+    assertm(stats.live_bytes == 0, "Expected: 0 live bytes after gb_deinit, Received: %zu", stats.live_bytes);
+    assertm(prof_gb.allocator == &prof, "Expected: gb_deinit to keep the allocator, Received: %p", (void *)prof_gb.allocator);
+
+    prof.deinit(&prof);
+    gpa.deinit(&gpa);
+  }
+#endif // GB_ALLOCATOR_ENABLE
   // ---- END GAP BUFFER TESTS ----
 
   arena_free(&arena);
@@ -2,10 +2,14 @@
 
 #include "../zdx_test_utils.h"
 
-#ifdef HT_ARENA_TYPE
+#ifdef HT_ALLOCATOR_ENABLE
+/* also brings in the implementation of zdx_simple_arena.h */
+#define ZDX_MEMORY_IMPLEMENTATION_AUTO
+#include "../zdx_memory.h"
+#elif defined(HT_ARENA_TYPE)
 #define ZDX_SIMPLE_ARENA_IMPLEMENTATION
 #include "../zdx_simple_arena.h"
-#endif // HT_ARENA_TYPE
+#endif // HT_ALLOCATOR_ENABLE
 
 typedef struct value {
   uint8_t age;
@@ -102,6 +106,45 @@ int main(void)
   assertm(ht.length == 0, "Expected: 0, Received: %zu", ht.length);
   assertm(ht.capacity == 0, "Expected: 0, Received: %zu", ht.capacity);
 
+#ifdef HT_ALLOCATOR_ENABLE
+  /* runtime allocator, takes precedence over HT_CALLOC/HT_FREE */
+  {
+    const char *keys[] = { "k0", "k1", "k2", "k3", "k4", "k5", "k6", "k7" };
+    mem_allocator_t slab = mem_slab_init("slab");
+    mem_allocator_t prof = mem_prof_init("ht", &slab);
+    ht_t prof_ht = { .allocator = &prof };
+
+    for (uint8_t i = 0; i < zdx_arr_len(keys); i++) {
+#ifdef HT_ARENA_TYPE
+      ret = ht_set(&arena, &prof_ht, keys[i], (val_t){ .age = i, .university = "ALLOCATOR UNI" });
+#else
+      ret = ht_set(&prof_ht, keys[i], (val_t){ .age = i, .university = "ALLOCATOR UNI" });
+#endif // HT_ARENA_TYPE
+      assertm(!ret.err, "Expected no error, Received: %s", ret.err);
+    }
+
+    for (uint8_t i = 0; i < zdx_arr_len(keys); i++) {
+      ret = ht_get(&prof_ht, keys[i]);
+      assertm(!ret.err, "Expected no error, Received: %s", ret.err);
+      assertm(ret.value.age == i, "Expected: %hu, Received: %hu", i, ret.value.age);
+    }
+
+    mem_prof_stats_t stats = mem_prof_stats(&prof);
+    assertm(stats.calloc_count > 1, "Expected: items to be allocated and resized with the ht allocator, Received: %zu callocs",
+            stats.calloc_count);
+    assertm(stats.live_bytes == prof_ht.capacity * sizeof(*prof_ht.items),
+            "Expected: only the current items to be live, Received: %zu live bytes", stats.live_bytes);
+
+    ht_free(&prof_ht);
+    stats = mem_prof_stats(&prof);
+    assertm(stats.live_bytes == 0, "Expected: 0 live bytes after ht_free, Received: %zu", stats.live_bytes);
+    assertm(prof_ht.allocator == &prof, "Expected: ht_free to keep the allocator, Received: %p", (void *)prof_ht.allocator);
+
+    prof.deinit(&prof);
+    slab.deinit(&slab);
+  }
+#endif // HT_ALLOCATOR_ENABLE
+
 #ifdef HT_ARENA_TYPE
   arena_free(&arena);
 #endif // HT_ARENA_TYPE
@@ -0,0 +1,690 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../zdx_test_utils.h"
+
+/* the arena implementation comes first on purpose so zdx_memory.h including it again is covered */
+#define ZDX_SIMPLE_ARENA_IMPLEMENTATION
+#include "../zdx_simple_arena.h"
+
+#define MEM_STATIC_BACKEND slab // mem_static_*() below call slab_*() directly
+#define ZDX_MEMORY_IMPLEMENTATION_AUTO
+#include "../zdx_memory.h"
+
+static void *tcache_worker(void *arg);
+
+#define TCACHE_THREADS 4
+#define TCACHE_LIVE 256
+#define TCACHE_ROUNDS 20000
+
+typedef struct {
+  mem_allocator_t *al;
+  size_t id;
+  void **handoff;      // objects allocated here and freed by the next thread
+  size_t handoff_count;
+  size_t corrupted;
+} tcache_worker_t;
+
+int main(void)
+{
+  /* GPA */
+  {
+    testlog(L_INFO, "Testing mem_gpa_init alloc/realloc/free");
+    mem_allocator_t gpa = mem_gpa_init("gpa");
+
+    int *a = gpa.alloc(&gpa, sizeof(*a) * 10);
+    assertm(a != NULL, "Expected: non-NULL, Received: %p", (void *)a);
+    for (int i = 0; i < 10; i++) a[i] = i;
+
+    a = gpa.realloc(&gpa, a, sizeof(*a) * 10, sizeof(*a) * 100);
+    assertm(a != NULL, "Expected: non-NULL, Received: %p", (void *)a);
+    assertm(a[9] == 9, "Expected: 9, Received: %d", a[9]);
+
+    gpa.free(&gpa, a);
+    gpa.deinit(&gpa);
+  }
+
+  /* SLAB - size classes */
+  {
+    testlog(L_INFO, "Testing mem_slab_init size classes and alignment");
+    mem_allocator_t slab = mem_slab_init("slab");
+    assertm(slab.ctx != NULL, "Expected: non-NULL ctx, Received: %p", slab.ctx);
+
+    const size_t sizes[] = { 1, 8, 16, 17, 33, 100, 500, 1024, 2048 };
+    void *ptrs[sizeof(sizes) / sizeof(sizes[0])] = {0};
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+      ptrs[i] = slab.alloc(&slab, sizes[i]);
+      assertm(ptrs[i] != NULL, "Expected: non-NULL for size %zu, Received: NULL", sizes[i]);
+      assertm((uintptr_t)ptrs[i] % _Alignof(max_align_t) == 0,
+              "Expected: %p to be max_align_t aligned (size %zu)", ptrs[i], sizes[i]);
+      memset(ptrs[i], (int)i, sizes[i]);
+    }
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+      const unsigned char *p = ptrs[i];
+      assertm(p[0] == i && p[sizes[i] - 1] == i,
+              "Expected: size %zu to be untouched by other allocations, Received: %d/%d",
+              sizes[i], p[0], p[sizes[i] - 1]);
+    }
+
+    // 17 and 33 round up to 32 and 64 so consecutive allocations are a class apart
+    char *a = slab.alloc(&slab, 17);
+    char *b = slab.alloc(&slab, 17);
+    assertm(b - a == 32, "Expected: 32, Received: %td", b - a);
+
+    slab.deinit(&slab);
+    assertm(slab.ctx == NULL, "Expected: NULL ctx after deinit, Received: %p", slab.ctx);
+  }
+
+  /* SLAB - free list reuse */
+  {
+    testlog(L_INFO, "Testing mem_slab_init free list reuse");
+    mem_allocator_t slab = mem_slab_init("slab");
+
+    void *a = slab.alloc(&slab, 24);
+    void *b = slab.alloc(&slab, 24);
+    slab.free(&slab, a);
+    slab.free(&slab, b);
+
+    void *c = slab.alloc(&slab, 32);
+    void *d = slab.alloc(&slab, 20);
+    assertm(c == b, "Expected: %p (LIFO reuse), Received: %p", b, c);
+    assertm(d == a, "Expected: %p (LIFO reuse), Received: %p", a, d);
+
+    // other classes don't steal from this free list
+    slab.free(&slab, c);
+    void *e = slab.alloc(&slab, 64);
+    assertm(e != c, "Expected: a 64 byte object to not reuse a 32 byte slot %p", c);
+
+    slab.free(&slab, NULL);
+    slab.deinit(&slab);
+  }
+
+  /* SLAB - many objects span several slabs */
+  {
+    testlog(L_INFO, "Testing mem_slab_init across multiple slabs");
+    mem_allocator_t slab = mem_slab_init("slab");
+
+    const size_t count = (MEM_SLAB_SIZE / 64) * 4;
+    uint64_t **objs = malloc(sizeof(*objs) * count);
+
+    for (size_t i = 0; i < count; i++) {
+      objs[i] = slab.alloc(&slab, 64);
+      assertm(objs[i] != NULL, "Expected: non-NULL, Received: NULL at %zu", i);
+      *objs[i] = i;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      assertm(*objs[i] == i, "Expected: %zu, Received: %"PRIu64, i, *objs[i]);
+    }
+
+    free(objs);
+    slab.deinit(&slab);
+  }
+
+  /* SLAB - large allocations */
+  {
+    testlog(L_INFO, "Testing mem_slab_init large allocations");
+    mem_allocator_t slab = mem_slab_init("slab");
+
+    const size_t large = MEM_SLAB_SIZE * 3;
+    char *a = slab.alloc(&slab, large);
+    char *b = slab.alloc(&slab, 4096);
+    char *c = slab.alloc(&slab, large);
+    assertm(a && b && c, "Expected: non-NULL, Received: %p, %p, %p", (void *)a, (void *)b, (void *)c);
+
+    memset(a, 'a', large);
+    memset(b, 'b', 4096);
+    memset(c, 'c', large);
+    assertm(a[large - 1] == 'a' && c[0] == 'c', "Expected: large objects to not overlap");
+
+    // unlinking from the middle, head and tail of the large list
+    slab.free(&slab, b);
+    slab.free(&slab, a);
+    slab.free(&slab, c);
+
+    slab.deinit(&slab);
+  }
+
+  /* SLAB - calloc */
+  {
+    testlog(L_INFO, "Testing mem_slab_init calloc zeroes recycled objects");
+    mem_allocator_t slab = mem_slab_init("slab");
+
+    char *a = slab.alloc(&slab, 128);
+    memset(a, 0xff, 128);
+    slab.free(&slab, a);
+
+    char *b = slab.calloc(&slab, 16, 8);
+    assertm(a == b, "Expected: %p to be recycled, Received: %p", (void *)a, (void *)b);
+    for (size_t i = 0; i < 128; i++) {
+      assertm(b[i] == 0, "Expected: 0 at %zu, Received: %d", i, b[i]);
+    }
+
+    void *overflow = slab.calloc(&slab, SIZE_MAX, 2);
+    assertm(overflow == NULL, "Expected: NULL on overflow, Received: %p", overflow);
+
+    slab.deinit(&slab);
+  }
+
+  /* SLAB - realloc */
+  {
+    testlog(L_INFO, "Testing mem_slab_init realloc");
+    mem_allocator_t slab = mem_slab_init("slab");
+
+    char *a = slab.realloc(&slab, NULL, 0, 40);
+    assertm(a != NULL, "Expected: non-NULL, Received: NULL");
+    memcpy(a, "hello", 6);
+
+    // 40 rounds up to 64 so growing to 60 stays put
+    char *b = slab.realloc(&slab, a, 40, 60);
+    assertm(a == b, "Expected: %p (in place), Received: %p", (void *)a, (void *)b);
+
+    char *c = slab.realloc(&slab, b, 60, 5000);
+    assertm(c != b, "Expected: a new object for 5000 bytes, Received: %p", (void *)c);
+    assertm(strcmp(c, "hello") == 0, "Expected: \"hello\", Received: \"%s\"", c);
+
+    // the 64 byte object went back on its free list
+    void *d = slab.alloc(&slab, 64);
+    assertm(d == b, "Expected: %p, Received: %p", (void *)b, d);
+
+    char *e = slab.realloc(&slab, c, 5000, 3 * MEM_SLAB_SIZE);
+    assertm(strcmp(e, "hello") == 0, "Expected: \"hello\", Received: \"%s\"", e);
+    slab.free(&slab, e);
+
+    slab.deinit(&slab);
+  }
+
+  /* SLAB - empty */
+  {
+    testlog(L_INFO, "Testing mem_slab_init empty rewinds slabs");
+    mem_allocator_t slab = mem_slab_init("slab");
+
+    const size_t count = (MEM_SLAB_SIZE / 32) * 2;
+    void *first = slab.alloc(&slab, 32);
+    for (size_t i = 1; i < count; i++) {
+      slab.alloc(&slab, 32);
+    }
+    void *large = slab.alloc(&slab, MEM_SLAB_SIZE * 2);
+    assertm(large != NULL, "Expected: non-NULL, Received: NULL");
+
+    slab.empty(&slab);
+
+    // slabs are retained, so the same memory gets handed out again
+    void *again = NULL;
+    for (size_t i = 0; i < count; i++) {
+      void *p = slab.alloc(&slab, 32);
+      if (p == first) again = p;
+    }
+    assertm(again == first, "Expected: %p to be reused after empty, Received: %p", first, again);
+
+    slab.empty(&slab);
+    slab.empty(&slab);
+    slab.deinit(&slab);
+  }
+
+  /* ARENA ADAPTER */
+  {
+    testlog(L_INFO, "Testing mem_arena_init forwards to the arena");
+    arena_t arena = arena_create(4 KB);
+    mem_allocator_t al = mem_arena_init("arena", &arena);
+    assertm(al.ctx != NULL, "Expected: non-NULL ctx, Received: %p", al.ctx);
+
+    char *a = al.alloc(&al, 64);
+    assertm(a == arena.arena, "Expected: %p, Received: %p", arena.arena, (void *)a);
+    size_t after_a = arena.offset;
+
+    // LIFO free hands the bytes back
+    char *b = al.alloc(&al, 64);
+    al.free(&al, b);
+    assertm(arena.offset == after_a, "Expected: %zu, Received: %zu", after_a, arena.offset);
+
+    // only the most recent allocation can be freed, anything else is a no-op
+    b = al.alloc(&al, 64);
+    size_t after_b = arena.offset;
+    al.free(&al, a);
+    assertm(arena.offset == after_b, "Expected: %zu, Received: %zu", after_b, arena.offset);
+
+    // realloc of the most recent allocation grows in place
+    memcpy(b, "hello", 6);
+    char *c = al.realloc(&al, b, 64, 256);
+    assertm(c == b, "Expected: %p (in place), Received: %p", (void *)b, (void *)c);
+    assertm(strcmp(c, "hello") == 0, "Expected: \"hello\", Received: \"%s\"", c);
+    al.free(&al, c);
+    assertm(arena.offset == after_a, "Expected: %zu, Received: %zu", after_a, arena.offset);
+
+    int *d = al.calloc(&al, 4, sizeof(*d));
+    assertm(d != NULL, "Expected: non-NULL, Received: NULL");
+
+    void *too_big = al.alloc(&al, 8 KB);
+    assertm(too_big == NULL, "Expected: NULL, Received: %p", too_big);
+    assertm(arena.err != NULL, "Expected: arena err to be set, Received: NULL");
+
+    al.empty(&al);
+    assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+    // free after empty must not touch the arena
+    al.free(&al, d);
+    assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+
+    al.deinit(&al);
+    assertm(al.ctx == NULL, "Expected: NULL ctx after deinit, Received: %p", al.ctx);
+    assertm(arena.arena != NULL, "Expected: arena to outlive the adapter");
+    arena_free(&arena);
+  }
+
+  /* TCACHE - single thread */
+  {
+    testlog(L_INFO, "Testing mem_tcache_init on a single thread");
+    mem_allocator_t tc = mem_tcache_init("tcache");
+    assertm(tc.ctx != NULL, "Expected: non-NULL ctx, Received: %p", tc.ctx);
+
+    void *a = tc.alloc(&tc, 24);
+    void *b = tc.alloc(&tc, 24);
+    assertm(a && b && a != b, "Expected: two distinct objects, Received: %p, %p", a, b);
+    assertm((uintptr_t)a % _Alignof(max_align_t) == 0, "Expected: %p to be max_align_t aligned", a);
+
+    // freed objects come back out of the thread cache first
+    tc.free(&tc, a);
+    void *c = tc.alloc(&tc, 32);
+    assertm(c == a, "Expected: %p, Received: %p", a, c);
+
+    // more frees than a cache holds drain back to the depot and get handed out again
+    void *many[MEM_TCACHE_MAX * 2] = {0};
+    for (size_t i = 0; i < MEM_TCACHE_MAX * 2; i++) {
+      many[i] = tc.alloc(&tc, 100);
+      assertm(many[i] != NULL, "Expected: non-NULL, Received: NULL at %zu", i);
+      memset(many[i], (int)i, 100);
+    }
+    for (size_t i = 0; i < MEM_TCACHE_MAX * 2; i++) {
+      tc.free(&tc, many[i]);
+    }
+    for (size_t i = 0; i < MEM_TCACHE_MAX * 2; i++) {
+      many[i] = tc.alloc(&tc, 100);
+      assertm(many[i] != NULL, "Expected: non-NULL, Received: NULL at %zu", i);
+    }
+
+    int *z = tc.calloc(&tc, 8, sizeof(*z));
+    for (size_t i = 0; i < 8; i++) {
+      assertm(z[i] == 0, "Expected: 0 at %zu, Received: %d", i, z[i]);
+    }
+
+    char *d = tc.realloc(&tc, NULL, 0, 10);
+    memcpy(d, "hello", 6);
+    char *e = tc.realloc(&tc, d, 10, 16);
+    assertm(d == e, "Expected: %p (in place), Received: %p", (void *)d, (void *)e);
+    char *f = tc.realloc(&tc, e, 16, MEM_SLAB_SIZE * 2);
+    assertm(strcmp(f, "hello") == 0, "Expected: \"hello\", Received: \"%s\"", f);
+    tc.free(&tc, f);
+
+    tc.empty(&tc);
+    void *g = tc.alloc(&tc, 24);
+    assertm(g != NULL, "Expected: non-NULL after empty, Received: NULL");
+
+    tc.deinit(&tc);
+    assertm(tc.ctx == NULL, "Expected: NULL ctx after deinit, Received: %p", tc.ctx);
+  }
+
+  /* TCACHE - many threads */
+  {
+    testlog(L_INFO, "Testing mem_tcache_init with %d threads and cross thread frees", TCACHE_THREADS);
+    mem_allocator_t tc = mem_tcache_init("tcache");
+
+    pthread_t threads[TCACHE_THREADS] = {0};
+    tcache_worker_t workers[TCACHE_THREADS] = {0};
+    void *handoffs[TCACHE_THREADS][TCACHE_LIVE] = {0};
+
+    for (size_t i = 0; i < TCACHE_THREADS; i++) {
+      workers[i] = (tcache_worker_t){ .al = &tc, .id = i + 1, .handoff = handoffs[i] };
+      pthread_create(&threads[i], NULL, tcache_worker, &workers[i]);
+    }
+    for (size_t i = 0; i < TCACHE_THREADS; i++) {
+      pthread_join(threads[i], NULL);
+      assertm(workers[i].corrupted == 0, "Expected: no object handed to two threads at once, Received: %zu",
+              workers[i].corrupted);
+    }
+
+    // free every thread's leftovers from another thread (this one), after the owners have exited
+    for (size_t i = 0; i < TCACHE_THREADS; i++) {
+      for (size_t j = 0; j < workers[i].handoff_count; j++) {
+        size_t *obj = workers[i].handoff[j];
+        assertm(*obj == workers[i].id, "Expected: %zu, Received: %zu", workers[i].id, *obj);
+        tc.free(&tc, obj);
+      }
+    }
+
+    tc.deinit(&tc);
+  }
+
+  /* PROF */
+  {
+    testlog(L_INFO, "Testing mem_prof_init counters and histogram");
+    mem_allocator_t slab = mem_slab_init("slab");
+    mem_allocator_t prof = mem_prof_init("prof", &slab);
+    assertm(prof.ctx != NULL, "Expected: non-NULL ctx, Received: %p", prof.ctx);
+
+    char *a = prof.alloc(&prof, 100);
+    char *b = prof.calloc(&prof, 10, 10);
+    assertm(a && b, "Expected: non-NULL, Received: %p, %p", (void *)a, (void *)b);
+    assertm((uintptr_t)a % _Alignof(max_align_t) == 0, "Expected: %p to be max_align_t aligned", (void *)a);
+    assertm(b[99] == 0, "Expected: 0, Received: %d", b[99]);
+
+    mem_prof_stats_t stats = mem_prof_stats(&prof);
+    assertm(stats.live_bytes == 200, "Expected: 200, Received: %zu", stats.live_bytes);
+    assertm(stats.alloc_count == 1 && stats.calloc_count == 1, "Expected: 1/1, Received: %zu/%zu",
+            stats.alloc_count, stats.calloc_count);
+    // 100 has 7 significant bits
+    assertm(stats.histogram[7] == 2, "Expected: 2, Received: %zu", stats.histogram[7]);
+
+    memcpy(a, "hello", 6);
+    a = prof.realloc(&prof, a, 100, 300);
+    assertm(strcmp(a, "hello") == 0, "Expected: \"hello\", Received: \"%s\"", a);
+    stats = mem_prof_stats(&prof);
+    assertm(stats.live_bytes == 400, "Expected: 400, Received: %zu", stats.live_bytes);
+    assertm(stats.total_bytes == 400, "Expected: 400, Received: %zu", stats.total_bytes);
+
+    prof.free(&prof, a);
+    prof.free(&prof, NULL);
+    stats = mem_prof_stats(&prof);
+    assertm(stats.live_bytes == 100, "Expected: 100, Received: %zu", stats.live_bytes);
+    assertm(stats.peak_bytes == 400, "Expected: 400, Received: %zu", stats.peak_bytes);
+    assertm(stats.free_count == 1, "Expected: 1, Received: %zu", stats.free_count);
+
+    prof.empty(&prof);
+    stats = mem_prof_stats(&prof);
+    assertm(stats.live_bytes == 0, "Expected: 0, Received: %zu", stats.live_bytes);
+    assertm(stats.empty_count == 1, "Expected: 1, Received: %zu", stats.empty_count);
+
+    prof.deinit(&prof);
+    slab.deinit(&slab);
+  }
+
+  {
+    testlog(L_INFO, "Testing mem_prof_init call sites");
+    mem_allocator_t gpa = mem_gpa_init("gpa");
+    mem_allocator_t prof = mem_prof_init("prof", &gpa);
+
+    void *ptrs[10] = {0};
+    for (size_t i = 0; i < 10; i++) {
+      ptrs[i] = mem_alloc(&prof, 32);
+    }
+    const int alloc_line = __LINE__ - 2;
+
+    char *r = mem_realloc(&prof, NULL, 0, 16);
+    r = prof.realloc(&prof, r, 16, 64); // no call site, stays attributed to the line above
+    const int realloc_line = __LINE__ - 2;
+
+    for (size_t i = 0; i < 10; i++) {
+      mem_free(&prof, ptrs[i]);
+    }
+
+    const mem_prof_ctx_t *ctx = prof.ctx;
+    const mem_prof_site_t *alloc_site = NULL;
+    const mem_prof_site_t *realloc_site = NULL;
+    for (size_t i = 0; i < MEM_PROF_MAX_SITES; i++) {
+      if (ctx->sites[i].line == alloc_line) alloc_site = &ctx->sites[i];
+      if (ctx->sites[i].line == realloc_line) realloc_site = &ctx->sites[i];
+    }
+
+    assertm(alloc_site != NULL, "Expected: a call site for line %d, Received: NULL", alloc_line);
+    assertm(alloc_site->alloc_count == 10, "Expected: 10, Received: %zu", alloc_site->alloc_count);
+    assertm(alloc_site->total_bytes == 320, "Expected: 320, Received: %zu", alloc_site->total_bytes);
+    assertm(alloc_site->live_bytes == 0, "Expected: 0, Received: %zu", alloc_site->live_bytes);
+    assertm(alloc_site->peak_bytes == 320, "Expected: 320, Received: %zu", alloc_site->peak_bytes);
+
+    assertm(realloc_site != NULL, "Expected: a call site for line %d, Received: NULL", realloc_line);
+    assertm(realloc_site->live_bytes == 64, "Expected: 64, Received: %zu", realloc_site->live_bytes);
+    assertm(realloc_site->total_bytes == 64, "Expected: 64, Received: %zu", realloc_site->total_bytes);
+
+    FILE *devnull = fopen("/dev/null", "w");
+    mem_prof_dump(&prof, devnull);
+    fclose(devnull);
+
+    mem_free(&prof, r);
+    prof.deinit(&prof);
+    gpa.deinit(&gpa);
+  }
+
+  /* STATIC BINDING */
+  {
+    testlog(L_INFO, "Testing mem_static_* with MEM_STATIC_BACKEND slab");
+    mem_allocator_t slab = mem_slab_init("slab");
+
+    char *a = mem_static_alloc(&slab, 40);
+    assertm(a != NULL, "Expected: non-NULL, Received: NULL");
+    memcpy(a, "hello", 6);
+
+    char *b = mem_static_realloc(&slab, a, 40, 60);
+    assertm(a == b, "Expected: %p (in place), Received: %p", (void *)a, (void *)b);
+
+    // same allocator through the vtable sees the same state
+    mem_static_free(&slab, b);
+    void *c = slab.alloc(&slab, 64);
+    assertm(c == b, "Expected: %p, Received: %p", (void *)b, c);
+
+    int *z = mem_static_calloc(&slab, 4, sizeof(*z));
+    assertm(z[3] == 0, "Expected: 0, Received: %d", z[3]);
+
+    mem_static_empty(&slab);
+    void *d = mem_static_alloc(&slab, 64);
+    assertm(d == c, "Expected: %p after empty, Received: %p", c, d);
+
+    slab.deinit(&slab);
+  }
+
+  /* TRACE */
+  {
+    testlog(L_INFO, "Testing mem_trace_init records every call");
+    char path[] = "/tmp/zdx_memory_test_trace_XXXXXX";
+    int fd = mkstemp(path);
+    assertm(fd >= 0, "Expected: temp file to be created, Received: %d", fd);
+    close(fd);
+
+    mem_allocator_t gpa = mem_gpa_init("gpa");
+    mem_allocator_t trace = mem_trace_init("trace", &gpa, path);
+    assertm(trace.ctx != NULL, "Expected: non-NULL ctx, Received: %p", trace.ctx);
+
+    char *a = trace.alloc(&trace, 10);
+    int *b = trace.calloc(&trace, 4, sizeof(*b));
+    assertm(b[3] == 0, "Expected: 0, Received: %d", b[3]);
+    memcpy(a, "hello", 6);
+    a = trace.realloc(&trace, a, 10, 100);
+    assertm(strcmp(a, "hello") == 0, "Expected: \"hello\", Received: \"%s\"", a);
+    trace.free(&trace, b);
+    trace.free(&trace, NULL);
+    trace.free(&trace, a);
+    trace.empty(&trace);
+    trace.deinit(&trace);
+
+    mem_allocator_t bad = mem_trace_init("trace", &gpa, "/nonexistent/dir/trace");
+    assertm(bad.ctx == NULL, "Expected: NULL ctx for an unwritable path, Received: %p", bad.ctx);
+    gpa.deinit(&gpa);
+
+    FILE *file = fopen(path, "rb");
+    mem_trace_header_t header = {0};
+    assertm(fread(&header, sizeof(header), 1, file) == 1, "Expected: trace header to be readable");
+    assertm(memcmp(header.magic, MEM_TRACE_MAGIC, sizeof(header.magic)) == 0, "Expected: trace magic to match");
+    assertm(header.version == MEM_TRACE_VERSION, "Expected: %d, Received: %u", MEM_TRACE_VERSION, header.version);
+    assertm(header.record_size == sizeof(mem_trace_record_t), "Expected: %zu, Received: %u",
+            sizeof(mem_trace_record_t), header.record_size);
+
+    const mem_trace_record_t expected[] = {
+      { .op = MEM_TRACE_ALLOC, .id = 1, .size = 10 },
+      { .op = MEM_TRACE_CALLOC, .id = 2, .size = 4 * sizeof(int) },
+      { .op = MEM_TRACE_REALLOC, .id = 1, .size = 100 },
+      { .op = MEM_TRACE_FREE, .id = 2, .size = 0 },
+      { .op = MEM_TRACE_FREE, .id = 1, .size = 0 },
+      { .op = MEM_TRACE_EMPTY, .id = 0, .size = 0 },
+    };
+
+    mem_trace_record_t record = {0};
+    uint64_t prev_ns = 0;
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+      assertm(fread(&record, sizeof(record), 1, file) == 1, "Expected: record %zu to be readable", i);
+      assertm(record.op == expected[i].op && record.id == expected[i].id && record.size == expected[i].size,
+              "Expected: op %u id %u size %"PRIu64", Received: op %u id %u size %"PRIu64" (record %zu)",
+              expected[i].op, expected[i].id, expected[i].size, record.op, record.id, record.size, i);
+      assertm(record.ns >= prev_ns, "Expected: timestamps to not go backwards at record %zu", i);
+      prev_ns = record.ns;
+    }
+    assertm(fread(&record, sizeof(record), 1, file) == 0, "Expected: no more records");
+
+    fclose(file);
+    unlink(path);
+  }
+
+  /* BUDDY - split and coalesce */
+  {
+    testlog(L_INFO, "Testing mem_buddy_init splits and coalesces blocks");
+    mem_allocator_t buddy = mem_buddy_init("buddy", 1000);
+    assertm(buddy.ctx != NULL, "Expected: non-NULL ctx, Received: %p", buddy.ctx);
+
+    mem_buddy_stats_t stats = mem_buddy_stats(&buddy);
+    assertm(stats.capacity == 1024, "Expected: 1000 to round up to 1024, Received: %zu", stats.capacity);
+    assertm(stats.free_blocks == 1 && stats.largest_free == 1024,
+            "Expected: 1 free block of 1024, Received: %zu of %zu", stats.free_blocks, stats.largest_free);
+
+    // 1024 splits into 512 + 256 + 128 + 64 + 32 + 16 + the 16 handed out
+    char *a = buddy.alloc(&buddy, 1);
+    stats = mem_buddy_stats(&buddy);
+    assertm(stats.allocated_bytes == 16, "Expected: 16, Received: %zu", stats.allocated_bytes);
+    assertm(stats.free_blocks == 6 && stats.largest_free == 512,
+            "Expected: 6 free blocks up to 512, Received: %zu up to %zu", stats.free_blocks, stats.largest_free);
+
+    char *b = buddy.alloc(&buddy, 100);
+    assertm((size_t)(b - a) % 128 == 0, "Expected: 128 byte block aligned to 128, Received: offset %td", b - a);
+    memset(a, 'a', 16);
+    memset(b, 'b', 128);
+
+    buddy.free(&buddy, a);
+    buddy.free(&buddy, b);
+    stats = mem_buddy_stats(&buddy);
+    assertm(stats.allocated_bytes == 0, "Expected: 0, Received: %zu", stats.allocated_bytes);
+    assertm(stats.free_blocks == 1 && stats.largest_free == 1024,
+            "Expected: everything to merge into 1024, Received: %zu up to %zu", stats.free_blocks, stats.largest_free);
+    assertm(stats.alloc_count == 2 && stats.free_count == 2, "Expected: 2 allocs and 2 frees, Received: %zu and %zu",
+            stats.alloc_count, stats.free_count);
+
+    buddy.free(&buddy, NULL);
+    buddy.deinit(&buddy);
+    assertm(buddy.ctx == NULL, "Expected: NULL ctx after deinit, Received: %p", buddy.ctx);
+  }
+
+  /* BUDDY - exhaustion and fragmentation */
+  {
+    testlog(L_INFO, "Testing mem_buddy_init exhaustion and fragmentation");
+    mem_allocator_t buddy = mem_buddy_init("buddy", 1024);
+
+    char *blocks[4] = {0};
+    for (size_t i = 0; i < 4; i++) {
+      blocks[i] = buddy.alloc(&buddy, 256);
+      assertm(blocks[i] != NULL, "Expected: block %zu to fit, Received: NULL", i);
+    }
+
+    void *none = buddy.alloc(&buddy, 16);
+    assertm(none == NULL, "Expected: NULL once the region is used up, Received: %p", none);
+    none = buddy.alloc(&buddy, 2048);
+    assertm(none == NULL, "Expected: NULL for more than the region, Received: %p", none);
+
+    // the 2 middle blocks aren't buddies of each other so 512 bytes are free but not in one piece
+    buddy.free(&buddy, blocks[1]);
+    buddy.free(&buddy, blocks[2]);
+    mem_buddy_stats_t stats = mem_buddy_stats(&buddy);
+    assertm(stats.free_bytes == 512 && stats.largest_free == 256,
+            "Expected: 512 free bytes in 256 byte blocks, Received: %zu in %zu", stats.free_bytes, stats.largest_free);
+    none = buddy.alloc(&buddy, 512);
+    assertm(none == NULL, "Expected: NULL for 512 bytes, Received: %p", none);
+    stats = mem_buddy_stats(&buddy);
+    assertm(stats.failed_count == 3, "Expected: 3 failed, Received: %zu", stats.failed_count);
+
+    buddy.free(&buddy, blocks[0]);
+    stats = mem_buddy_stats(&buddy);
+    assertm(stats.largest_free == 512, "Expected: 512 after freeing its buddy, Received: %zu", stats.largest_free);
+
+    char *big = buddy.alloc(&buddy, 512);
+    assertm(big == blocks[0], "Expected: %p, Received: %p", (void *)blocks[0], (void *)big);
+
+    buddy.deinit(&buddy);
+  }
+
+  /* BUDDY - realloc, calloc and empty */
+  {
+    testlog(L_INFO, "Testing mem_buddy_init realloc, calloc and empty");
+    mem_allocator_t buddy = mem_buddy_init("buddy", 4096);
+
+    char *a = buddy.realloc(&buddy, NULL, 0, 10);
+    memcpy(a, "hello", 6);
+
+    // the free buddies right after a are merged into it
+    char *b = buddy.realloc(&buddy, a, 10, 64);
+    assertm(a == b, "Expected: %p (grown in place), Received: %p", (void *)a, (void *)b);
+
+    char *c = buddy.alloc(&buddy, 16);
+    assertm(c == a + 64, "Expected: %p, Received: %p", (void *)(a + 64), (void *)c);
+
+    // the next 64 bytes are no longer whole so b has to move
+    char *d = buddy.realloc(&buddy, b, 64, 128);
+    assertm(d != b, "Expected: a new block for 128 bytes, Received: %p", (void *)d);
+    assertm(strcmp(d, "hello") == 0, "Expected: \"hello\", Received: \"%s\"", d);
+
+    memset(d, 0xff, 128);
+    buddy.free(&buddy, d);
+    unsigned char *e = buddy.calloc(&buddy, 32, 4);
+    assertm((void *)e == (void *)d, "Expected: %p to be recycled, Received: %p", (void *)d, (void *)e);
+    for (size_t i = 0; i < 128; i++) {
+      assertm(e[i] == 0, "Expected: 0 at %zu, Received: %d", i, e[i]);
+    }
+    void *overflow = buddy.calloc(&buddy, SIZE_MAX, 2);
+    assertm(overflow == NULL, "Expected: NULL on overflow, Received: %p", overflow);
+
+    buddy.empty(&buddy);
+    mem_buddy_stats_t stats = mem_buddy_stats(&buddy);
+    assertm(stats.allocated_bytes == 0 && stats.largest_free == 4096,
+            "Expected: empty region, Received: %zu allocated, %zu free", stats.allocated_bytes, stats.largest_free);
+    char *f = buddy.alloc(&buddy, 4096);
+    assertm(f == a, "Expected: the whole region at %p, Received: %p", (void *)a, (void *)f);
+
+    buddy.deinit(&buddy);
+
+    mem_allocator_t huge = mem_buddy_init("huge", SIZE_MAX);
+    assertm(huge.ctx == NULL, "Expected: NULL ctx for a region that can't be rounded up, Received: %p", huge.ctx);
+    huge.deinit(&huge);
+  }
+
+  testlog(L_INFO, "<zdx_memory_test> All ok!\n");
+  return 0;
+}
+
+static void *tcache_worker(void *arg)
+{
+  tcache_worker_t *worker = arg;
+  mem_allocator_t *al = worker->al;
+  size_t *live[TCACHE_LIVE] = {0};
+
+  for (size_t round = 0; round < TCACHE_ROUNDS; round++) {
+    size_t idx = round % TCACHE_LIVE;
+
+    if (live[idx]) {
+      // another thread writing to this object means it was handed out twice
+      if (live[idx][0] != worker->id || live[idx][1] != round - TCACHE_LIVE) {
+        worker->corrupted++;
+      }
+      al->free(al, live[idx]);
+    }
+
+    live[idx] = al->alloc(al, sizeof(size_t) * (2 + round % 16));
+    live[idx][0] = worker->id;
+    live[idx][1] = round;
+  }
+
+  // leave the objects for the main thread to free
+  for (size_t i = 0; i < TCACHE_LIVE; i++) {
+    worker->handoff[worker->handoff_count++] = live[i];
+  }
+
+  return NULL;
+}
@@ -6,14 +6,32 @@
 #include <stdint.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 #include "../zdx_test_utils.h"
 
 #define SA_DEFAULT_ALIGNMENT 8 // to make sure tests work as expected across platforms
+#define SA_STATS_ENABLE
 #define ZDX_SIMPLE_ARENA_IMPLEMENTATION
 #include "../zdx_simple_arena.h"
 
 static void test_arena_alloc(arena_t *const arena, const size_t sz, const size_t expected_offset, const size_t expected_alignment);
+static void *concurrent_alloc_worker(void *arg);
+static void *scratch_worker(void *arg);
+static size_t resident_pages(void *const addr, const size_t len);
+
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_ALLOCS 10000
+#define CONCURRENT_ALLOC_SIZE 24
+
+typedef struct {
+  arena_t *arena;
+  uint8_t id;
+  uint8_t *ptrs[CONCURRENT_ALLOCS];
+} concurrent_worker_t;
 
 int main(void)
 {
@@ -26,7 +44,7 @@ int main(void)
       assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
       assertm(arena.arena != NULL, "Expected: non-NULL arena addr, Received: %p", arena.arena);
 
-      size_t expected_arena_size = arena_round_up_to_page_size_(requested_arena_size);
+      size_t expected_arena_size = arena_round_up_to_page_size_(requested_arena_size, arena_page_size_());
       assertm(arena.size == expected_arena_size, "Expected: %ld, Received: %zu", expected_arena_size, arena.size);
       assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
 
@@ -58,7 +76,7 @@ int main(void)
       assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
       assertm(arena.arena != NULL, "Expected: non-NULL arena addr, Received: %p", arena.arena);
 
-      size_t expected_arena_size = arena_round_up_to_page_size_(requested_arena_size);
+      size_t expected_arena_size = arena_round_up_to_page_size_(requested_arena_size, arena_page_size_());
       assertm(arena.size == expected_arena_size, "Expected: %ld, Received: %zu", expected_arena_size, arena.size);
       assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
 
@@ -73,6 +91,52 @@ int main(void)
       testlog(L_INFO, "[ARENA CREATE DEBUG PATH TESTS] OK!");
     }
 #endif
+
+    {
+      const unsigned modes[] = {
+        ARENA_CREATE_DEFAULT,
+        ARENA_CREATE_PREFAULT,
+        ARENA_CREATE_THP,
+        ARENA_CREATE_THP | ARENA_CREATE_PREFAULT,
+        ARENA_CREATE_HUGETLB,
+        ARENA_CREATE_HUGETLB | ARENA_CREATE_PREFAULT,
+      };
+
+      for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        arena_t arena = arena_create_with_flags(requested_arena_size, modes[i]);
+        assertm(!arena.err, "Expected: valid arena to be created for flags %u, Received: %s -> %s", modes[i], arena.err, strerror(errno));
+        assertm(arena.arena != NULL, "Expected: non-NULL arena addr, Received: %p", arena.arena);
+        assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+
+        /* huge pages are best effort but we never get something we didn't ask for, except THP as the HUGETLB fallback */
+        unsigned allowed = modes[i] & ARENA_CREATE_HUGETLB ? modes[i] | ARENA_CREATE_THP : modes[i];
+        assertm((arena.create_flags & ~allowed) == 0, "Expected: flags to be a subset of %u, Received: %u", allowed, arena.create_flags);
+        assertm((arena.create_flags & ARENA_CREATE_PREFAULT) == (modes[i] & ARENA_CREATE_PREFAULT),
+                "Expected: prefault to always be honoured, Received: %u", arena.create_flags);
+
+        size_t page_size = modes[i] & (ARENA_CREATE_THP | ARENA_CREATE_HUGETLB) ? SA_HUGE_PAGE_SIZE : arena_page_size_();
+        size_t expected_arena_size = arena_round_up_to_page_size_(requested_arena_size, page_size);
+        assertm(arena.size == expected_arena_size, "Expected: %zu, Received: %zu", expected_arena_size, arena.size);
+
+        if (arena.create_flags & (ARENA_CREATE_THP | ARENA_CREATE_HUGETLB)) {
+          assertm((uintptr_t)arena.arena % SA_HUGE_PAGE_SIZE == 0, "Expected: huge page aligned arena, Received: %p", arena.arena);
+        }
+
+        char *c = arena_alloc(&arena, arena.size);
+        assertm(c != NULL && !arena.err, "Expected: the whole arena to be usable, Received: %s", arena.err);
+        memset(c, 'a', arena.size);
+
+        assertm(arena_free(&arena) && !arena.err,
+                "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+      }
+
+      arena_t arena = arena_create_with_flags(0, ARENA_CREATE_PREFAULT);
+      assertm(arena.err, "Expected: arena creation to fail, Received: valid arena");
+      assertm(arena.arena == NULL, "Expected: NULL as arena base addr, Received: %p", arena.arena);
+      assertm(arena.create_flags == 0, "Expected: 0, Received: %u", arena.create_flags);
+
+      testlog(L_INFO, "[ARENA CREATE WITH FLAGS TESTS] OK!");
+    }
   }
 
   /* arena_free */
@@ -356,6 +420,141 @@ int main(void)
     }
   }
 
+  /* arena_alloc_aligned and arena_calloc_aligned */
+  {
+    {
+      arena_t arena = arena_create(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      /* small objects are packed without max_align_t padding */
+      char *a = arena_alloc_type(&arena, char);
+      char *b = arena_alloc_type(&arena, char);
+      char *c = arena_alloc_array(&arena, char, 3);
+      uint16_t *d = arena_alloc_array(&arena, uint16_t, 2);
+      assertm(b == a + 1 && c == b + 1, "Expected: %p and %p, Received: %p and %p", (void *)(a + 1), (void *)(a + 2), (void *)b, (void *)c);
+      assertm((uintptr_t)d == (uintptr_t)(c + 4), "Expected: %p, Received: %p", (void *)(c + 4), (void *)d);
+      assertm(arena.offset == 10, "Expected: 10, Received: %zu", arena.offset);
+
+      uint64_t *e = arena_calloc_array(&arena, uint64_t, 4);
+      assertm(e != NULL && (uintptr_t)e % _Alignof(uint64_t) == 0, "Expected: aligned ptr, Received: %p", (void *)e);
+      for (size_t i = 0; i < 4; i++) {
+        assertm(e[i] == 0, "Expected: 0, Received: %" PRIu64, e[i]);
+      }
+
+      int *f = arena_calloc_aligned(&arena, 16, sizeof(int), 64);
+      assertm(f != NULL && (uintptr_t)f % 64 == 0, "Expected: 64 byte aligned ptr, Received: %p", (void *)f);
+      for (size_t i = 0; i < 16; i++) {
+        assertm(f[i] == 0, "Expected: 0, Received: %d", f[i]);
+      }
+
+      arena_reset(&arena);
+
+      const size_t alignments[] = { 1, 2, 32, 64, 128, 4096 };
+
+      for (size_t i = 0; i < sizeof(alignments) / sizeof(alignments[0]); i++) {
+        /* misalign the offset first */
+        arena_alloc_aligned(&arena, 1, 1);
+
+        c = arena_alloc_aligned(&arena, 24, alignments[i]);
+        assertm(c != NULL && !arena.err, "Expected: arena_alloc_aligned to succeed, Received: %s", arena.err);
+        assertm((uintptr_t)c % alignments[i] == 0, "Expected: %p to be aligned to %zu", (void *)c, alignments[i]);
+        memset(c, 'a', 24);
+      }
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* growable arenas keep the alignment in new blocks */
+      arena = arena_create_growable(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      arena_alloc(&arena, arena.size - 8);
+      c = arena_alloc_aligned(&arena, 100, 256);
+      assertm(c != NULL && !arena.err, "Expected: arena_alloc_aligned to succeed by growing, Received: %s", arena.err);
+      assertm((uintptr_t)c % 256 == 0, "Expected: %p to be aligned to 256", (void *)c);
+      assertm(arena.curr_block_ != arena.first_block_, "Expected: a new block, Received: %p", (void *)arena.curr_block_);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA ALLOC ALIGNED HAPPY PATH TESTS] OK!");
+    }
+
+    {
+      arena_t arena = arena_create(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      void *c = arena_alloc_aligned(&arena, 8, 0);
+      assertm(c == NULL && arena.err, "Expected: arena_alloc_aligned to fail for alignment 0, Received: %p", c);
+
+      c = arena_alloc_aligned(&arena, 8, 24);
+      assertm(c == NULL && arena.err, "Expected: arena_alloc_aligned to fail for alignment 24, Received: %p", c);
+
+      c = arena_calloc_aligned(&arena, 2, 8, 3);
+      assertm(c == NULL && arena.err, "Expected: arena_calloc_aligned to fail for alignment 3, Received: %p", c);
+
+      c = arena_alloc_aligned(&arena, 0, 8);
+      assertm(c == NULL && arena.err, "Expected: arena_alloc_aligned to fail for size 0, Received: %p", c);
+
+      /* padding for the alignment has to fit as well */
+      arena_alloc(&arena, 1);
+      c = arena_alloc_aligned(&arena, arena.size - 64, 128);
+      assertm(c == NULL && arena.err, "Expected: arena_alloc_aligned to fail as padding doesn't fit, Received: %p", c);
+      assertm(arena.offset == 1, "Expected: 1, Received: %zu", arena.offset);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* padding alone running past the end of the arena must not wrap the remaining size */
+      uint8_t buf[64];
+      arena = arena_create_from_buf(buf + 1, 10);
+      assertm(!arena.err, "Expected: arena from buf to be created, Received: %s", arena.err);
+
+      c = arena_alloc_aligned(&arena, 1, 64);
+      assertm(c == NULL && arena.err, "Expected: arena_alloc_aligned to fail as padding is past the end, Received: %p", c);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+
+      arena = arena_create(4096);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      c = arena_alloc_aligned(&arena, 1, 1 << 24);
+      assertm(c == NULL && arena.err, "Expected: arena_alloc_aligned to fail as padding is past the end, Received: %p", c);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* growable and reserved arenas grow or commit instead */
+      arena = arena_create_growable(4096);
+      assertm(!arena.err, "Expected: growable arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      c = arena_alloc_aligned(&arena, 1, 1 << 13);
+      assertm(c != NULL && !arena.err, "Expected: growable arena to grow, Received: %s", arena.err);
+      assertm((uintptr_t)c % (1 << 13) == 0, "Expected: %p to be 8K aligned", c);
+      *(uint8_t *)c = 1;
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      arena = arena_create_reserved(1 << 20, 4096);
+      assertm(!arena.err, "Expected: reserved arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      arena_alloc(&arena, 1);
+      c = arena_alloc_aligned(&arena, 1, 1 << 13);
+      assertm(c != NULL && !arena.err, "Expected: reserved arena to commit more, Received: %s", arena.err);
+      assertm((uintptr_t)c % (1 << 13) == 0, "Expected: %p to be 8K aligned", c);
+      *(uint8_t *)c = 1;
+
+      c = arena_alloc_aligned(&arena, 1, 1 << 24);
+      assertm(c == NULL && arena.err, "Expected: padding past the reservation to fail, Received: %p", c);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA ALLOC ALIGNED ERROR PATH TESTS] OK!");
+    }
+  }
+
   /* arena_realloc */
   {
     {
@@ -373,14 +572,22 @@ int main(void)
       }
       c[len - 1] = '\0';
 
-      c = arena_realloc(&arena, (void *)c, len, len);
-      assertm(!arena.err, "Expected: %zu bytes to be allocated, Received: %p (%s -> %s)", len, (void *)c, arena.err, strerror(errno));
+      /* c is the most recent allocation so it stays where it is */
+      char *same = arena_realloc(&arena, (void *)c, len, len);
+      assertm(!arena.err, "Expected: %zu bytes to be allocated, Received: %p (%s -> %s)", len, (void *)same, arena.err, strerror(errno));
+      assertm(same == c, "Expected: realloc in place at %p, Received: %p", (void *)c, (void *)same);
+      assertm(arena.offset == len, "Expected: arena offset to be %zu, Received: %zu", len, arena.offset);
+
+      /* c is no longer the most recent allocation so it gets copied */
+      arena_alloc(&arena, 8);
+      c = arena_realloc(&arena, (void *)c, len, len - 8);
+      assertm(!arena.err, "Expected: %zu bytes to be allocated, Received: %p (%s -> %s)", len - 8, (void *)c, arena.err, strerror(errno));
+      assertm(c != same, "Expected: a new allocation, Received: %p", (void *)c);
       assertm(arena.offset == arena.size, "Expected: arena offset to be %zu, Received: %zu", arena.size, arena.offset);
 
-      for (size_t i = 0; i < len - 1; i++) {
+      for (size_t i = 0; i < len - 8; i++) {
         assertm(c[i] == (char)(i + 1), "Expected: %c, Received: %c", (char)(i + 1), c[i]);
       }
-      assertm(c[len - 1] == '\0', "Expected: '\\0', Received: %c", c[len - 1]);
 
       arena_reset(&arena);
 
@@ -390,9 +597,16 @@ int main(void)
       assertm(!arena.err, "Expected: %zu bytes to be allocated, Received: %p (%s -> %s)", len, (void *)c, arena.err, strerror(errno));
       assertm(arena.offset == len, "Expected: arena offset to be %zu, Received: %zu", len, arena.offset);
 
+      /* shrinking the most recent allocation gives the rest back to the arena */
       c = arena_realloc(&arena, (void *)c, len, 16);
       assertm(!arena.err, "Expected: arena_realloc to succeed, Received: arena to have an error %s -> %s", arena.err, strerror(errno));
-      assertm(c != NULL, "Expected: valid allocated pointer, Received: %p", (void *)c);
+      assertm(c == arena.arena, "Expected: realloc in place at %p, Received: %p", arena.arena, (void *)c);
+      assertm(arena.offset == 16, "Expected: arena offset to be %d, Received: %zu", 16, arena.offset);
+
+      /* and so does growing it, until the whole arena is used */
+      c = arena_realloc(&arena, (void *)c, 16, arena.size);
+      assertm(!arena.err, "Expected: arena_realloc to succeed, Received: arena to have an error %s -> %s", arena.err, strerror(errno));
+      assertm(c == arena.arena, "Expected: realloc in place at %p, Received: %p", arena.arena, (void *)c);
       assertm(arena.offset == arena.size, "Expected: arena offset to be %zu, Received: %zu", arena.size, arena.offset);
 
       arena_reset(&arena);
@@ -456,10 +670,23 @@ int main(void)
       assertm(!arena.err, "Expected: %zu bytes to be allocated, Received: %p (%s -> %s)", len, (void *)c, arena.err, strerror(errno));
       assertm(arena.offset == len, "Expected: arena offset to be %zu, Received: %zu", len, arena.offset);
 
+      c = arena_realloc(&arena, (void *)c, len, len + 17);
+      assertm(c == NULL, "Expected: arena_realloc to fail as arena can't fit 17 more bytes, Received: new ptr %p", (void *)c);
+      assertm(arena.err, "Expected: arena to have an error %s -> %s, Received: %s", arena.err, strerror(errno), arena.err);
+      assertm(arena.offset == len, "Expected: arena offset to be %zu, Received: %zu", len, arena.offset);
+
+      arena_reset(&arena);
+
+      /* test internal call to arena_alloc should fail path when ptr is not the most recent allocation */
+      len = arena.size - 16;
+      c = arena_alloc(&arena, len);
+      arena_alloc(&arena, 8);
+      assertm(!arena.err, "Expected: allocations to succeed, Received: %s -> %s", arena.err, strerror(errno));
+
       c = arena_realloc(&arena, (void *)c, len, 17);
       assertm(c == NULL, "Expected: arena_realloc to fail as arena can't fit 17 bytes, Received: new ptr %p", (void *)c);
       assertm(arena.err, "Expected: arena to have an error %s -> %s, Received: %s", arena.err, strerror(errno), arena.err);
-      assertm(arena.offset == len, "Expected: arena offset to be %zu, Received: %zu", len, arena.offset);
+      assertm(arena.offset == len + 8, "Expected: arena offset to be %zu, Received: %zu", len + 8, arena.offset);
 
       assertm(arena_free(&arena) && !arena.err,
               "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
@@ -468,6 +695,982 @@ int main(void)
     }
   }
 
+  /* arena_free_last */
+  {
+    {
+      arena_t arena = arena_create(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      char *a = arena_alloc(&arena, 10);
+      char *b = arena_alloc(&arena, 104);
+
+      /* only the most recent allocation can be released */
+      assertm(!arena_free_last(&arena, a, 10) && arena.err, "Expected: arena_free_last to fail, Received: %s", arena.err);
+      assertm(!arena_free_last(&arena, b, 103) && arena.err, "Expected: arena_free_last to fail, Received: %s", arena.err);
+
+      assertm(arena_free_last(&arena, b, 104) && !arena.err, "Expected: arena_free_last to work, Received: %s", arena.err);
+      assertm(arena.offset == (uintptr_t)b - (uintptr_t)arena.arena, "Expected: %zu, Received: %zu",
+              (size_t)((uintptr_t)b - (uintptr_t)arena.arena), arena.offset);
+      assertm(arena.offset == 16, "Expected: alignment padding after a to not be released, Received: %zu", arena.offset);
+
+      /* the released memory is reused */
+      char *c = arena_alloc(&arena, 104);
+      assertm(c == b, "Expected: %p, Received: %p", (void *)b, (void *)c);
+
+      /* LIFO order */
+      char *d = arena_alloc(&arena, 8);
+      char *e = arena_alloc(&arena, 24);
+      assertm(arena_free_last(&arena, e, 24) && !arena.err, "Expected: arena_free_last to work, Received: %s", arena.err);
+      assertm(arena_free_last(&arena, d, 8) && !arena.err, "Expected: arena_free_last to work, Received: %s", arena.err);
+      assertm(arena_free_last(&arena, c, 104) && !arena.err, "Expected: arena_free_last to work, Received: %s", arena.err);
+      assertm(arena.offset == 16, "Expected: 16, Received: %zu", arena.offset);
+
+      char x = 'x';
+      assertm(!arena_free_last(&arena, &x, 1) && arena.err, "Expected: arena_free_last to fail for a ptr outside the arena, Received: %s", arena.err);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA FREE LAST TESTS] OK!");
+    }
+
+    {
+      /* in place growth of reserved arenas commits more memory */
+      size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+      arena_t arena = arena_create_reserved(64 * page_size, page_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      arena_alloc(&arena, 8);
+      char *c = arena_alloc(&arena, 16);
+      char *grown = arena_realloc(&arena, c, 16, 8 * page_size);
+      assertm(grown == c && !arena.err, "Expected: realloc in place at %p, Received: %p (%s)", (void *)c, (void *)grown, arena.err);
+      assertm(arena.size >= 8 * page_size + 16, "Expected: more memory to be committed, Received: %zu", arena.size);
+      memset(grown, 'a', 8 * page_size);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* growable arenas grow in place until the current block runs out */
+      arena = arena_create_growable(page_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      c = arena_alloc(&arena, 16);
+      memset(c, 'b', 16);
+      grown = arena_realloc(&arena, c, 16, 32);
+      assertm(grown == c && !arena.err, "Expected: realloc in place at %p, Received: %p (%s)", (void *)c, (void *)grown, arena.err);
+
+      grown = arena_realloc(&arena, c, 32, arena.size * 2);
+      assertm(grown != NULL && grown != c && !arena.err, "Expected: a copy in a new block, Received: %p (%s)", (void *)grown, arena.err);
+      assertm(grown[0] == 'b' && grown[15] == 'b', "Expected: 'b', Received: %c and %c", grown[0], grown[15]);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA REALLOC IN PLACE TESTS] OK!");
+    }
+  }
+
+  /* arena_create_growable */
+  {
+    {
+      arena_t arena = arena_create_growable(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+      assertm(arena.arena != NULL, "Expected: non-NULL arena addr, Received: %p", arena.arena);
+      assertm(arena.first_block_ != NULL && arena.first_block_ == arena.curr_block_,
+              "Expected: current block to be the first block, Received: first %p current %p",
+              (void *)arena.first_block_, (void *)arena.curr_block_);
+      assertm(arena.size >= requested_arena_size, "Expected: atleast %zu, Received: %zu", requested_arena_size, arena.size);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+
+      void *first_base = arena.arena;
+      size_t first_size = arena.size;
+
+      /* fill up the first block completely */
+      char *c = arena_alloc(&arena, first_size);
+      assertm(!arena.err, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+      memset(c, 'a', first_size);
+
+      /* this would fail with ARENA_ENOMEM on a non-growable arena */
+      char *d = arena_alloc(&arena, 100);
+      assertm(!arena.err, "Expected: arena_alloc to succeed by growing, Received: %s", arena.err);
+      assertm(d != NULL, "Expected: a non-NULL allocation, Received: %p", (void *)d);
+      assertm(arena.arena != first_base, "Expected: arena to have moved on to a new block, Received: %p", arena.arena);
+      assertm(arena.curr_block_ == arena.first_block_->next, "Expected: %p, Received: %p",
+              (void *)arena.first_block_->next, (void *)arena.curr_block_);
+      assertm(arena.size >= first_size * SA_GROWTH_FACTOR, "Expected: atleast %zu, Received: %zu", first_size * SA_GROWTH_FACTOR, arena.size);
+      assertm(arena.offset == 100, "Expected: 100, Received: %zu", arena.offset);
+      memset(d, 'b', 100);
+
+      /* allocations larger than the geometric growth get a block large enough to hold them */
+      size_t large_sz = arena.size * 4;
+      char *e = arena_alloc(&arena, large_sz);
+      assertm(!arena.err, "Expected: arena_alloc to succeed by growing, Received: %s", arena.err);
+      assertm(arena.offset == large_sz, "Expected: %zu, Received: %zu", large_sz, arena.offset);
+      memset(e, 'c', large_sz);
+
+      /* earlier allocations are untouched */
+      assertm(c[first_size - 1] == 'a', "Expected: 'a', Received: %c", c[first_size - 1]);
+      assertm(d[99] == 'b', "Expected: 'b', Received: %c", d[99]);
+
+      /* realloc of a ptr from an older block should work */
+      char *f = arena_realloc(&arena, c, first_size, first_size * 2);
+      assertm(!arena.err, "Expected: arena_realloc to succeed, Received: %s", arena.err);
+      assertm(f[0] == 'a' && f[first_size - 1] == 'a', "Expected: 'a', Received: %c and %c", f[0], f[first_size - 1]);
+
+      arena_block_t *second_block = arena.first_block_->next;
+
+      /* reset rewinds to the first block and retains the rest */
+      assertm(arena_reset(&arena) && !arena.err, "Expected: arena_reset to work, Received: %s", arena.err);
+      assertm(arena.arena == first_base, "Expected: %p, Received: %p", first_base, arena.arena);
+      assertm(arena.size == first_size, "Expected: %zu, Received: %zu", first_size, arena.size);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+      assertm(arena.curr_block_ == arena.first_block_, "Expected: %p, Received: %p",
+              (void *)arena.first_block_, (void *)arena.curr_block_);
+
+      /* retained blocks are reused instead of mmap-ing new ones */
+      arena_alloc(&arena, first_size);
+      arena_alloc(&arena, 100);
+      assertm(!arena.err, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+      assertm(arena.curr_block_ == second_block, "Expected: retained block %p to be reused, Received: %p",
+              (void *)second_block, (void *)arena.curr_block_);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+      assertm(arena.arena == NULL, "Expected: NULL arena addr, Received: %p", arena.arena);
+      assertm(arena.first_block_ == NULL && arena.curr_block_ == NULL, "Expected: no blocks, Received: first %p current %p",
+              (void *)arena.first_block_, (void *)arena.curr_block_);
+      assertm(arena.size == 0, "Expected: 0, Received: %zu", arena.size);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+
+      testlog(L_INFO, "[ARENA GROWABLE HAPPY PATH TESTS] OK!");
+    }
+
+    {
+      arena_t arena = arena_create_growable(0);
+      assertm(arena.err, "Expected: arena creation to fail, Received: valid arena");
+      assertm(arena.arena == NULL, "Expected: NULL as arena base addr, Received: %p", arena.arena);
+      assertm(arena.first_block_ == NULL, "Expected: no blocks, Received: %p", (void *)arena.first_block_);
+
+      /* sizes that would wrap around when adding the block header must fail instead of growing a tiny block */
+      arena = arena_create_growable(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+      assertm(arena_alloc(&arena, SIZE_MAX - 1) == NULL && arena.err, "Expected: arena_alloc to fail, Received: %s", arena.err);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+      assertm(arena.first_block_->next == NULL, "Expected: no new block, Received: %p", (void *)arena.first_block_->next);
+      assertm(arena_free(&arena), "Expected: arena free to work, Received: %s", arena.err);
+
+      testlog(L_INFO, "[ARENA GROWABLE ERROR PATH TESTS] OK!");
+    }
+  }
+
+  /* arena_create_reserved */
+  {
+    {
+      size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+      size_t reserve_sz = 1024 * 1024 * 1024;
+      size_t commit_sz = 16 * page_size;
+
+      arena_t arena = arena_create_reserved(reserve_sz, commit_sz);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+      assertm(arena.arena != NULL, "Expected: non-NULL arena addr, Received: %p", arena.arena);
+      assertm(arena.size == commit_sz, "Expected: only %zu bytes to be committed, Received: %zu", commit_sz, arena.size);
+      assertm(arena.reserved_ == reserve_sz, "Expected: %zu bytes to be reserved, Received: %zu", reserve_sz, arena.reserved_);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+
+      void *base = arena.arena;
+
+      /* allocations past the committed size commit more in place and stay contiguous */
+      char *c = arena_alloc(&arena, commit_sz);
+      assertm(!arena.err, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+      memset(c, 'a', commit_sz);
+
+      char *d = arena_alloc(&arena, 3 * commit_sz + 8);
+      assertm(!arena.err, "Expected: arena_alloc to succeed by committing more, Received: %s", arena.err);
+      assertm(d == c + commit_sz, "Expected: %p (contiguous), Received: %p", (void *)(c + commit_sz), (void *)d);
+      assertm(arena.arena == base, "Expected: arena to never move from %p, Received: %p", base, arena.arena);
+      assertm(arena.size == 5 * commit_sz, "Expected: %zu, Received: %zu", 5 * commit_sz, arena.size);
+      memset(d, 'b', 3 * commit_sz + 8);
+      assertm(c[commit_sz - 1] == 'a', "Expected: 'a', Received: %c", c[commit_sz - 1]);
+
+      /* the default reset policy keeps everything committed */
+      assertm(arena_reset(&arena) && !arena.err, "Expected: arena_reset to work, Received: %s", arena.err);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+      assertm(arena.size == 5 * commit_sz, "Expected: %zu, Received: %zu", 5 * commit_sz, arena.size);
+
+      /* decommit-on-reset gives everything but the first commit size back */
+      arena.reset_policy = ARENA_RESET_DECOMMIT;
+      arena_alloc(&arena, 2 * commit_sz);
+      assertm(arena_reset(&arena) && !arena.err, "Expected: arena_reset to work, Received: %s", arena.err);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+      assertm(arena.size == commit_sz, "Expected: %zu, Received: %zu", commit_sz, arena.size);
+      assertm(arena.arena == base, "Expected: arena to never move from %p, Received: %p", base, arena.arena);
+
+      /* and it can be committed again */
+      d = arena_alloc(&arena, 2 * commit_sz);
+      assertm(!arena.err, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+      memset(d, 'c', 2 * commit_sz);
+
+      /* the reserved range is a hard limit */
+      size_t offset = arena.offset;
+      size_t size = arena.size;
+      d = arena_alloc(&arena, reserve_sz);
+      assertm(d == NULL, "Expected: NULL, Received: %p", (void *)d);
+      assertm(arena.err, "Expected: arena_alloc to fail, Received: no error");
+      assertm(arena.offset == offset, "Expected: %zu (unchanged offset), Received: %zu", offset, arena.offset);
+      assertm(arena.size == size, "Expected: %zu (unchanged size), Received: %zu", size, arena.size);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+      assertm(arena.arena == NULL, "Expected: NULL arena addr, Received: %p", arena.arena);
+      assertm(arena.reserved_ == 0, "Expected: 0, Received: %zu", arena.reserved_);
+      assertm(arena.size == 0, "Expected: 0, Received: %zu", arena.size);
+
+      testlog(L_INFO, "[ARENA RESERVED HAPPY PATH TESTS] OK!");
+    }
+
+    {
+      arena_t arena = arena_create_reserved(0, 4096);
+      assertm(arena.err, "Expected: arena creation to fail, Received: valid arena");
+      assertm(arena.arena == NULL, "Expected: NULL as arena base addr, Received: %p", arena.arena);
+
+      arena = arena_create_reserved(4096, 0);
+      assertm(arena.err, "Expected: arena creation to fail, Received: valid arena");
+      assertm(arena.arena == NULL, "Expected: NULL as arena base addr, Received: %p", arena.arena);
+
+      arena = arena_create_reserved(4096, 8192);
+      assertm(arena.err, "Expected: arena creation to fail as commit size > reserve size, Received: valid arena");
+      assertm(arena.arena == NULL, "Expected: NULL as arena base addr, Received: %p", arena.arena);
+
+      /* sizes that would wrap around past the end of the reservation must fail instead of committing nothing */
+      arena = arena_create_reserved(1024 * 1024, 4096);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+      void *ptr = arena_alloc(&arena, 16);
+      assertm(ptr != NULL, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+      assertm(arena_alloc(&arena, SIZE_MAX - 1) == NULL && arena.err, "Expected: arena_alloc to fail, Received: %s", arena.err);
+      assertm(arena_realloc(&arena, ptr, 16, SIZE_MAX - 1) == NULL && arena.err, "Expected: arena_realloc to fail, Received: %s", arena.err);
+      assertm(arena.offset == 16, "Expected: 16, Received: %zu", arena.offset);
+      assertm(arena_free(&arena), "Expected: arena free to work, Received: %s", arena.err);
+
+      testlog(L_INFO, "[ARENA RESERVED ERROR PATH TESTS] OK!");
+    }
+  }
+
+  /* arena_reset with ARENA_RESET_DECOMMIT and ARENA_RESET_FREE */
+  {
+    {
+      size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+      arena_t arena = arena_create(64 * page_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      char *c = arena_alloc(&arena, arena.size);
+      memset(c, 'a', arena.size);
+      assertm(resident_pages(arena.arena, arena.size) == arena.size / page_size, "Expected: %zu resident pages, Received: %zu",
+              arena.size / page_size, resident_pages(arena.arena, arena.size));
+
+      /* pages beyond reset_retain are given back and the retained ones are untouched */
+      arena.reset_policy = ARENA_RESET_DECOMMIT;
+      arena.reset_retain = 8 * page_size;
+      assertm(arena_reset(&arena) && !arena.err, "Expected: arena_reset to work, Received: %s", arena.err);
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+      assertm(resident_pages(arena.arena, arena.size) == 8, "Expected: 8 resident pages, Received: %zu", resident_pages(arena.arena, arena.size));
+      assertm(c[arena.reset_retain - 1] == 'a', "Expected: 'a', Received: %c", c[arena.reset_retain - 1]);
+      assertm(c[arena.reset_retain] == 0, "Expected: 0, Received: %c", c[arena.reset_retain]);
+
+      /* the arena is fully usable afterwards */
+      c = arena_alloc(&arena, arena.size);
+      assertm(c != NULL && !arena.err, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+      memset(c, 'b', arena.size);
+
+      arena.reset_policy = ARENA_RESET_FREE;
+      arena.reset_retain = 0;
+      assertm(arena_reset(&arena) && !arena.err, "Expected: arena_reset to work, Received: %s", arena.err);
+      c = arena_alloc(&arena, arena.size);
+      assertm(c != NULL && !arena.err, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+      memset(c, 'c', arena.size);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* growable arenas give back the pages of every block but keep the blocks */
+      arena = arena_create_growable(4 * page_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      for (size_t i = 0; i < 64; i++) {
+        memset(arena_alloc(&arena, page_size), 'd', page_size);
+      }
+      arena_block_t *first = arena.first_block_;
+      arena_block_t *last = arena.curr_block_;
+      assertm(first != last, "Expected: more than one block, Received: %p", (void *)last);
+
+      arena.reset_policy = ARENA_RESET_DECOMMIT;
+      assertm(arena_reset(&arena) && !arena.err, "Expected: arena_reset to work, Received: %s", arena.err);
+      assertm(resident_pages(last, last->size) == 1, "Expected: only the header page to be resident, Received: %zu",
+              resident_pages(last, last->size));
+      assertm(arena.first_block_ == first && first->next != NULL, "Expected: blocks to be retained, Received: %p", (void *)first->next);
+
+      for (size_t i = 0; i < 64; i++) {
+        memset(arena_alloc(&arena, page_size), 'e', page_size);
+      }
+      assertm(!arena.err && arena.curr_block_ == last, "Expected: retained blocks to be reused, Received: %p (%s)",
+              (void *)arena.curr_block_, arena.err);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* reserved arenas retain reset_retain bytes rounded up to the commit size */
+      arena = arena_create_reserved(64 * page_size, 2 * page_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+      memset(arena_alloc(&arena, 32 * page_size), 'f', 32 * page_size);
+
+      arena.reset_policy = ARENA_RESET_FREE;
+      arena.reset_retain = 5 * page_size;
+      assertm(arena_reset(&arena) && !arena.err, "Expected: arena_reset to work, Received: %s", arena.err);
+      assertm(arena.size == 6 * page_size, "Expected: %zu, Received: %zu", 6 * page_size, arena.size);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA RESET DECOMMIT TESTS] OK!");
+    }
+  }
+
+  /* arena_open_file */
+  {
+    {
+      typedef struct persisted_node {
+        uint64_t value;
+        arena_relptr_t next;
+      } persisted_node_t;
+
+      char path[] = "/tmp/zdx_simple_arena_test_XXXXXX";
+      int fd = mkstemp(path);
+      assertm(fd >= 0, "Expected: temp file to be created, Received: %s", strerror(errno));
+      close(fd);
+
+      arena_t arena = arena_open_file(path, requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+      assertm(arena.offset == 0, "Expected: 0, Received: %zu", arena.offset);
+      assertm(arena.size >= requested_arena_size, "Expected: atleast %zu, Received: %zu", requested_arena_size, arena.size);
+      assertm(arena_get_root(&arena) == NULL, "Expected: no root, Received: %p", arena_get_root(&arena));
+
+      /* build a linked list with relative pointers */
+      persisted_node_t *head = NULL;
+      for (uint64_t i = 0; i < 10; i++) {
+        persisted_node_t *node = arena_alloc_type(&arena, persisted_node_t);
+        assertm(node != NULL, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+        node->value = i;
+        arena_relptr_set(node->next, head);
+        head = node;
+      }
+      assertm(arena_set_root(&arena, head), "Expected: arena_set_root to work, Received: %s", arena.err);
+      assertm(arena_sync(&arena), "Expected: arena_sync to work, Received: %s", arena.err);
+
+      size_t offset = arena.offset;
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* map the file again. It can land anywhere so only relative pointers are used */
+      void *placeholder = mmap(NULL, 1 << 20, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+      arena = arena_open_file(path, 0);
+      munmap(placeholder, 1 << 20);
+      assertm(!arena.err, "Expected: arena to be opened again, Received: %s -> %s", arena.err, strerror(errno));
+      assertm(arena.offset == offset, "Expected: %zu, Received: %zu", offset, arena.offset);
+
+      uint64_t expected = 9;
+      size_t count = 0;
+      for (persisted_node_t *node = arena_get_root(&arena); node; node = arena_relptr_get(node->next, persisted_node_t)) {
+        assertm(node->value == expected, "Expected: %" PRIu64 ", Received: %" PRIu64, expected, node->value);
+        expected--;
+        count++;
+      }
+      assertm(count == 10, "Expected: 10 nodes, Received: %zu", count);
+
+      /* allocations continue after the persisted ones */
+      persisted_node_t *node = arena_alloc_type(&arena, persisted_node_t);
+      assertm((uintptr_t)node >= (uintptr_t)arena.arena + offset, "Expected: %p to be after the persisted data", (void *)node);
+
+      /* roots must be within the arena */
+      uint64_t outside = 0;
+      assertm(!arena_set_root(&arena, &outside) && arena.err, "Expected: arena_set_root to fail, Received: %s", arena.err);
+      assertm(arena_set_root(&arena, NULL) && arena_get_root(&arena) == NULL, "Expected: root to be cleared, Received: %p", arena_get_root(&arena));
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* files that weren't created by arena_open_file() are rejected */
+      FILE *file = fopen(path, "r+");
+      assertm(file != NULL, "Expected: file to be opened, Received: %s", strerror(errno));
+      fputs("not an arena", file);
+      fclose(file);
+
+      arena = arena_open_file(path, 0);
+      assertm(arena.err && arena.arena == NULL, "Expected: arena_open_file to fail, Received: %p", arena.arena);
+
+      unlink(path);
+
+      /* a bad size for a file that doesn't exist yet must not leave an empty file behind */
+      arena = arena_open_file(path, 0);
+      assertm(arena.err && arena.arena == NULL, "Expected: arena_open_file to fail, Received: %p", arena.arena);
+      assertm(access(path, F_OK) < 0 && errno == ENOENT, "Expected: %s to not be created", path);
+
+      /* an existing empty file is left empty when it can't be turned into an arena */
+      fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+      assertm(fd >= 0, "Expected: file to be created, Received: %s", strerror(errno));
+      close(fd);
+      arena = arena_open_file(path, 0);
+      assertm(arena.err && arena.arena == NULL, "Expected: arena_open_file to fail, Received: %p", arena.arena);
+      arena = arena_open_file(path, requested_arena_size);
+      assertm(!arena.err, "Expected: the empty file to become an arena, Received: %s -> %s", arena.err, strerror(errno));
+      assertm(arena_free(&arena), "Expected: arena free to work, Received: %s", arena.err);
+      unlink(path);
+
+      arena = arena_open_file("/nonexistent_dir/arena", requested_arena_size);
+      assertm(arena.err && arena.arena == NULL, "Expected: arena_open_file to fail, Received: %p", arena.arena);
+
+      /* arena_sync only works on file backed arenas */
+      arena = arena_create(requested_arena_size);
+      assertm(!arena_sync(&arena) && arena.err, "Expected: arena_sync to fail, Received: %s", arena.err);
+      assertm(arena_free(&arena), "Expected: arena free to work, Received: %s", arena.err);
+
+      testlog(L_INFO, "[ARENA OPEN FILE TESTS] OK!");
+    }
+  }
+
+  /* arena_create_shared and arena_open_shared */
+  {
+    {
+      arena_t arena = arena_create_shared(requested_arena_size * 64);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+      assertm(arena.shared_fd > 0, "Expected: a valid fd, Received: %d", arena.shared_fd);
+
+      /* non-atomic allocations are rejected as they would race with other processes */
+      assertm(arena_alloc(&arena, 8) == NULL && arena.err, "Expected: arena_alloc to fail, Received: %s", arena.err);
+
+      /* a second mapping of the same memory (like another process would have) sees writes in place */
+      arena_t other = arena_open_shared(dup(arena.shared_fd));
+      assertm(!other.err, "Expected: shared arena to be opened, Received: %s -> %s", other.err, strerror(errno));
+      assertm(other.arena != arena.arena, "Expected: a different mapping, Received: %p", other.arena);
+
+      char *msg = arena_alloc_concurrent(&arena, 6);
+      assertm(msg != NULL, "Expected: arena_alloc_concurrent to succeed, Received: %s", arena.err);
+      memcpy(msg, "hello", 6);
+      size_t msg_offset = (uintptr_t)msg - (uintptr_t)arena.arena;
+      assertm(strcmp((char *)other.arena + msg_offset, "hello") == 0, "Expected: hello, Received: %s", (char *)other.arena + msg_offset);
+
+      /* both mappings bump the same offset */
+      char *next = arena_alloc_concurrent(&other, 8);
+      assertm((uintptr_t)next - (uintptr_t)other.arena == 8, "Expected: offset 8, Received: %zu", (size_t)((uintptr_t)next - (uintptr_t)other.arena));
+
+      arena_reset(&arena);
+
+      /* forked processes allocate concurrently out of the same arena */
+      pid_t pids[CONCURRENT_THREADS] = {0};
+      size_t allocs_per_child = 1000;
+
+      for (uint8_t i = 0; i < CONCURRENT_THREADS; i++) {
+        pids[i] = fork();
+        assertm(pids[i] >= 0, "Expected: fork to succeed, Received: %s", strerror(errno));
+
+        if (pids[i] == 0) {
+          for (size_t j = 0; j < allocs_per_child; j++) {
+            uint8_t *ptr = arena_alloc_concurrent(i % 2 ? &arena : &other, CONCURRENT_ALLOC_SIZE);
+            if (ptr == NULL) {
+              _exit(1);
+            }
+            memset(ptr, i + 1, CONCURRENT_ALLOC_SIZE);
+          }
+          _exit(0);
+        }
+      }
+
+      for (size_t i = 0; i < CONCURRENT_THREADS; i++) {
+        int status = 0;
+        waitpid(pids[i], &status, 0);
+        assertm(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Expected: child %zu to succeed, Received: status %d", i, status);
+      }
+
+      size_t expected_offset = CONCURRENT_THREADS * allocs_per_child * CONCURRENT_ALLOC_SIZE;
+      assertm(arena.header_->offset == expected_offset, "Expected: %zu, Received: %" PRIu64, expected_offset, arena.header_->offset);
+
+      size_t counts[CONCURRENT_THREADS] = {0};
+      for (size_t off = 0; off < expected_offset; off += CONCURRENT_ALLOC_SIZE) {
+        uint8_t *ptr = (uint8_t *)arena.arena + off;
+        assertm(ptr[0] >= 1 && ptr[0] <= CONCURRENT_THREADS, "Expected: a child id, Received: %u", ptr[0]);
+        for (size_t k = 1; k < CONCURRENT_ALLOC_SIZE; k++) {
+          assertm(ptr[k] == ptr[0], "Expected: %u, Received: %u (allocations overlap)", ptr[0], ptr[k]);
+        }
+        counts[ptr[0] - 1]++;
+      }
+      for (size_t i = 0; i < CONCURRENT_THREADS; i++) {
+        assertm(counts[i] == allocs_per_child, "Expected: %zu, Received: %zu", allocs_per_child, counts[i]);
+      }
+
+      /* the last allocation ending at the end of the arena must not un-pin the offset of this process */
+      const arena_marker_t marker = arena_save(&arena);
+      const size_t tail_sz = arena.size - (size_t)arena.header_->offset;
+      uint8_t *tail = arena_alloc_concurrent(&other, tail_sz);
+      assertm(tail != NULL, "Expected: arena_alloc_concurrent to succeed, Received: %s", other.err);
+      uint8_t *tail_here = (uint8_t *)arena.arena + ((uintptr_t)tail - (uintptr_t)other.arena);
+      assertm(!arena_free_last(&arena, tail_here, tail_sz) && arena.err, "Expected: arena_free_last to fail");
+      assertm(arena_realloc(&arena, tail_here, tail_sz, 8) == NULL && arena.err, "Expected: arena_realloc to fail");
+      assertm(!arena_restore(&arena, marker) && arena.err, "Expected: arena_restore to fail");
+      assertm(arena.offset == arena.size, "Expected: %zu, Received: %zu", arena.size, arena.offset);
+      assertm(arena_alloc(&arena, 8) == NULL && arena.err, "Expected: arena_alloc to fail, Received: %s", arena.err);
+
+      /* a size close to SIZE_MAX must not wrap the shared offset around */
+      arena_reset(&arena);
+      assertm(arena_alloc_concurrent(&other, 64) != NULL, "Expected: arena_alloc_concurrent to succeed, Received: %s", other.err);
+      assertm(arena_alloc_concurrent(&other, SIZE_MAX - 8) == NULL && other.err, "Expected: arena_alloc_concurrent to fail");
+      assertm(arena.header_->offset == 64, "Expected: 64, Received: %zu", (size_t)arena.header_->offset);
+
+      /* decommitting frees the shared pages for every mapping, not just this one */
+      uint8_t *last = (uint8_t *)other.arena + other.size - 1;
+      *last = 0xab;
+      arena.reset_policy = ARENA_RESET_DECOMMIT;
+#if defined(MADV_REMOVE)
+      assertm(arena_reset(&arena) && !arena.err, "Expected: arena_reset to work, Received: %s -> %s", arena.err, strerror(errno));
+      assertm(*last == 0, "Expected: 0, Received: %u", *last);
+#else
+      assertm(!arena_reset(&arena) && arena.err, "Expected: arena_reset to fail without MADV_REMOVE");
+#endif
+      assertm(arena.header_->offset == 0, "Expected: 0, Received: %zu", (size_t)arena.header_->offset);
+
+      assertm(arena_free(&other) && !other.err, "Expected: arena free to work, Received: %s", other.err);
+      assertm(arena_free(&arena) && !arena.err, "Expected: arena free to work, Received: %s", arena.err);
+      assertm(arena.shared_fd == -1, "Expected: -1, Received: %d", arena.shared_fd);
+
+      /* only shared arenas can be opened */
+      char path[] = "/tmp/zdx_simple_arena_test_XXXXXX";
+      int fd = mkstemp(path);
+      unlink(path);
+      assertm(ftruncate(fd, 4096) == 0, "Expected: ftruncate to work, Received: %s", strerror(errno));
+      arena = arena_open_shared(fd);
+      assertm(arena.err && arena.arena == NULL, "Expected: arena_open_shared to fail, Received: %p", arena.arena);
+      close(fd);
+
+      arena = arena_open_shared(-1);
+      assertm(arena.err && arena.arena == NULL, "Expected: arena_open_shared to fail, Received: %p", arena.arena);
+
+      arena = arena_create_shared(0);
+      assertm(arena.err && arena.arena == NULL, "Expected: arena_create_shared to fail, Received: %p", arena.arena);
+
+      testlog(L_INFO, "[ARENA SHARED TESTS] OK!");
+    }
+  }
+
+  /* arena_save, arena_restore and scratch scopes */
+  {
+    {
+      arena_t arena = arena_create(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      int *long_lived = arena_alloc(&arena, sizeof(int) * 4);
+      long_lived[3] = 1337;
+      size_t long_lived_offset = arena.offset;
+
+      arena_marker_t marker = arena_save(&arena);
+      assertm(marker.offset == long_lived_offset, "Expected: %zu, Received: %zu", long_lived_offset, marker.offset);
+
+      char *tmp = arena_alloc(&arena, 100);
+      memset(tmp, 'a', 100);
+      arena_marker_t nested_marker = arena_save(&arena);
+      arena_alloc(&arena, 200);
+
+      assertm(arena_restore(&arena, nested_marker) && !arena.err, "Expected: arena_restore to work, Received: %s", arena.err);
+      assertm(arena.offset == nested_marker.offset, "Expected: %zu, Received: %zu", nested_marker.offset, arena.offset);
+
+      assertm(arena_restore(&arena, marker) && !arena.err, "Expected: arena_restore to work, Received: %s", arena.err);
+      assertm(arena.offset == long_lived_offset, "Expected: %zu, Received: %zu", long_lived_offset, arena.offset);
+      assertm(long_lived[3] == 1337, "Expected: 1337, Received: %d", long_lived[3]);
+
+      /* released memory is handed out again */
+      char *tmp2 = arena_alloc(&arena, 100);
+      assertm(tmp2 == tmp, "Expected: %p, Received: %p", (void *)tmp, (void *)tmp2);
+
+      /* restoring a marker that's ahead of the arena is an error */
+      arena_restore(&arena, marker);
+      size_t offset = arena.offset;
+      assertm(!arena_restore(&arena, nested_marker) && arena.err, "Expected: arena_restore to fail, Received: %s", arena.err);
+      assertm(arena.offset == offset, "Expected: %zu (unchanged offset), Received: %zu", offset, arena.offset);
+
+      /* scoped scratch */
+      offset = arena.offset;
+      arena_with_scratch(scratch, &arena) {
+        char *s = arena_alloc(scratch.arena, 512);
+        assertm(s != NULL && !arena.err, "Expected: arena_alloc to succeed, Received: %s", arena.err);
+        assertm(arena.offset > offset, "Expected: offset > %zu, Received: %zu", offset, arena.offset);
+
+        arena_scratch_t inner = arena_scratch_begin(&arena);
+        arena_alloc(inner.arena, 128);
+        arena_scratch_end(inner);
+        assertm(arena.offset == inner.marker.offset, "Expected: %zu, Received: %zu", inner.marker.offset, arena.offset);
+      }
+      assertm(arena.offset == offset, "Expected: %zu, Received: %zu", offset, arena.offset);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA SAVE RESTORE TESTS] OK!");
+    }
+
+    {
+      arena_t arena = arena_create_growable(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      arena_alloc(&arena, 16);
+      arena_marker_t marker = arena_save(&arena);
+
+      /* push the arena into a new block */
+      arena_alloc(&arena, arena.size);
+      assertm(arena.curr_block_ != arena.first_block_, "Expected: arena to have grown, Received: %p", (void *)arena.curr_block_);
+
+      assertm(arena_restore(&arena, marker) && !arena.err, "Expected: arena_restore to work, Received: %s", arena.err);
+      assertm(arena.curr_block_ == arena.first_block_, "Expected: %p, Received: %p", (void *)arena.first_block_, (void *)arena.curr_block_);
+      assertm(arena.offset == 16, "Expected: 16, Received: %zu", arena.offset);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA GROWABLE SAVE RESTORE TESTS] OK!");
+    }
+  }
+
+  /* arena_scratch_get */
+  {
+    {
+      arena_scratch_t scratch = arena_scratch_get(NULL, 0);
+      assertm(scratch.arena != NULL && !scratch.arena->err, "Expected: a scratch arena, Received: %p", (void *)scratch.arena);
+      assertm(scratch.marker.offset == 0, "Expected: 0, Received: %zu", scratch.marker.offset);
+
+      char *result = arena_alloc(scratch.arena, 64);
+      memset(result, 'r', 64);
+
+      /* a callee asking for scratch memory that doesn't conflict with its caller's arena */
+      arena_scratch_t inner = arena_scratch_get((arena_t *[]){ scratch.arena }, 1);
+      assertm(inner.arena != NULL, "Expected: a scratch arena, Received: %p", (void *)inner.arena);
+      assertm(inner.arena != scratch.arena, "Expected: a scratch arena other than %p, Received: %p",
+              (void *)scratch.arena, (void *)inner.arena);
+
+      char *tmp = arena_alloc(inner.arena, 4096);
+      memset(tmp, 't', 4096);
+      arena_scratch_end(inner);
+      assertm(inner.arena->offset == 0, "Expected: 0, Received: %zu", inner.arena->offset);
+      assertm(result[63] == 'r', "Expected: 'r', Received: %c", result[63]);
+
+      /* no scratch arena is available if all of them conflict */
+      arena_scratch_t none = arena_scratch_get((arena_t *[]){ scratch.arena, inner.arena }, 2);
+      assertm(none.arena == NULL, "Expected: NULL, Received: %p", (void *)none.arena);
+      arena_scratch_end(none);
+
+      arena_scratch_end(scratch);
+      assertm(scratch.arena->offset == 0, "Expected: 0, Received: %zu", scratch.arena->offset);
+
+      /* scratch arenas are reused */
+      arena_scratch_t again = arena_scratch_get(NULL, 0);
+      assertm(again.arena == scratch.arena, "Expected: %p, Received: %p", (void *)scratch.arena, (void *)again.arena);
+      arena_scratch_end(again);
+
+      assertm(arena_scratch_pool_free(), "Expected: scratch arenas to be freed, Received: false");
+      assertm(scratch.arena->arena == NULL, "Expected: NULL, Received: %p", scratch.arena->arena);
+
+      /* threads other than main free their scratch arenas when they exit */
+      pthread_t thread;
+      void *block = NULL;
+      assertm(pthread_create(&thread, NULL, scratch_worker, &block) == 0, "Expected: thread to be created");
+      pthread_join(thread, NULL);
+      assertm(block != NULL, "Expected: a scratch block, Received: NULL");
+      assertm(msync(block, arena_page_size_(), MS_ASYNC) < 0 && errno == ENOMEM,
+              "Expected: scratch block %p to be unmapped after the thread exited", block);
+
+      testlog(L_INFO, "[ARENA SCRATCH POOL TESTS] OK!");
+    }
+  }
+
+  /* arena_pool */
+  {
+    {
+      typedef struct pool_node {
+        uint64_t key;
+        struct pool_node *next;
+        char name[20];
+      } pool_node_t;
+
+      arena_t arena = arena_create(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      arena_pool_t pool = arena_pool_init_type(&arena, pool_node_t);
+      assertm(pool.arena == &arena, "Expected: valid pool, Received: %s", arena.err);
+      assertm(pool.slot_size == sizeof(pool_node_t), "Expected: %zu, Received: %zu", sizeof(pool_node_t), pool.slot_size);
+
+      pool_node_t *nodes[8] = {0};
+      for (size_t i = 0; i < 8; i++) {
+        nodes[i] = arena_pool_alloc(&pool);
+        assertm(nodes[i] != NULL, "Expected: arena_pool_alloc to succeed, Received: %s", arena.err);
+        assertm((uintptr_t)nodes[i] % _Alignof(pool_node_t) == 0, "Expected: aligned slot, Received: %p", (void *)nodes[i]);
+        nodes[i]->key = i;
+      }
+      assertm(arena.offset == 8 * sizeof(pool_node_t), "Expected: %zu, Received: %zu", 8 * sizeof(pool_node_t), arena.offset);
+
+      /* freed slots are reused in LIFO order before the arena is touched again */
+      arena_pool_free(&pool, nodes[2]);
+      arena_pool_free(&pool, nodes[5]);
+      arena_pool_free(&pool, NULL);
+      assertm(arena_pool_alloc(&pool) == nodes[5], "Expected: %p to be reused", (void *)nodes[5]);
+      assertm(arena_pool_alloc(&pool) == nodes[2], "Expected: %p to be reused", (void *)nodes[2]);
+      assertm(arena.offset == 8 * sizeof(pool_node_t), "Expected: %zu, Received: %zu", 8 * sizeof(pool_node_t), arena.offset);
+      assertm(nodes[7]->key == 7, "Expected: 7, Received: %" PRIu64, nodes[7]->key);
+
+      /* cache line aligned slots */
+      arena_pool_t padded = arena_pool_init(&arena, 24, SA_CACHE_LINE_SIZE);
+      assertm(padded.slot_size == SA_CACHE_LINE_SIZE, "Expected: %d, Received: %zu", SA_CACHE_LINE_SIZE, padded.slot_size);
+      char *a = arena_pool_alloc(&padded);
+      char *b = arena_pool_alloc(&padded);
+      assertm((uintptr_t)a % SA_CACHE_LINE_SIZE == 0 && b == a + SA_CACHE_LINE_SIZE, "Expected: cache line aligned slots, Received: %p and %p", (void *)a, (void *)b);
+
+      /* tiny objects still get room for the free list pointer */
+      arena_pool_t tiny = arena_pool_init(&arena, 1, 1);
+      assertm(tiny.slot_size == sizeof(void *), "Expected: %zu, Received: %zu", sizeof(void *), tiny.slot_size);
+      char *t = arena_pool_alloc(&tiny);
+      arena_pool_free(&tiny, t);
+      assertm(arena_pool_alloc(&tiny) == t, "Expected: %p to be reused", (void *)t);
+
+      /* bulk release */
+      arena_reset(&arena);
+      arena_pool_reset(&pool);
+      assertm(arena_pool_alloc(&pool) == arena.arena, "Expected: first slot at %p", arena.arena);
+
+      /* the pool runs out when the arena does */
+      void *slot = NULL;
+      size_t count = 1;
+      while ((slot = arena_pool_alloc(&pool))) {
+        count++;
+      }
+      assertm(arena.err, "Expected: arena to be out of memory, Received: no error");
+      assertm(count == arena.size / sizeof(pool_node_t), "Expected: %zu, Received: %zu", arena.size / sizeof(pool_node_t), count);
+
+      /* invalid pools */
+      pool = arena_pool_init(&arena, 0, 8);
+      assertm(pool.arena == NULL && arena.err, "Expected: arena_pool_init to fail, Received: %s", arena.err);
+      pool = arena_pool_init(&arena, 8, 12);
+      assertm(pool.arena == NULL && arena.err, "Expected: arena_pool_init to fail, Received: %s", arena.err);
+      assertm(arena_pool_alloc(&pool) == NULL, "Expected: NULL from an invalid pool");
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA POOL TESTS] OK!");
+    }
+  }
+
+  /* arena_handles */
+  {
+    {
+      arena_t arena = arena_create(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      arena_handles_t handles = arena_handles_init(&arena, 8);
+      assertm(handles.arena == &arena, "Expected: valid handles, Received: %s", arena.err);
+      assertm(handles.start == 8 * sizeof(arena_handle_slot_t), "Expected: %zu, Received: %zu", 8 * sizeof(arena_handle_slot_t), handles.start);
+
+      /* block i holds i + 1 bytes of value i */
+      arena_handle_t hs[6] = {0};
+      for (size_t i = 0; i < 6; i++) {
+        hs[i] = arena_handles_alloc(&handles, (i + 1) * 10);
+        assertm(hs[i] != 0, "Expected: arena_handles_alloc to succeed, Received: %s", arena.err);
+        uint8_t *data = arena_handles_get(&handles, hs[i]);
+        assertm(data && (uintptr_t)data % SA_DEFAULT_ALIGNMENT == 0, "Expected: aligned block, Received: %p", (void *)data);
+        memset(data, (int)i, (i + 1) * 10);
+      }
+      const size_t full_offset = arena.offset;
+      assertm(handles.live_bytes == full_offset - handles.start, "Expected: %zu, Received: %zu", full_offset - handles.start, handles.live_bytes);
+
+      /* freeing blocks in the middle leaves holes and invalidates their handles */
+      assertm(arena_handles_free(&handles, hs[1]), "Expected: arena_handles_free to succeed");
+      assertm(arena_handles_free(&handles, hs[3]), "Expected: arena_handles_free to succeed");
+      assertm(!arena_handles_free(&handles, hs[3]), "Expected: double free to fail");
+      assertm(!arena_handles_free(&handles, 0), "Expected: freeing handle 0 to fail");
+      assertm(arena_handles_get(&handles, hs[1]) == NULL, "Expected: NULL for a freed handle");
+      assertm(arena.offset == full_offset, "Expected: %zu, Received: %zu", full_offset, arena.offset);
+      assertm(handles.dead_bytes > 0, "Expected: dead bytes, Received: %zu", handles.dead_bytes);
+
+      /* a reused slot gets a new generation so the stale handle stays invalid */
+      arena_handle_t reused = arena_handles_alloc(&handles, 4);
+      assertm((reused & ((1u << SA_HANDLE_INDEX_BITS) - 1)) == (hs[3] & ((1u << SA_HANDLE_INDEX_BITS) - 1)),
+              "Expected: slot of %u to be reused, Received: %u", hs[3], reused);
+      assertm(reused != hs[3] && arena_handles_get(&handles, hs[3]) == NULL, "Expected: stale handle %u to be invalid", hs[3]);
+      memcpy(arena_handles_get(&handles, reused), "abc", 4);
+
+      /* freeing the last block gives its memory straight back to the arena */
+      const size_t before_last = arena.offset;
+      assertm(arena_handles_free(&handles, reused), "Expected: arena_handles_free to succeed");
+      assertm(arena.offset < before_last, "Expected: offset below %zu, Received: %zu", before_last, arena.offset);
+      reused = arena_handles_alloc(&handles, 4);
+      memcpy(arena_handles_get(&handles, reused), "abc", 4);
+
+      /* compaction slides live blocks down and keeps their contents */
+      const size_t dead_bytes = handles.dead_bytes;
+      const size_t offset = arena.offset;
+      size_t reclaimed = arena_handles_compact(&handles);
+      assertm(reclaimed == dead_bytes, "Expected: %zu, Received: %zu", dead_bytes, reclaimed);
+      assertm(arena.offset == offset - reclaimed, "Expected: %zu, Received: %zu", offset - reclaimed, arena.offset);
+      assertm(handles.dead_bytes == 0, "Expected: 0, Received: %zu", handles.dead_bytes);
+      assertm(arena.offset == handles.start + handles.live_bytes, "Expected: %zu, Received: %zu", handles.start + handles.live_bytes, arena.offset);
+      for (uint8_t i = 0; i < 6; i++) {
+        if (i == 1 || i == 3) continue;
+        uint8_t *data = arena_handles_get(&handles, hs[i]);
+        for (size_t j = 0; j < 10 * (i + 1u); j++) {
+          assertm(data[j] == i, "Expected: %u at byte %zu of block %u, Received: %u", i, j, i, data[j]);
+        }
+      }
+      assertm(strcmp(arena_handles_get(&handles, reused), "abc") == 0, "Expected: abc, Received: %s", (char *)arena_handles_get(&handles, reused));
+      assertm(arena_handles_compact(&handles) == 0, "Expected: nothing to compact");
+
+      /* running out of handles */
+      size_t count = 0;
+      while (arena_handles_alloc(&handles, 1)) {
+        count++;
+      }
+      assertm(count == 3 && arena.err, "Expected: 3 more handles and an error, Received: %zu and %s", count, arena.err);
+
+      /* reset invalidates every handle and rewinds the arena */
+      arena.err = NULL;
+      arena_handles_reset(&handles);
+      assertm(arena.offset == handles.start, "Expected: %zu, Received: %zu", handles.start, arena.offset);
+      assertm(arena_handles_get(&handles, hs[0]) == NULL, "Expected: NULL for a handle from before the reset");
+
+      /* running out of arena */
+      arena_handle_t big = arena_handles_alloc(&handles, arena.size - arena.offset - 16);
+      assertm(big != 0, "Expected: arena_handles_alloc to succeed, Received: %s", arena.err);
+      assertm(arena_handles_alloc(&handles, 1) == 0 && arena.err, "Expected: arena to be out of memory, Received: no error");
+      arena.err = NULL;
+      assertm(arena_handles_alloc(&handles, 0) == 0 && !arena.err, "Expected: 0 for a zero sized block");
+
+      /* invalid handles */
+      handles = arena_handles_init(&arena, 0);
+      assertm(handles.arena == NULL && arena.err, "Expected: arena_handles_init to fail, Received: %s", arena.err);
+      handles = arena_handles_init(&arena, 1u << SA_HANDLE_INDEX_BITS);
+      assertm(handles.arena == NULL && arena.err, "Expected: arena_handles_init to fail, Received: %s", arena.err);
+      assertm(arena_handles_alloc(&handles, 8) == 0, "Expected: 0 from invalid handles");
+      assertm(arena_handles_compact(&handles) == 0, "Expected: nothing to compact for invalid handles");
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* growable arenas aren't supported */
+      arena = arena_create_growable(requested_arena_size);
+      handles = arena_handles_init(&arena, 8);
+      assertm(handles.arena == NULL && arena.err, "Expected: arena_handles_init to fail, Received: %s", arena.err);
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA HANDLES TESTS] OK!");
+    }
+  }
+
+  /* arena stats */
+  {
+    {
+      arena_t arena = arena_create(requested_arena_size);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      arena_alloc(&arena, 1);
+      arena_alloc(&arena, 8);  // 7 bytes of padding
+      arena_alloc(&arena, 3);  // no padding as 4 byte alignment of offset 16 is fine
+      arena_alloc_aligned(&arena, 10, 64); // 45 bytes of padding
+      assertm(arena.stats.alloc_count == 4, "Expected: 4, Received: %zu", arena.stats.alloc_count);
+      assertm(arena.stats.bytes_requested == 22, "Expected: 22, Received: %zu", arena.stats.bytes_requested);
+      assertm(arena.stats.bytes_padding == 52, "Expected: 52, Received: %zu", arena.stats.bytes_padding);
+      assertm(arena.stats.peak_offset == 74, "Expected: 74, Received: %zu", arena.stats.peak_offset);
+
+      /* failures are counted but don't count as allocations */
+      assertm(arena_alloc(&arena, arena.size) == NULL, "Expected: arena_alloc to fail, Received: %s", arena.err);
+      assertm(arena.stats.enomem_count == 1, "Expected: 1, Received: %zu", arena.stats.enomem_count);
+      assertm(arena.stats.alloc_count == 4, "Expected: 4, Received: %zu", arena.stats.alloc_count);
+
+      /* peak offset is retained across resets */
+      arena_reset(&arena);
+      arena_alloc(&arena, 16);
+      assertm(arena.stats.reset_count == 1, "Expected: 1, Received: %zu", arena.stats.reset_count);
+      assertm(arena.stats.peak_offset == 74, "Expected: 74, Received: %zu", arena.stats.peak_offset);
+
+      /* in place growth counts the extra bytes */
+      char *c = arena_alloc(&arena, 16);
+      arena_realloc(&arena, c, 16, 1000);
+      assertm(arena.stats.bytes_requested == 22 + 16 + 16 + 984, "Expected: %d, Received: %zu", 22 + 16 + 16 + 984, arena.stats.bytes_requested);
+      assertm(arena.stats.peak_offset == 1016, "Expected: 1016, Received: %zu", arena.stats.peak_offset);
+
+      FILE *devnull = fopen("/dev/null", "w");
+      assertm(devnull != NULL, "Expected: /dev/null to be opened, Received: %s", strerror(errno));
+      arena_stats_dump(&arena, devnull);
+      fclose(devnull);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA STATS TESTS] OK!");
+    }
+  }
+
+  /* arena_alloc_concurrent */
+  {
+    {
+      arena_t arena = arena_create(CONCURRENT_THREADS * CONCURRENT_ALLOCS * 32);
+      assertm(!arena.err, "Expected: valid arena to be created, Received: %s -> %s", arena.err, strerror(errno));
+
+      static concurrent_worker_t workers[CONCURRENT_THREADS] = {0};
+      pthread_t threads[CONCURRENT_THREADS] = {0};
+
+      for (uint8_t i = 0; i < CONCURRENT_THREADS; i++) {
+        workers[i].arena = &arena;
+        workers[i].id = i + 1;
+        assertm(pthread_create(&threads[i], NULL, concurrent_alloc_worker, &workers[i]) == 0, "Expected: thread to be created");
+      }
+
+      for (size_t i = 0; i < CONCURRENT_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+      }
+
+      /* no two allocations overlapped so every allocation still holds what its thread wrote */
+      for (size_t i = 0; i < CONCURRENT_THREADS; i++) {
+        for (size_t j = 0; j < CONCURRENT_ALLOCS; j++) {
+          uint8_t *ptr = workers[i].ptrs[j];
+          assertm(ptr != NULL, "Expected: a non-NULL allocation, Received: %p", (void *)ptr);
+          assertm((uintptr_t)ptr % 8 == 0, "Expected: %p to be aligned to 8", (void *)ptr);
+
+          for (size_t k = 0; k < CONCURRENT_ALLOC_SIZE; k++) {
+            assertm(ptr[k] == workers[i].id, "Expected: %u, Received: %u", workers[i].id, ptr[k]);
+          }
+        }
+      }
+
+      size_t expected_offset = CONCURRENT_THREADS * CONCURRENT_ALLOCS * CONCURRENT_ALLOC_SIZE;
+      assertm(arena.offset == expected_offset, "Expected: %zu, Received: %zu", expected_offset, arena.offset);
+
+      /* running out of memory */
+      arena.offset = arena.size - 1;
+      assertm(arena_alloc_concurrent(&arena, 2) == NULL && arena.err, "Expected: arena_alloc_concurrent to fail, Received: %s", arena.err);
+      assertm(arena.offset == arena.size - 1, "Expected: %zu (unchanged offset), Received: %zu", arena.size - 1, arena.offset);
+
+      /* a size close to SIZE_MAX must not wrap the new offset around */
+      arena_reset(&arena);
+      assertm(arena_alloc_concurrent(&arena, 64) != NULL, "Expected: arena_alloc_concurrent to work, Received: %s", arena.err);
+      assertm(arena_alloc_concurrent(&arena, SIZE_MAX - 8) == NULL && arena.err,
+              "Expected: arena_alloc_concurrent to fail, Received: %s", arena.err);
+      assertm(arena.offset == 64, "Expected: 64 (unchanged offset), Received: %zu", arena.offset);
+
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      /* growable arenas aren't supported */
+      arena = arena_create_growable(requested_arena_size);
+      assertm(arena_alloc_concurrent(&arena, 8) == NULL && arena.err, "Expected: arena_alloc_concurrent to fail, Received: %s", arena.err);
+      assertm(arena_free(&arena) && !arena.err,
+              "Expected: arena free to work, Received: %s -> %s", arena.err,  strerror(errno));
+
+      testlog(L_INFO, "[ARENA ALLOC CONCURRENT TESTS] OK!");
+    }
+  }
+
   testlog(L_INFO, "<zdx_simple_arena_test> All ok!\n");
   return 0;
 }
@@ -501,3 +1704,53 @@ static void test_arena_alloc(arena_t *const arena, const size_t sz, const size_t
   /* n_bytes[sz] = 50; */
   /* assertm(n_bytes[sz], "Nope"); // this should segfault */
 }
+
+static void *concurrent_alloc_worker(void *arg)
+{
+  concurrent_worker_t *worker = arg;
+
+  for (size_t i = 0; i < CONCURRENT_ALLOCS; i++) {
+    uint8_t *ptr = arena_alloc_concurrent(worker->arena, CONCURRENT_ALLOC_SIZE);
+
+    if (ptr) {
+      memset(ptr, worker->id, CONCURRENT_ALLOC_SIZE);
+    }
+    worker->ptrs[i] = ptr;
+  }
+
+  return NULL;
+}
+
+/* uses a scratch arena and exits without calling arena_scratch_pool_free(). *arg is set to its first block */
+static void *scratch_worker(void *arg)
+{
+  arena_scratch_t scratch = arena_scratch_get(NULL, 0);
+
+  if (scratch.arena && arena_alloc(scratch.arena, 64)) {
+    *(void **)arg = scratch.arena->first_block_;
+  }
+  arena_scratch_end(scratch);
+
+  return NULL;
+}
+
+static size_t resident_pages(void *const addr, const size_t len)
+{
+  size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  size_t page_count = (len + page_size - 1) / page_size;
+#if defined(__APPLE__)
+  char vec[1024] = {0};
+#else
+  unsigned char vec[1024] = {0};
+#endif
+
+  assertm(page_count <= sizeof(vec), "Expected: atmost %zu pages, Received: %zu", sizeof(vec), page_count);
+  assertm(mincore(addr, len, vec) == 0, "Expected: mincore to succeed, Received: %s", strerror(errno));
+
+  size_t resident = 0;
+  for (size_t i = 0; i < page_count; i++) {
+    resident += vec[i] & 1;
+  }
+
+  return resident;
+}
@@ -1,5 +1,10 @@
 #include "../zdx_test_utils.h"
 
+#ifdef SB_ALLOCATOR_ENABLE
+#define ZDX_MEMORY_IMPLEMENTATION_AUTO
+#include "../zdx_memory.h"
+#endif // SB_ALLOCATOR_ENABLE
+
 #define SB_MIN_CAPACITY 1
 #define SB_RESIZE_FACTOR 2
 #define ZDX_STR_IMPLEMENTATION
@@ -91,6 +96,34 @@ int main(void)
   assertm(sb.length == 0, "After free(), length in string builder should be 0");
   assertm(sb.capacity == 0, "After free(), capacity in string builder should be 0");
 
+#ifdef SB_ALLOCATOR_ENABLE
+  {
+    arena_t arena = arena_create(4 KB);
+    mem_allocator_t al = mem_arena_init("request", &arena);
+    sb_t request_sb = { .allocator = &al };
+
+    // every append resizes so the contents only survive if the old capacity is passed on to the allocator
+    sb_append(&request_sb, "GET ", "/index.html ");
+    sb_append(&request_sb, "HTTP/1.1", "\r");
+    sb_append_buf(&request_sb, (char []){'\n'}, 1);
+
+    const char *base = arena.arena;
+    assertm(request_sb.str >= base && request_sb.str < base + arena.offset,
+            "Expected: string builder to live in the request arena, Received: %p", (void *)request_sb.str);
+    assertm(request_sb.length == 26, "Expected: 26, Received: %zu", request_sb.length);
+    assertm(strcmp(request_sb.str, "GET /index.html HTTP/1.1\r\n") == 0,
+            "Expected: GET /index.html HTTP/1.1\\r\\n, Received: %s", request_sb.str);
+
+    sb_deinit(&request_sb);
+    assertm(request_sb.str == NULL, "After sb_deinit(), str should be NULL ptr");
+    assertm(request_sb.allocator == &al, "Expected: sb_deinit to keep the allocator, Received: %p", (void *)request_sb.allocator);
+
+    // the whole request is freed in bulk with the arena
+    al.deinit(&al);
+    arena_free(&arena);
+  }
+#endif // SB_ALLOCATOR_ENABLE
+
   // ---- END STRING BUILDER TESTS ----
 
   testlog(L_INFO, "<zdx_str_test> All ok!\n");
@@ -50,6 +50,44 @@
 #define DA_MIN_CAPACITY 8 // hold 8 elements by default
 #endif // DA_MIN_CAPACITY
 
+/*
+ * Defining DA_ALLOCATOR_ENABLE lets each container carry its own allocator. All containers used with
+ * da_push/da_deinit must then have a `mem_allocator_t *allocator` member. When it is NULL the items
+ * are managed with DA_REALLOC and DA_FREE as usual, otherwise with the given allocator (see zdx_memory.h).
+ *
+ * Example:
+ * typedef struct {
+ *   size_t length;
+ *   size_t capacity;
+ *   int *items;
+ *   mem_allocator_t *allocator;
+ * } ints_t;
+ *
+ * mem_allocator_t al = mem_arena_init("request", &request_arena);
+ * ints_t ints = { .allocator = &al };
+ * da_push(&ints, 1, 2, 3);
+ */
+#ifdef DA_ALLOCATOR_ENABLE
+#include "./zdx_memory.h"
+
+#define da_realloc_items_(da, old_sz, new_sz)                                            \
+  ((da)->allocator                                                                     \
+   ? (da)->allocator->realloc((da)->allocator, (da)->items, (old_sz), (new_sz))        \
+   : DA_REALLOC((da)->items, (new_sz)))
+
+#define da_free_items_(da)                                      \
+  do {                                                          \
+    if ((da)->allocator) {                                      \
+      (da)->allocator->free((da)->allocator, (da)->items);      \
+    } else {                                                    \
+      DA_FREE((da)->items);                                     \
+    }                                                           \
+  } while(0)
+#else
+#define da_realloc_items_(da, old_sz, new_sz) ((void)(old_sz), DA_REALLOC((da)->items, (new_sz)))
+#define da_free_items_(da) DA_FREE((da)->items)
+#endif // DA_ALLOCATOR_ENABLE
+
 #define dbg_da(label, da) dbg("%s length %zu\t\t\t| capacity %zu\t\t| items %p", \
                               (label), (da)->length, (da)->capacity, (void *)(da)->items)
 
@@ -80,13 +118,14 @@
     dbg(">>\t\t\t\t| required capacity %zu", reqd_cap);                                                                   \
                                                                                                                           \
     if (((reqd_cap) + (da)->length) > (da)->capacity) {                                                                   \
+      const size_t old_capacity_ = (da)->capacity;                                                                        \
       if((da)->capacity <= 0) {                                                                                           \
         (da)->capacity = DA_MIN_CAPACITY;                                                                                 \
       }                                                                                                                   \
       while((da)->capacity < ((reqd_cap) + (da)->length)) {                                                               \
         (da)->capacity *= DA_RESIZE_FACTOR;                                                                               \
       }                                                                                                                   \
-      (da)->items = DA_REALLOC((da)->items, (da)->capacity*sizeof(*(da)->items));                                         \
+      (da)->items = da_realloc_items_((da), old_capacity_*sizeof(*(da)->items), (da)->capacity*sizeof(*(da)->items));     \
       DA_ASSERT((da)->items, "[zdx_da] Allocation failed");                                                               \
       dbg("++ resized\t\t\t| new capacity %zu", (da)->capacity);                                                          \
     }                                                                                                                     \
@@ -108,7 +147,7 @@
   do {                                          \
     dbg_da(">>", da);                           \
                                                 \
-    DA_FREE((da)->items);                       \
+    da_free_items_(da);                         \
     (da)->length = 0;                           \
     (da)->capacity = 0;                         \
     (da)->items = NULL;                         \
@@ -25,15 +25,32 @@
  * DESCRIPTION
  *
  * A simple hashtable with max key length of 15 ASCII chars that must have a
- * pre-defined max key/value pair count when initialized.
+ * pre-defined max key/value pair count when initialized with fht_init() or
+ * that grows as needed when initialized with fht_init_growable().
  *
  * CONSTRAINTS
  *
  * 1. Max key length allowed is 15 ASCII characters (15 bytes)
- * 2. Max no., of keys allowed is 1_048_576 (2^20) as beyond that perf of this strategy
- *    becomes unacceptable to me
+ * 2. Max no., of keys allowed is 1_048_576 (2^20) by default. It can be raised up to 2^31
+ *    by defining FHT_MAX_KEYCOUNT_BITS
  * 3. Max count of key/value pairs that will be stored need to be given when the
- *    hashtable is initialized
+ *    hashtable is initialized with fht_init()
+ *
+ * LAYOUT
+ *
+ * Next to the keys and values, every slot has a 1 byte control byte in a separate array. It is
+ * FHT_CTRL_EMPTY for a free slot and the top bit plus a 7 bit fragment of the hash of the key
+ * otherwise. Lookups compare FHT_GROUP_WIDTH control bytes at a time (SSE2 on x86_64, NEON on
+ * aarch64 and a scalar loop elsewhere or when FHT_NO_SIMD is defined) and only touch a key when its
+ * fragment matches.
+ * So a lookup typically reads one group of control bytes and at most one key, and a miss usually
+ * never reads a key at all.
+ *
+ * Keys are placed with Robin Hood linear probing: every slot also stores how far its key is from
+ * the slot it hashed to and fht_add() hands a slot over to the key being added whenever that key is
+ * further from its own. This keeps the longest probe length in the table short even at high load and
+ * no lookup, hit or miss, looks further than that. fht_remove() shifts the keys that follow back by
+ * one slot instead of leaving a tombstone behind, so removals never slow down later lookups.
  */
 #ifndef ZDX_FAST_HASHTABLE_H_
 #define ZDX_FAST_HASHTABLE_H_
@@ -59,15 +76,30 @@ _Static_assert(0, "FHT_VALUE_TYPE must be defined to use zdx_fast_hashtable.h");
 #define FHT_ASSERT_NONNULL(ptr) FHT_ASSERT((ptr) != NULL, "Expected: ptr to not be null, Received: NULL")
 
 // max bits for key count imply max keycount
+#ifndef FHT_MAX_KEYCOUNT_BITS
 #define FHT_MAX_KEYCOUNT_BITS 20
+#endif // FHT_MAX_KEYCOUNT_BITS
+_Static_assert(FHT_MAX_KEYCOUNT_BITS > 0 && FHT_MAX_KEYCOUNT_BITS <= 31, "FHT_MAX_KEYCOUNT_BITS should be between 1 and 31");
 // max key count implies max val count
-#define FHT_MAX_KEYCOUNT 1 << FHT_MAX_KEYCOUNT_BITS
+#define FHT_MAX_KEYCOUNT (1u << FHT_MAX_KEYCOUNT_BITS)
 // max key len as we only have 4 bits for key len balanced with perf
 #ifndef FHT_MAX_KEYLEN
 #define FHT_MAX_KEYLEN 15
 #endif // FHT_MAX_KEYLEN
 _Static_assert(FHT_MAX_KEYLEN > 0 && FHT_MAX_KEYLEN <= 15, "FHT_MAX_KEYLEN should be between 1 and 15");
 
+// control byte of a free slot. Used slots store a 7 bit hash fragment with the top bit set
+#define FHT_CTRL_EMPTY 0x00
+// no of control bytes compared at once. The control byte array has FHT_GROUP_WIDTH extra bytes at the end
+// mirroring the first ones so that a group starting at any slot can be loaded without wrapping around
+#define FHT_GROUP_WIDTH 16
+// no of slots of the old table whose keys every fht_add(), fht_update() and fht_remove() moves to the new one
+// while a hashtable from fht_init_growable() grows. Anything >= 2 finishes before the new table needs to grow
+#ifndef FHT_MIGRATE_SLOTS
+#define FHT_MIGRATE_SLOTS 16
+#endif // FHT_MIGRATE_SLOTS
+_Static_assert(FHT_MIGRATE_SLOTS >= 2, "FHT_MIGRATE_SLOTS should be atleast 2");
+
 
 // -------------------- TYPE DECLARATIONS --------------------
 
@@ -90,6 +122,16 @@ typedef struct zdx_fast_hashtable {
     uint32_t count;
     fht_key_t *keys;
     fht_value_t *values;
+    uint8_t *ctrl; // cap + FHT_GROUP_WIDTH control bytes, see LAYOUT above
+    uint32_t *dists; // probe distance of the key in each used slot from the slot it hashes to
+    uint32_t max_dist; // max probe distance of any key added since fht_init() or fht_empty()
+    // table whose keys are being moved to this one while a growable hashtable grows. count includes its keys
+    struct zdx_fast_hashtable *old;
+    uint32_t migrate_index; // slot of old to move keys from next
+    // control bytes of the table a growable hashtable grows into next, zeroed a bit at a time by fht_add()
+    uint8_t *grow_ctrl;
+    size_t grow_ctrl_zeroed;
+    uint8_t growable;
 } fht_t;
 
 typedef enum zdx_fast_hashtable_error {
@@ -110,6 +152,8 @@ typedef struct zdx_fast_hashtable_return_index {
   fht_err_t err; // typically 4 bytes
   // no of keys == no of values. This is another 4 bytes with padding
   // and key index == val index as that's what we do in fht_add()
+  // Only valid until the next fht_add(), fht_update() or fht_remove() as they move keys around.
+  // It is an index into fht->old for keys that haven't been moved yet while a growable hashtable grows
   unsigned int index : FHT_MAX_KEYCOUNT_BITS;
 } fht_ret_index_t;
 
@@ -134,12 +178,14 @@ static inline const char *fht_err_str(const fht_err_t err_code)
 // -------------------- FUNCTION DECLARATIONS --------------------
 
 FHT_API fht_t fht_init(uint32_t count);
+FHT_API fht_t fht_init_growable(uint32_t count);
 FHT_API void fht_deinit(fht_t fht[const static 1]);
 FHT_API inline void fht_empty(fht_t fht[const static 1]);
 
 FHT_API fht_ret_val_t fht_get(const fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len);
 FHT_API fht_ret_index_t fht_add(fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len, FHT_VALUE_TYPE val);
 FHT_API fht_ret_index_t fht_update(fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len, FHT_VALUE_TYPE val);
+FHT_API fht_ret_val_t fht_remove(fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len);
 
 
 // ------------------ FUNCTION IMPLEMENTATIONS -------------------
@@ -150,6 +196,16 @@ FHT_API fht_ret_index_t fht_update(fht_t fht[const static 1], const char user_ke
 #include <stdlib.h>
 #include <string.h>
 
+#include "zdx_util.h" // NONZERO_CTZG
+
+#if !defined(FHT_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define FHT_SIMD_SSE2_
+#elif !defined(FHT_NO_SIMD) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FHT_SIMD_NEON_
+#endif
+
 
 // -------------------- PRIVATE FUNCTIONS --------------------
 
@@ -158,6 +214,7 @@ FHT_API fht_ret_index_t fht_update(fht_t fht[const static 1], const char user_ke
 // The modifications work as the capacity of the hashtable is fixed.
 // If it wasn't, this function would return different indices as the capacity
 // of the hashtable changes thus making it absolutely useless.
+// The full hash is returned as the bits dropped by `% fht_cap` are what the control bytes use.
 static inline uint32_t fht_hash_small_string_(const char str[const static 1], const uint8_t len, const uint32_t fht_cap)
 {
   uint32_t hash = 0;
@@ -171,65 +228,367 @@ static inline uint32_t fht_hash_small_string_(const char str[const static 1], co
 
   hash += (hash >> shift) + len;
 
-  // TODO(mudit): mod is rarely simd-ed by the compiler. Maybe use doubles to manually
-  // calculate the remainder to force the compiler to simd?
+  return hash;
+}
+
+// Growable hashtables hash as if they always had FHT_MAX_KEYCOUNT capacity so that a key hashes
+// the same in the old and the new table while keys are migrated
+static inline uint32_t fht_hash_(const fht_t fht[const static 1], const char str[const static 1], const uint8_t len)
+{
+  return fht_hash_small_string_(str, len, fht->growable ? FHT_MAX_KEYCOUNT : fht->cap);
+}
+
+// TODO(mudit): mod is rarely simd-ed by the compiler. Maybe use doubles to manually
+// calculate the remainder to force the compiler to simd?
+static inline uint32_t fht_hash_index_(const uint32_t hash, const uint32_t fht_cap)
+{
   return hash % fht_cap;
 }
 
-static inline fht_ret_index_t fht_get_index_(const fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len)
+// 7 bit fragment of the hash stored in the control byte of a slot. The hash is mixed with a
+// multiplicative (fibonacci) hash first so that the top bits don't just repeat the index bits
+static inline uint8_t fht_hash_ctrl_(const uint32_t hash)
 {
-  dbg(">> key = %s, len = %u", user_key, user_key_len);
+  return (uint8_t)(0x80 | ((hash * 2654435769u) >> 25));
+}
 
-  FHT_ASSERT_NONNULL(fht);
-  FHT_ASSERT_NONNULL(user_key);
-  FHT_ASSERT_RANGE(user_key_len, 1, FHT_MAX_KEYLEN);
+// One bit per slot of a group that matched, lowest bit being the first slot. NEON has no movemask
+// so there the mask has 4 bits per slot out of which only the top one is kept
+typedef uint64_t fht_mask_t;
+
+#if defined(FHT_SIMD_NEON_)
+#define FHT_MASK_SHIFT_ 2
+#else
+#define FHT_MASK_SHIFT_ 0
+#endif
+
+static inline fht_mask_t fht_group_match_(const uint8_t group[const static FHT_GROUP_WIDTH], const uint8_t ctrl)
+{
+#if defined(FHT_SIMD_SSE2_)
+  const __m128i cmp = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)group), _mm_set1_epi8((char)ctrl));
+  return (uint16_t)_mm_movemask_epi8(cmp);
+#elif defined(FHT_SIMD_NEON_)
+  const uint8x16_t cmp = vceqq_u8(vld1q_u8(group), vdupq_n_u8(ctrl));
+  const uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x8888888888888888ull;
+#else
+  fht_mask_t mask = 0;
+  for (uint8_t i = 0; i < FHT_GROUP_WIDTH; i++) {
+    mask |= (fht_mask_t)(group[i] == ctrl) << i;
+  }
+  return mask;
+#endif
+}
+
+static inline fht_mask_t fht_group_match_empty_(const uint8_t group[const static FHT_GROUP_WIDTH])
+{
+#if defined(FHT_SIMD_SSE2_)
+  // only FHT_CTRL_EMPTY has its top bit clear so no compare needed
+  return (uint16_t)~_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+  return fht_group_match_(group, FHT_CTRL_EMPTY);
+#endif
+}
+
+// pops the lowest set bit of mask and returns its offset in the group
+static inline uint32_t fht_mask_next_(fht_mask_t *const mask)
+{
+  const uint32_t offset = (uint32_t)NONZERO_CTZG((unsigned long long)*mask) >> FHT_MASK_SHIFT_;
+  *mask &= *mask - 1;
+  return offset;
+}
+
+// slot at offset from index wrapping around the end of the hashtable. It can wrap more than once
+// when fht_cap < FHT_GROUP_WIDTH hence the mod in that unlikely branch
+static inline uint32_t fht_wrap_index_(const uint32_t index, const uint32_t fht_cap)
+{
+  return index < fht_cap ? index : index - fht_cap < fht_cap ? index - fht_cap : index % fht_cap;
+}
+
+// sets the control byte of index and its mirrors past the end of the array
+static inline void fht_set_ctrl_(fht_t fht[const static 1], const uint32_t index, const uint8_t ctrl)
+{
+  fht->ctrl[index] = ctrl;
 
+  for (uint32_t mirror = index; mirror < FHT_GROUP_WIDTH; mirror += fht->cap) {
+    fht->ctrl[fht->cap + mirror] = ctrl;
+  }
+}
+
+// looks user_key up in the keys of fht only, i.e., without looking at fht->old
+static inline fht_ret_index_t fht_get_index_(const fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len, const uint32_t hash)
+{
   // result.index here is 0 and should always be a valid index
   // as result.err is what disambiguates a valid index from an
   // invalid one
   fht_ret_index_t result = { .err = FHT_ERR_KEY_NOT_FOUND };
-  const uint32_t fht_count = fht->count;
-
-  if (fht_count == 0) {
-    result.err = FHT_ERR_HASHTABLE_EMPTY;
-    return result;
-  }
 
   const fht_key_t *keys = fht->keys;
+  const uint8_t *ctrl = fht->ctrl;
   const uint32_t fht_cap = fht->cap;
 
-  uint32_t lookup_index = fht_hash_small_string_(user_key, user_key_len, fht_cap);
-  uint32_t iterations = fht_cap; // this is to prevent an infinite lookup loop below
+  const uint8_t user_ctrl = fht_hash_ctrl_(hash);
+  uint32_t lookup_index = fht_hash_index_(hash, fht_cap);
+  // no key is further than max_dist from its slot which also prevents an infinite lookup loop below
+  // when the hashtable is full
+  uint32_t iterations = fht->max_dist / FHT_GROUP_WIDTH + 1;
 
-  // TODO(mudit): Should we loop unroll manually or let the compiler do it?
+  // Still linear probing, just FHT_GROUP_WIDTH slots at a time. Keys are only compared for slots whose
+  // control byte matches and an empty slot in the group ends the lookup as fht_add() would have used it
   while(iterations--) {
-    const fht_key_t curr_key = keys[lookup_index];
-    const uint8_t curr_key_len = curr_key.key_len;
-    const char *curr_key_start_ptr = curr_key.key;
+    const uint8_t *group = &ctrl[lookup_index];
 
-    // TODO(mudit): Can this branch be removed somehow?
-    if (curr_key_len == user_key_len &&
-        *user_key == *curr_key_start_ptr &&
-        memcmp(user_key, curr_key_start_ptr, user_key_len) == 0) {
-      result.err = FHT_ERR_NONE;
-      result.index = lookup_index;
+    for (fht_mask_t match = fht_group_match_(group, user_ctrl); match;) {
+      const uint32_t key_index = fht_wrap_index_(lookup_index + fht_mask_next_(&match), fht_cap);
+      const fht_key_t *curr_key = &keys[key_index];
 
+      if (curr_key->key_len == user_key_len && memcmp(user_key, curr_key->key, user_key_len) == 0) {
+        result.err = FHT_ERR_NONE;
+        result.index = key_index;
+
+        return result;
+      }
+    }
+
+    if (fht_group_match_empty_(group)) {
       return result;
     }
 
-    // TODO(mudit): User a better increment strategy than linear probing
-    // that can also always find a free spot if there is one
-    lookup_index++;
+    lookup_index = fht_wrap_index_(lookup_index + FHT_GROUP_WIDTH, fht_cap);
+  };
+
+  return result;
+}
+
+// Looks user_key up in fht and then in fht->old while keys are being migrated to fht.
+// table is set to whichever of the two the key was found in
+static inline fht_ret_index_t fht_find_(const fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len, const fht_t **table)
+{
+  dbg(">> key = %s, len = %u", user_key, user_key_len);
+
+  FHT_ASSERT_NONNULL(fht);
+  FHT_ASSERT_NONNULL(user_key);
+  FHT_ASSERT_RANGE(user_key_len, 1, FHT_MAX_KEYLEN);
+
+  *table = fht;
+
+  if (fht->count == 0) {
+    return (fht_ret_index_t){ .err = FHT_ERR_HASHTABLE_EMPTY };
+  }
 
-    // Wrap around as start index could be anywhere between 0 and fht->cap - 1.
-    // Tested using `% fht_cap` instead of this branch and that is WAY slower
-    // so taking the potential branch mispredict hit here instead
-    if (lookup_index >= fht_cap) {
-      lookup_index = 0;
+  const uint32_t hash = fht_hash_(fht, user_key, user_key_len);
+  fht_ret_index_t result = fht_get_index_(fht, user_key, user_key_len, hash);
+
+  if (result.err != FHT_ERR_NONE && fht->old) {
+    *table = fht->old;
+    result = fht_get_index_(fht->old, user_key, user_key_len, hash);
+  }
+
+  return result;
+}
+
+// Robin Hood insert of a key into a table with a free slot. Doesn't touch fht->count.
+// Returns the index the key ended up at
+static inline uint32_t fht_insert_(fht_t fht[const static 1], const fht_key_t user_key, const FHT_VALUE_TYPE val, const uint32_t hash)
+{
+  const uint32_t fht_cap = fht->cap;
+  uint32_t insert_index = fht_hash_index_(hash, fht_cap);
+
+  fht_key_t *const keys = fht->keys;
+  fht_value_t *const values = fht->values;
+  uint32_t *const dists = fht->dists;
+
+  // the key/value being placed which changes every time it takes over a slot from a key closer to its own slot
+  fht_key_t key = user_key;
+  fht_value_t value = { .val = val };
+  uint8_t ctrl = fht_hash_ctrl_(hash);
+  uint32_t dist = 0;
+
+  // the user key stays in the first slot it takes over which is the index returned
+  uint32_t user_key_index = UINT32_MAX;
+
+  // this is also what can cause an infinite loop if hashtable being full isn't checked before getting here
+  while (fht->ctrl[insert_index] != FHT_CTRL_EMPTY) {
+    if (dists[insert_index] < dist) {
+      const fht_key_t tmp_key = keys[insert_index];
+      const fht_value_t tmp_value = values[insert_index];
+      const uint8_t tmp_ctrl = fht->ctrl[insert_index];
+      const uint32_t tmp_dist = dists[insert_index];
+
+      keys[insert_index] = key;
+      values[insert_index] = value;
+      fht_set_ctrl_(fht, insert_index, ctrl);
+      dists[insert_index] = dist;
+      fht->max_dist = dist > fht->max_dist ? dist : fht->max_dist;
+
+      if (user_key_index == UINT32_MAX) {
+        user_key_index = insert_index;
+      }
+
+      key = tmp_key;
+      value = tmp_value;
+      ctrl = tmp_ctrl;
+      dist = tmp_dist;
     }
+
+    insert_index = fht_wrap_index_(insert_index + 1, fht_cap);
+    dist++;
   };
 
-  return result;
+  keys[insert_index] = key;
+  values[insert_index] = value;
+  fht_set_ctrl_(fht, insert_index, ctrl);
+  dists[insert_index] = dist;
+  fht->max_dist = dist > fht->max_dist ? dist : fht->max_dist;
+
+  return user_key_index == UINT32_MAX ? insert_index : user_key_index;
+}
+
+// Removes the key at index by shifting back every key after it that isn't in its own slot one slot
+// closer to it. Doesn't touch fht->count
+static inline void fht_remove_at_(fht_t fht[const static 1], const uint32_t index)
+{
+  fht_key_t *const keys = fht->keys;
+  fht_value_t *const values = fht->values;
+  uint32_t *const dists = fht->dists;
+  const uint32_t fht_cap = fht->cap;
+
+  uint32_t hole = index;
+  uint32_t next = fht_wrap_index_(hole + 1, fht_cap);
+
+  // The bound on iterations is for a full hashtable where the walk would come back around to the hole
+  for (uint32_t i = 1; i < fht_cap && fht->ctrl[next] != FHT_CTRL_EMPTY && dists[next] > 0; i++) {
+    keys[hole] = keys[next];
+    values[hole] = values[next];
+    fht_set_ctrl_(fht, hole, fht->ctrl[next]);
+    dists[hole] = dists[next] - 1;
+
+    hole = next;
+    next = fht_wrap_index_(next + 1, fht_cap);
+  }
+
+  fht_set_ctrl_(fht, hole, FHT_CTRL_EMPTY);
+}
+
+static inline void fht_free_table_(fht_t fht[const static 1])
+{
+  free(fht->keys);
+  free(fht->values);
+  free(fht->ctrl);
+  free(fht->dists);
+}
+
+// Moves the keys in the next FHT_MIGRATE_SLOTS slots of fht->old to fht and frees fht->old once it's empty.
+// Slots before migrate_index are always empty as removing a key only ever shifts the keys after it, so
+// every key left is at or after migrate_index
+static inline void fht_migrate_(fht_t fht[const static 1])
+{
+  fht_t *const old = fht->old;
+
+  for (uint32_t budget = FHT_MIGRATE_SLOTS; budget > 0 && old->count > 0; budget--) {
+    const uint32_t index = fht->migrate_index;
+
+    if (old->ctrl[index] == FHT_CTRL_EMPTY) {
+      fht->migrate_index++;
+      continue;
+    }
+
+    const fht_key_t key = old->keys[index];
+    fht_insert_(fht, key, old->values[index].val, fht_hash_(fht, key.key, key.key_len));
+
+    // the next key of the same run is shifted into index, so index is looked at again
+    fht_remove_at_(old, index);
+    old->count--;
+  }
+
+  if (old->count == 0) {
+    dbg("<< migrated %u slots", old->cap);
+
+    fht_free_table_(old);
+    free(old);
+    fht->old = NULL;
+    fht->migrate_index = 0;
+  }
+}
+
+static inline uint32_t fht_grown_cap_(const uint32_t fht_cap)
+{
+  return fht_cap > FHT_MAX_KEYCOUNT / 2 ? FHT_MAX_KEYCOUNT : fht_cap * 2;
+}
+
+// Zeroes the control bytes of the table fht_grow_() switches to next a few at a time from when the hashtable
+// is half full, as zeroing all of them at once in fht_grow_() would take as long as a memset() of twice the
+// capacity. 256 bytes per fht_add() is done well before the hashtable is 7/8 full
+static inline void fht_prepare_grow_(fht_t fht[const static 1])
+{
+  if (fht->cap >= FHT_MAX_KEYCOUNT || fht->count < fht->cap / 2) {
+    return;
+  }
+
+  const size_t size = (size_t)fht_grown_cap_(fht->cap) + FHT_GROUP_WIDTH;
+
+  if (fht->grow_ctrl == NULL) {
+    fht->grow_ctrl = malloc(size);
+    fht->grow_ctrl_zeroed = 0;
+  }
+
+  if (fht->grow_ctrl && fht->grow_ctrl_zeroed < size) {
+    const size_t left = size - fht->grow_ctrl_zeroed;
+    const size_t chunk = left < 256 ? left : 256;
+
+    memset(fht->grow_ctrl + fht->grow_ctrl_zeroed, FHT_CTRL_EMPTY, chunk);
+    fht->grow_ctrl_zeroed += chunk;
+  }
+}
+
+// Starts moving keys to a table with twice the capacity. The current table becomes fht->old and its keys
+// get migrated a few at a time by every fht_add(), fht_update() and fht_remove() after this. Nothing changes
+// if the table can't grow anymore or memory can't be allocated
+static inline void fht_grow_(fht_t fht[const static 1])
+{
+  // with FHT_MIGRATE_SLOTS >= 2 the last migration is done long before the hashtable is 7/8 full again,
+  // this is just so that there's never more than one old table
+  while (fht->old) {
+    fht_migrate_(fht);
+  }
+
+  if (fht->cap >= FHT_MAX_KEYCOUNT) {
+    return;
+  }
+
+  const uint32_t new_cap = fht_grown_cap_(fht->cap);
+  dbg(">> growing from %u to %u", fht->cap, new_cap);
+
+  // finishes zeroing if fht_prepare_grow_() couldn't, say when the hashtable was created almost full
+  fht_prepare_grow_(fht);
+  if (fht->grow_ctrl && fht->grow_ctrl_zeroed < (size_t)new_cap + FHT_GROUP_WIDTH) {
+    memset(fht->grow_ctrl + fht->grow_ctrl_zeroed, FHT_CTRL_EMPTY, new_cap + FHT_GROUP_WIDTH - fht->grow_ctrl_zeroed);
+  }
+
+  fht_t *const old = malloc(sizeof(*old));
+  fht_t grown = {
+    .cap = new_cap,
+    .count = fht->count,
+    .keys = malloc(sizeof(fht_key_t) * new_cap),
+    .values = malloc(sizeof(fht_value_t) * new_cap),
+    .ctrl = fht->grow_ctrl,
+    .dists = malloc(sizeof(uint32_t) * new_cap),
+    .old = old,
+    .growable = fht->growable,
+  };
+
+  if (old == NULL || grown.keys == NULL || grown.values == NULL || grown.ctrl == NULL || grown.dists == NULL) {
+    free(old);
+    free(grown.keys);
+    free(grown.values);
+    free(grown.dists);
+    return;
+  }
+
+  *old = *fht;
+  old->grow_ctrl = NULL;
+
+  *fht = grown;
 }
 
 
@@ -241,38 +600,71 @@ FHT_API fht_t fht_init(uint32_t count)
 {
   FHT_ASSERT_RANGE(count, 1, FHT_MAX_KEYCOUNT);
 
+  // calloc() as FHT_CTRL_EMPTY is 0 which lets fresh pages from the OS be used as is
   return (fht_t){
     .cap = count,
     .keys = malloc(sizeof(fht_key_t) * count),
     .values = malloc(sizeof(fht_value_t) * count),
+    .ctrl = calloc((size_t)count + FHT_GROUP_WIDTH, 1),
+    .dists = malloc(sizeof(uint32_t) * count),
   };
 }
 
+// Same as fht_init() except the hashtable grows instead of running out of space. count is only
+// the initial capacity. Once the hashtable is 7/8 full, fht_add() allocates a table
+// with twice the capacity and from then on every fht_add(), fht_update() and fht_remove() moves the
+// keys in FHT_MIGRATE_SLOTS slots of the old table to the new one. So no single call ever pays for
+// moving every key at once, and lookups look in both tables until the old one is empty.
+// It stops growing at FHT_MAX_KEYCOUNT.
+FHT_API fht_t fht_init_growable(uint32_t count)
+{
+  fht_t fht = fht_init(count);
+  fht.growable = 1;
+
+  return fht;
+}
+
 FHT_API void fht_deinit(fht_t fht[const static 1])
 {
   FHT_ASSERT_NONNULL(fht);
 
-  free(fht->keys);
-  free(fht->values);
-  fht->keys = NULL;
-  fht->values = NULL;
-  fht->cap = 0;
-  fht->count = 0;
+  if (fht->old) {
+    fht_free_table_(fht->old);
+    free(fht->old);
+  }
+
+  fht_free_table_(fht);
+  free(fht->grow_ctrl);
+  *fht = (fht_t){0};
 }
 
 FHT_API inline void fht_empty(fht_t fht[const static 1])
 {
   FHT_ASSERT_NONNULL(fht);
 
+  // not fht_free_table_() as that is static and this isn't
+  if (fht->old) {
+    free(fht->old->keys);
+    free(fht->old->values);
+    free(fht->old->ctrl);
+    free(fht->old->dists);
+    free(fht->old);
+    fht->old = NULL;
+    fht->migrate_index = 0;
+  }
+
   fht->count = 0;
+  fht->max_dist = 0;
+  memset(fht->ctrl, FHT_CTRL_EMPTY, fht->cap + FHT_GROUP_WIDTH);
 }
 
 FHT_API fht_ret_val_t fht_get(const fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len)
 {
-  const fht_ret_index_t get_result = fht_get_index_(fht, user_key, user_key_len);
+  const fht_t *table = NULL;
+  const fht_ret_index_t get_result = fht_find_(fht, user_key, user_key_len, &table);
   const fht_ret_val_t result = {
     .err = get_result.err,
-    .val = fht->values[get_result.index].val
+    .val = table->values[get_result.index].val
   };
 
   return result;
@@ -288,54 +680,33 @@ FHT_API fht_ret_index_t fht_add(fht_t fht[const static 1], const char user_key[c
 
   fht_ret_index_t result = {0};
 
-  const uint32_t fht_count = fht->count;
-  const uint32_t fht_cap = fht->cap;
+  if (fht->growable) {
+    if (fht->count >= fht->cap - fht->cap / 8) {
+      fht_grow_(fht);
+    } else {
+      fht_prepare_grow_(fht);
+    }
+  }
 
-  if (fht_count >= fht_cap) {
+  if (fht->old) {
+    fht_migrate_(fht);
+  }
+
+  // keys still in the old table will end up in this one too
+  if (fht->count >= fht->cap) {
     result.err = FHT_ERR_ADD_FAILED_OOM;
     return result;
   }
 
-  uint32_t insert_index = fht_hash_small_string_(user_key, user_key_len, fht_cap);
-  fht_key_t *const keys = fht->keys;
-  fht_key_t curr_key = keys[insert_index];
-  uint8_t curr_key_is_free = curr_key.key_len == 0;;
-
-  // collision
-  while(!curr_key_is_free) {
-    // TODO(mudit): User a better increment strategy than linear probing
-    // that can also always find a free spot if there is one
-    ++insert_index;
-
-    if (insert_index >= fht_cap) {
-      // wrap around <- this is also what can cause an infinite loop if
-      // hashtable being full isn't checked before getting here
-      insert_index = 0;
-    }
-
-    curr_key = keys[insert_index];
-    curr_key_is_free = curr_key.key_len == 0;
-  };
-
-  fht_value_t *const values = fht->values;
+  fht_key_t key = { .key_len = user_key_len };
+  memcpy(key.key, user_key, user_key_len);
 
-  fht_key_t *const new_key = &keys[insert_index];
-  fht_value_t *const new_val = &values[insert_index];
-
-  char *const new_key_start_ptr = new_key->key;
-
-  // add key
-  new_key->key_len = user_key_len;
-  memcpy(new_key_start_ptr, user_key, user_key_len);
-
-  // add value
-  new_val->val = val;
+  result.index = fht_insert_(fht, key, val, fht_hash_(fht, user_key, user_key_len));
 
   // increment count of stored key/vals
   fht->count++;
 
   result.err = FHT_ERR_NONE;
-  result.index = insert_index;
 
   return result;
 }
@@ -344,13 +715,47 @@ FHT_API fht_ret_index_t fht_update(fht_t fht[const static 1], const char user_ke
 {
   dbg(">> key = %s, len = %u", user_key, user_key_len);
 
-  fht_ret_index_t result = fht_get_index_(fht, user_key, user_key_len);
-  fht_value_t *values = fht->values;
+  if (fht->old) {
+    fht_migrate_(fht);
+  }
+
+  const fht_t *table = NULL;
+  fht_ret_index_t result = fht_find_(fht, user_key, user_key_len, &table);
 
   // key already exists, let's just update its value!
   if (result.err == FHT_ERR_NONE) {
-    values[result.index].val = val;
+    table->values[result.index].val = val;
+  }
+
+  return result;
+}
+
+FHT_API fht_ret_val_t fht_remove(fht_t fht[const static 1], const char user_key[const static 1], const uint8_t user_key_len)
+{
+  dbg(">> key = %s, len = %u", user_key, user_key_len);
+
+  if (fht->old) {
+    fht_migrate_(fht);
+  }
+
+  const fht_t *found_in = NULL;
+  const fht_ret_index_t get_result = fht_find_(fht, user_key, user_key_len, &found_in);
+  fht_ret_val_t result = { .err = get_result.err };
+
+  if (get_result.err != FHT_ERR_NONE) {
+    return result;
+  }
+
+  // found_in is either fht or fht->old, both of which are writable
+  fht_t *const table = found_in == fht ? fht : fht->old;
+  result.val = table->values[get_result.index].val;
+
+  fht_remove_at_(table, get_result.index);
+
+  if (table != fht) {
+    table->count--;
   }
+  fht->count--;
 
   return result;
 }
@@ -52,11 +52,22 @@
 #define GB_MIN_GAP_SIZE sizeof(char) * 16
 #endif // GB_MIN_GAP_SIZE
 
+/*
+ * Defining GB_ALLOCATOR_ENABLE gives gb_t a `mem_allocator_t *allocator` member. When it is NULL gb->buf
+ * is managed with GB_REALLOC and GB_FREE as usual, otherwise with the given allocator (see zdx_memory.h).
+ */
+#ifdef GB_ALLOCATOR_ENABLE
+#include "./zdx_memory.h"
+#endif // GB_ALLOCATOR_ENABLE
+
 typedef struct gap_buffer {
   char *buf;
   size_t gap_start_;
   size_t gap_end_;
   size_t length;
+#ifdef GB_ALLOCATOR_ENABLE
+  mem_allocator_t *allocator;
+#endif // GB_ALLOCATOR_ENABLE
 } gb_t;
 
 void gb_init(gb_t gb[const static 1]);
@@ -83,6 +94,28 @@ size_t gb_copy_chars_as_cstr(gb_t gb[const static 1], char dst_cstr[const static
 #include <string.h>
 #include <inttypes.h>
 
+#ifdef GB_ALLOCATOR_ENABLE
+#define gb_alloc_buf_(gb, sz) ((gb)->allocator ? (gb)->allocator->alloc((gb)->allocator, (sz)) : GB_REALLOC(NULL, (sz)))
+
+#define gb_realloc_buf_(gb, old_sz, new_sz)                                    \
+  ((gb)->allocator                                                             \
+   ? (gb)->allocator->realloc((gb)->allocator, (gb)->buf, (old_sz), (new_sz))  \
+   : GB_REALLOC((gb)->buf, (new_sz)))
+
+#define gb_free_buf_(gb)                                  \
+  do {                                                    \
+    if ((gb)->allocator) {                                \
+      (gb)->allocator->free((gb)->allocator, (gb)->buf);  \
+    } else {                                              \
+      GB_FREE((gb)->buf);                                 \
+    }                                                     \
+  } while(0)
+#else
+#define gb_alloc_buf_(gb, sz) GB_REALLOC(NULL, (sz))
+#define gb_realloc_buf_(gb, old_sz, new_sz) ((void)(old_sz), GB_REALLOC((gb)->buf, (new_sz)))
+#define gb_free_buf_(gb) GB_FREE((gb)->buf)
+#endif // GB_ALLOCATOR_ENABLE
+
 #ifdef ZDX_TRACE_ENABLE
 #define gb_dbg(label, gb) do {                                         \
     /*
@@ -137,11 +170,12 @@ static void gb_resize_gap_(gb_t gb[const static 1], size_t new_gap_len)
   }
 
   const size_t curr_gap_len = gb_gap_len(gb);
-  const size_t buf_new_len = gb->length + curr_gap_len + new_gap_len;
+  const size_t buf_old_len = gb->length + curr_gap_len;
+  const size_t buf_new_len = buf_old_len + new_gap_len;
 
   dbg(">> curr gap %zu \t| new gap %zu", curr_gap_len, new_gap_len);
 
-  gb->buf = GB_REALLOC(gb->buf, buf_new_len * sizeof(char));
+  gb->buf = gb_realloc_buf_(gb, buf_old_len * sizeof(char), buf_new_len * sizeof(char));
   GB_ASSERT(gb->buf != NULL, "[zdx str] Allocation failed for resizing gb->buf to expand gap");
 
   // { -> gap start marker
@@ -208,7 +242,7 @@ void gb_init(gb_t gb[const static 1])
   const size_t init_size = GB_INIT_LENGTH > GB_MIN_GAP_SIZE ? GB_INIT_LENGTH : GB_MIN_GAP_SIZE;
 
   /* can be replaced with gb_resize_gap_(gb, init_size) but that does checks we don't need here */
-  gb->buf = GB_REALLOC(NULL, init_size * sizeof(char));
+  gb->buf = gb_alloc_buf_(gb, init_size * sizeof(char));
   GB_ASSERT(gb->buf != NULL, "[zdx str] Allocation failed for initializing gb->buf to default capacity");
 
   gb->length = 0;
@@ -219,11 +253,12 @@ void gb_init(gb_t gb[const static 1])
   return;
 }
 
+/* gb->allocator, if any, is left as is so the gap buffer can be re-initialized with the same allocator */
 void gb_deinit(gb_t gb[const static 1])
 {
   gb_dbg(">>", gb);
 
-  GB_FREE(gb->buf);
+  gb_free_buf_(gb);
   gb->buf = NULL;
   gb->length = 0;
   gb->gap_start_ = 0;
@@ -31,12 +31,23 @@ _Static_assert(false, "HT_VALUE_TYPE must be concrete defined type");
 
 #include <stddef.h>
 
+/*
+ * Defining HT_ALLOCATOR_ENABLE gives ht_t a `mem_allocator_t *allocator` member. When it is NULL ht->items
+ * is managed with HT_CALLOC and HT_FREE as usual, otherwise with the given allocator (see zdx_memory.h).
+ */
+#ifdef HT_ALLOCATOR_ENABLE
+#include "./zdx_memory.h"
+#endif // HT_ALLOCATOR_ENABLE
+
 typedef struct hashtable_item_t ht_item_t;
 
 typedef struct hashtable_t {
   ht_item_t *items;
   size_t length;
   size_t capacity;
+#ifdef HT_ALLOCATOR_ENABLE
+  mem_allocator_t *allocator;
+#endif // HT_ALLOCATOR_ENABLE
 } ht_t;
 
 typedef struct hashtable_return_t {
@@ -101,6 +112,31 @@ _Static_assert(false, "HT_CALLOC must be defined if HT_FREE is");
 #define HT_FREE(ptr) free((ptr))
 #endif // HT_FREE
 
+#ifdef HT_ARENA_TYPE
+#define ht_calloc_default_(count) HT_CALLOC(arena, (count), sizeof(ht_item_t))
+#else
+#define ht_calloc_default_(count) HT_CALLOC((count), sizeof(ht_item_t))
+#endif // HT_ARENA_TYPE
+
+#ifdef HT_ALLOCATOR_ENABLE
+#define ht_calloc_items_(ht, count)                                                     \
+  ((ht)->allocator                                                                      \
+   ? (ht)->allocator->calloc((ht)->allocator, (count), sizeof(ht_item_t))               \
+   : ht_calloc_default_(count))
+
+#define ht_free_items_(ht, items)                         \
+  do {                                                    \
+    if ((ht)->allocator) {                                \
+      (ht)->allocator->free((ht)->allocator, (items));    \
+    } else {                                              \
+      HT_FREE((items));                                   \
+    }                                                     \
+  } while(0)
+#else
+#define ht_calloc_items_(ht, count) ht_calloc_default_(count)
+#define ht_free_items_(ht, items) HT_FREE((items))
+#endif // HT_ALLOCATOR_ENABLE
+
 struct hashtable_item_t {
   bool occupied;
   size_t key_length;
@@ -214,11 +250,7 @@ static ht_ret_t ht_resize(ht_t ht[const static 1])
     ht->length = 0;
     ht->capacity = 0;
     ht->items = NULL;
-#ifdef HT_ARENA_TYPE
-    ht->items = HT_CALLOC(arena, HT_MIN_CAPACITY, sizeof(*ht->items));
-#else
-    ht->items = HT_CALLOC(HT_MIN_CAPACITY, sizeof(*ht->items));
-#endif // HT_ARENA_TYPE
+    ht->items = ht_calloc_items_(ht, HT_MIN_CAPACITY);
 
     if (!ht->items) {
       // TODO: Is this safe or should arena->err be duplicated? 🤔 It should be safe since arena->err are all string literals IIRC but do confirm it
@@ -259,11 +291,7 @@ static ht_ret_t ht_resize(ht_t ht[const static 1])
 
   /* reallocate ht->items if the new capacity is different from current capacity */
   if (new_cap != ht->capacity) {
-#ifdef HT_ARENA_TYPE
-    ht->items = HT_CALLOC(arena, new_cap, sizeof(*ht->items));
-#else
-    ht->items = HT_CALLOC(new_cap, sizeof(*ht->items));
-#endif // HT_ARENA_TYPE
+    ht->items = ht_calloc_items_(ht, new_cap);
 
     if (!ht->items) {
       // TODO: Is this safe or should arena->err be duplicated? 🤔 It should be safe since arena->err are all string literals IIRC
@@ -303,7 +331,7 @@ static ht_ret_t ht_resize(ht_t ht[const static 1])
 
     ht->length = moved;
 
-    HT_FREE(old_items);
+    ht_free_items_(ht, old_items);
   }
 
   ht_dbg("..", ht);
@@ -427,10 +455,11 @@ HT_API ht_ret_t ht_remove(ht_t ht[const static 1], const char key[const static 1
   return result;
 }
 
+/* ht->allocator, if any, is left as is so the hashtable can be reused with the same allocator */
 HT_API void ht_free(ht_t ht[const static 1])
 {
   ht_dbg(">>", ht);
-  HT_FREE(ht->items);
+  ht_free_items_(ht, ht->items);
   ht->items = NULL;
   ht->capacity = 0;
   ht->length = 0;
@@ -7,11 +7,15 @@
 
 #ifdef ZDX_MEMORY_IMPLEMENTATION_AUTO
 #  define ZDX_STRING_VIEW_IMPLEMENTATION
+#  define ZDX_SIMPLE_ARENA_IMPLEMENTATION
 #  define ZDX_MEMORY_IMPLEMENTATION
 #endif // ZDX_MEMORY_IMPLEMENTATION_AUTO
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h> /* for FILE in mem_prof_dump */
 #include "zdx_string_view.h"
+#include "zdx_simple_arena.h"
 #include "zdx_util.h"
 
 typedef struct mem_allocator_t mem_allocator_t;
@@ -50,6 +54,174 @@ typedef struct mem_allocator_t {
 } mem_allocator_t;
 
 MEM_API mem_allocator_t mem_gpa_init(const char name_cstr[const static 1]);
+MEM_API mem_allocator_t mem_slab_init(const char name_cstr[const static 1]);
+MEM_API mem_allocator_t mem_tcache_init(const char name_cstr[const static 1]);
+MEM_API mem_allocator_t mem_arena_init(const char name_cstr[const static 1], arena_t *const ar);
+
+// ----------------------------------------------------------------------------------------------------------------
+// Tracing allocator
+
+#define MEM_TRACE_MAGIC "ZDXTRACE"
+#define MEM_TRACE_VERSION 1
+
+typedef enum mem_trace_op_t {
+  MEM_TRACE_ALLOC = 1,
+  MEM_TRACE_CALLOC,
+  MEM_TRACE_REALLOC,
+  MEM_TRACE_FREE,
+  MEM_TRACE_EMPTY,
+} mem_trace_op_t;
+
+// written once at the start of a trace file, followed by mem_trace_record_t's until EOF.
+// Fields are fixed width and in host byte order.
+typedef struct mem_trace_header_t {
+  char magic[8];         // MEM_TRACE_MAGIC without the NUL
+  uint32_t version;      // MEM_TRACE_VERSION
+  uint32_t record_size;  // sizeof(mem_trace_record_t)
+} mem_trace_header_t;
+
+typedef struct mem_trace_record_t {
+  uint64_t ns;    // since the tracing allocator was created
+  uint64_t size;  // requested size (count * size for calloc, new size for realloc, 0 for free/empty)
+  uint32_t id;    // allocations are numbered from 1 in order. realloc keeps the id, 0 for empty
+  uint8_t op;     // mem_trace_op_t
+  uint8_t reserved[3];
+} mem_trace_record_t;
+
+MEM_API mem_allocator_t mem_trace_init(const char name_cstr[const static 1], const mem_allocator_t *const inner,
+                                       const char path[const static 1]);
+
+// ----------------------------------------------------------------------------------------------------------------
+// Buddy allocator
+
+// smallest block handed out is 1 << MEM_BUDDY_MIN_SHIFT bytes.
+// Free blocks hold two list pointers so it can't go below 4
+#ifndef MEM_BUDDY_MIN_SHIFT
+#define MEM_BUDDY_MIN_SHIFT 4
+#endif // MEM_BUDDY_MIN_SHIFT
+
+// internal fragmentation is 1 - (requested bytes / allocated_bytes), which only the caller knows the numerator of.
+// external fragmentation is 1 - (largest_free / free_bytes) i.e. how much free memory can't be handed out in one go
+typedef struct mem_buddy_stats_t {
+  size_t capacity;         // size of the whole region, a power of 2
+  size_t allocated_bytes;  // sum of the sizes of the blocks handed out, requests are rounded up to a power of 2
+  size_t free_bytes;       // capacity - allocated_bytes
+  size_t largest_free;     // biggest block that can be handed out right now
+  size_t free_blocks;
+  size_t alloc_count;
+  size_t free_count;
+  size_t failed_count;
+} mem_buddy_stats_t;
+
+MEM_API mem_allocator_t mem_buddy_init(const char name_cstr[const static 1], const size_t sz);
+MEM_API mem_buddy_stats_t mem_buddy_stats(const mem_allocator_t *const al);
+
+// ----------------------------------------------------------------------------------------------------------------
+// Static binding
+//
+// Calls through the vtable (al->alloc(al, sz)) are indirect and can't be inlined. A translation unit that
+// includes the implementation can pick one allocator at compile time by defining MEM_STATIC_BACKEND before
+// including this header, after which the mem_static_*() macros call that allocator's functions directly.
+// Without MEM_STATIC_BACKEND they fall back to the vtable so the same code works with either.
+//
+// MEM_STATIC_BACKEND must be one of gpa, slab, tcache, buddy, arena_adapter, prof or trace and every allocator
+// passed to the mem_static_*() macros must have been created by the matching mem_*_init() (checked by MEM_ASSERT).
+//
+// #define MEM_STATIC_BACKEND arena_adapter
+// #define ZDX_MEMORY_IMPLEMENTATION_AUTO
+// #include "zdx_memory.h"
+// ...
+// mem_allocator_t al = mem_arena_init("frame", &arena);
+// node_t *n = mem_static_alloc(&al, sizeof(*n)); // direct call to arena_adapter_malloc()
+
+#ifdef MEM_STATIC_BACKEND
+
+#ifndef ZDX_MEMORY_IMPLEMENTATION
+#error "MEM_STATIC_BACKEND needs ZDX_MEMORY_IMPLEMENTATION in the same translation unit"
+#endif // ZDX_MEMORY_IMPLEMENTATION
+
+#define MEM_STATIC_CONCAT_(a, b) a##b
+#define MEM_STATIC_FN_(backend, op) MEM_STATIC_CONCAT_(backend, op)
+#define MEM_STATIC_CALL_(al, op, fn_field, ...)                                                              \
+  (MEM_ASSERT((al)->fn_field == MEM_STATIC_FN_(MEM_STATIC_BACKEND, op),                                      \
+              "Expected: allocator of the MEM_STATIC_BACKEND type, Received: "SV_FMT, sv_fmt_args((al)->name)), \
+   MEM_STATIC_FN_(MEM_STATIC_BACKEND, op)((al), __VA_ARGS__))
+
+#define mem_static_alloc(al, sz) MEM_STATIC_CALL_((al), _malloc, alloc, (sz))
+#define mem_static_calloc(al, count, sz) MEM_STATIC_CALL_((al), _calloc, calloc, (count), (sz))
+#define mem_static_realloc(al, ptr, old_sz, new_sz) MEM_STATIC_CALL_((al), _realloc, realloc, (ptr), (old_sz), (new_sz))
+#define mem_static_free(al, ptr) MEM_STATIC_CALL_((al), _free, free, (ptr))
+#define mem_static_empty(al)                                                                                 \
+  (MEM_ASSERT((al)->empty == MEM_STATIC_FN_(MEM_STATIC_BACKEND, _empty),                                     \
+              "Expected: allocator of the MEM_STATIC_BACKEND type, Received: "SV_FMT, sv_fmt_args((al)->name)), \
+   MEM_STATIC_FN_(MEM_STATIC_BACKEND, _empty)((al)))
+
+#else
+
+#define mem_static_alloc(al, sz) ((al)->alloc((al), (sz)))
+#define mem_static_calloc(al, count, sz) ((al)->calloc((al), (count), (sz)))
+#define mem_static_realloc(al, ptr, old_sz, new_sz) ((al)->realloc((al), (ptr), (old_sz), (new_sz)))
+#define mem_static_free(al, ptr) ((al)->free((al), (ptr)))
+#define mem_static_empty(al) ((al)->empty((al)))
+
+#endif // MEM_STATIC_BACKEND
+
+// ----------------------------------------------------------------------------------------------------------------
+// Profiling allocator
+
+// distinct call sites tracked per profiling allocator. Must be a power of 2
+#ifndef MEM_PROF_MAX_SITES
+#define MEM_PROF_MAX_SITES 256
+#endif // MEM_PROF_MAX_SITES
+
+#define MEM_PROF_HISTOGRAM_BUCKETS 32
+
+typedef struct mem_prof_site_t {
+  const char *file;  // NULL for an unused slot
+  int line;
+  size_t alloc_count;
+  size_t total_bytes;
+  size_t live_bytes;
+  size_t peak_bytes;
+} mem_prof_site_t;
+
+typedef struct mem_prof_stats_t {
+  size_t live_bytes;
+  size_t peak_bytes;
+  size_t total_bytes;
+  size_t alloc_count;
+  size_t calloc_count;
+  size_t realloc_count;
+  size_t free_count;
+  size_t empty_count;
+  size_t failed_count;
+  size_t dropped_sites;  // allocations whose call site didn't fit in MEM_PROF_MAX_SITES
+  // histogram[i] counts requests of i significant bits i.e. [2^(i-1), 2^i) bytes. The last bucket takes the rest
+  size_t histogram[MEM_PROF_HISTOGRAM_BUCKETS];
+} mem_prof_stats_t;
+
+MEM_API mem_allocator_t mem_prof_init(const char name_cstr[const static 1], const mem_allocator_t *const inner);
+MEM_API mem_prof_stats_t mem_prof_stats(const mem_allocator_t *const al);
+MEM_API void mem_prof_dump(const mem_allocator_t *const al, FILE *const stream);
+
+MEM_API void *mem_alloc_at(const mem_allocator_t *const al, const size_t sz, const char *const file, const int line);
+MEM_API void *mem_calloc_at(const mem_allocator_t *const al, const size_t count, const size_t sz,
+                            const char *const file, const int line);
+MEM_API void *mem_realloc_at(const mem_allocator_t *const al, void *ptr, const size_t old_sz, const size_t new_sz,
+                             const char *const file, const int line);
+
+/*
+ * Call site aware wrappers around the vtable of any allocator. They behave exactly like calling
+ * al->alloc(al, ...) etc. directly but when al is a profiling allocator (see mem_prof_init())
+ * the allocation is also aggregated under the __FILE__:__LINE__ it was made from.
+ *
+ * int *a = mem_alloc(&al, sizeof(*a) * 10);
+ * mem_free(&al, a);
+ */
+#define mem_alloc(al, sz) mem_alloc_at((al), (sz), __FILE__, __LINE__)
+#define mem_calloc(al, count, sz) mem_calloc_at((al), (count), (sz), __FILE__, __LINE__)
+#define mem_realloc(al, ptr, old_sz, new_sz) mem_realloc_at((al), (ptr), (old_sz), (new_sz), __FILE__, __LINE__)
+#define mem_free(al, ptr) ((al)->free((al), (ptr)))
 
 // ----------------------------------------------------------------------------------------------------------------
 
@@ -57,6 +229,12 @@ MEM_API mem_allocator_t mem_gpa_init(const char name_cstr[const static 1]);
 #ifdef ZDX_MEMORY_IMPLEMENTATION
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
 
 #ifndef MEM_ASSERT
 #define MEM_ASSERT assertm
@@ -178,5 +356,2094 @@ MEM_API mem_allocator_t mem_gpa_init(const char name_cstr[const static 1])
   return allocator;
 }
 
+// ----------------------------------------------------------------------------------------------------------------
+// Slab allocator
+
+// Every slab is mapped at an address aligned to its own size so that the slab header of any
+// pointer handed out can be found by masking off the low bits of the pointer. Must be a power of 2.
+#ifndef MEM_SLAB_SIZE
+#define MEM_SLAB_SIZE (64 * 1024)
+#endif // MEM_SLAB_SIZE
+
+// size classes are powers of 2 from 1 << MEM_SLAB_MIN_CLASS_SHIFT to 1 << MEM_SLAB_MAX_CLASS_SHIFT.
+// Anything bigger gets a dedicated mapping of its own.
+#ifndef MEM_SLAB_MIN_CLASS_SHIFT
+#define MEM_SLAB_MIN_CLASS_SHIFT 4
+#endif // MEM_SLAB_MIN_CLASS_SHIFT
+
+#ifndef MEM_SLAB_MAX_CLASS_SHIFT
+#define MEM_SLAB_MAX_CLASS_SHIFT 11
+#endif // MEM_SLAB_MAX_CLASS_SHIFT
+
+#define MEM_SLAB_CLASS_COUNT (MEM_SLAB_MAX_CLASS_SHIFT - MEM_SLAB_MIN_CLASS_SHIFT + 1)
+#define MEM_SLAB_LARGE_CLASS ((uint32_t)-1)
+
+_Static_assert((MEM_SLAB_SIZE & (MEM_SLAB_SIZE - 1)) == 0, "MEM_SLAB_SIZE must be a power of 2");
+_Static_assert(((size_t)1 << MEM_SLAB_MAX_CLASS_SHIFT) * 8 <= MEM_SLAB_SIZE,
+               "MEM_SLAB_SIZE must fit at least a handful of objects of the largest size class");
+
+typedef struct mem_slab_t {
+  struct mem_slab_t *next;
+  struct mem_slab_t *prev;  // only used by large slabs, which are unlinked individually on free
+  uint32_t class_idx;       // MEM_SLAB_LARGE_CLASS for dedicated large mappings
+  size_t obj_sz;            // usable size of every object in this slab
+  size_t map_sz;
+  char *bump;               // next never-handed-out object
+  char *end;
+} mem_slab_t;
+
+// slab header is padded so that objects start max_align_t aligned
+#define MEM_SLAB_HEADER_SIZE \
+  ((sizeof(mem_slab_t) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+typedef struct mem_slab_free_t {
+  struct mem_slab_free_t *next;
+} mem_slab_free_t;
+
+typedef struct mem_slab_class_t {
+  mem_slab_free_t *free_list;  // intrusive list threaded through freed objects
+  mem_slab_t *slabs;           // every slab of this class, kept across empty()
+  mem_slab_t *curr;            // slab being bump allocated from
+} mem_slab_class_t;
+
+typedef struct mem_slab_ctx_t {
+  mem_slab_class_t classes[MEM_SLAB_CLASS_COUNT];
+  mem_slab_t *large;
+} mem_slab_ctx_t;
+
+static inline mem_slab_t *slab_of_(const void *const ptr)
+{
+  return (mem_slab_t *)((uintptr_t)ptr & ~(uintptr_t)(MEM_SLAB_SIZE - 1));
+}
+
+static inline uint32_t slab_class_idx_(const size_t sz)
+{
+  uint32_t idx = 0;
+
+  while (((size_t)1 << (idx + MEM_SLAB_MIN_CLASS_SHIFT)) < sz) {
+    idx++;
+  }
+
+  return idx;
+}
+
+/* maps sz bytes at a MEM_SLAB_SIZE aligned address by over-mapping and trimming the excess */
+static mem_slab_t *slab_map_(const size_t sz)
+{
+  char *mem = mmap(NULL, sz + MEM_SLAB_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+  if (mem == MAP_FAILED) {
+    return NULL;
+  }
+
+  uintptr_t start = (uintptr_t)mem;
+  uintptr_t aligned_start = (start + MEM_SLAB_SIZE - 1) & ~(uintptr_t)(MEM_SLAB_SIZE - 1);
+  size_t head = aligned_start - start;
+  size_t tail = MEM_SLAB_SIZE - head;
+
+  if (head) {
+    munmap(mem, head);
+  }
+  if (tail) {
+    munmap((void *)(aligned_start + sz), tail);
+  }
+
+  mem_slab_t *slab = (mem_slab_t *)aligned_start;
+  slab->map_sz = sz;
+
+  return slab;
+}
+
+#define MEM_DEFAULT_PAGE_SIZE_IF_UNDEF 4096
+
+/* This function never fails and falls back to MEM_DEFAULT_PAGE_SIZE_IF_UNDEF if sysconf does */
+static inline size_t mem_page_size_(void)
+{
+  long page_size = sysconf(_SC_PAGESIZE);
+
+  /* sysconf failed (-1) or returned 0 for some reason */
+  return page_size <= 0 ? MEM_DEFAULT_PAGE_SIZE_IF_UNDEF : (size_t)page_size;
+}
+
+static void *slab_alloc_large_(mem_slab_ctx_t *const ctx, const size_t sz)
+{
+  const size_t page_size = mem_page_size_();
+
+  if (sz > SIZE_MAX - MEM_SLAB_HEADER_SIZE - page_size - MEM_SLAB_SIZE) {
+    return NULL;
+  }
+
+  const size_t map_sz = (MEM_SLAB_HEADER_SIZE + sz + page_size - 1) & ~(page_size - 1);
+  mem_slab_t *slab = slab_map_(map_sz);
+
+  if (slab == NULL) {
+    return NULL;
+  }
+
+  slab->class_idx = MEM_SLAB_LARGE_CLASS;
+  slab->obj_sz = map_sz - MEM_SLAB_HEADER_SIZE;
+  slab->bump = (char *)slab + map_sz;
+  slab->end = slab->bump;
+
+  slab->prev = NULL;
+  slab->next = ctx->large;
+  if (ctx->large) {
+    ctx->large->prev = slab;
+  }
+  ctx->large = slab;
+
+  return (char *)slab + MEM_SLAB_HEADER_SIZE;
+}
+
+static void slab_free_large_(mem_slab_ctx_t *const ctx, mem_slab_t *const slab)
+{
+  if (slab->prev) {
+    slab->prev->next = slab->next;
+  } else {
+    ctx->large = slab->next;
+  }
+  if (slab->next) {
+    slab->next->prev = slab->prev;
+  }
+
+  munmap(slab, slab->map_sz);
+}
+
+static void *slab_alloc_small_(mem_slab_ctx_t *const ctx, const uint32_t class_idx)
+{
+  mem_slab_class_t *const cls = &ctx->classes[class_idx];
+
+  if (cls->free_list) {
+    mem_slab_free_t *obj = cls->free_list;
+    cls->free_list = obj->next;
+    return obj;
+  }
+
+  const size_t obj_sz = (size_t)1 << (class_idx + MEM_SLAB_MIN_CLASS_SHIFT);
+
+  // the current slab is exhausted; move on to the next one retained from before an empty()
+  while (cls->curr && cls->curr->bump + obj_sz > cls->curr->end) {
+    cls->curr = cls->curr->next;
+  }
+
+  if (cls->curr == NULL) {
+    mem_slab_t *slab = slab_map_(MEM_SLAB_SIZE);
+
+    if (slab == NULL) {
+      return NULL;
+    }
+
+    slab->class_idx = class_idx;
+    slab->obj_sz = obj_sz;
+    slab->bump = (char *)slab + MEM_SLAB_HEADER_SIZE;
+    slab->end = (char *)slab + MEM_SLAB_SIZE;
+    slab->prev = NULL;
+
+    // new slabs go at the head, all older slabs are known to be full
+    slab->next = cls->slabs;
+    cls->slabs = slab;
+    cls->curr = slab;
+  }
+
+  void *ptr = cls->curr->bump;
+  cls->curr->bump += obj_sz;
+
+  return ptr;
+}
+
+/* drops every object at once. Small slabs stay mapped and are rewound so the next round of
+   allocations doesn't pay for mmap and page faults again, large objects are unmapped */
+static void slab_ctx_empty_(mem_slab_ctx_t *const ctx)
+{
+  for (size_t i = 0; i < MEM_SLAB_CLASS_COUNT; i++) {
+    mem_slab_class_t *cls = &ctx->classes[i];
+
+    for (mem_slab_t *slab = cls->slabs; slab; slab = slab->next) {
+      slab->bump = (char *)slab + MEM_SLAB_HEADER_SIZE;
+    }
+
+    cls->free_list = NULL;
+    cls->curr = cls->slabs;
+  }
+
+  mem_slab_t *slab = ctx->large;
+  while (slab) {
+    mem_slab_t *next = slab->next;
+    munmap(slab, slab->map_sz);
+    slab = next;
+  }
+  ctx->large = NULL;
+}
+
+/* unmaps every slab */
+static void slab_ctx_release_(mem_slab_ctx_t *const ctx)
+{
+  slab_ctx_empty_(ctx);
+
+  for (size_t i = 0; i < MEM_SLAB_CLASS_COUNT; i++) {
+    mem_slab_t *slab = ctx->classes[i].slabs;
+
+    while (slab) {
+      mem_slab_t *next = slab->next;
+      munmap(slab, slab->map_sz);
+      slab = next;
+    }
+
+    ctx->classes[i] = (mem_slab_class_t){0};
+  }
+}
+
+static void *slab_malloc(const mem_allocator_t *const al, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: size = %zu", sv_fmt_args(al->name), sz);
+
+  mem_slab_ctx_t *ctx = al->ctx;
+  void *ptr = NULL;
+
+  if (sz > ((size_t)1 << MEM_SLAB_MAX_CLASS_SHIFT)) {
+    ptr = slab_alloc_large_(ctx, sz);
+  } else {
+    ptr = slab_alloc_small_(ctx, slab_class_idx_(sz));
+  }
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void *slab_calloc(const mem_allocator_t *const al, const size_t count, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]: count = %zu, size = %zu",
+      sv_fmt_args(al->name), count, sz);
+
+  if (sz && count > SIZE_MAX / sz) {
+    dbg("<< [allocator "SV_FMT"]: overflow", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  void *ptr = slab_malloc(al, count * sz);
+
+  // freed objects are recycled as is so zero them unconditionally
+  if (ptr) {
+    memset(ptr, 0, count * sz);
+  }
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void slab_free(const mem_allocator_t *const al, void *ptr)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p", sv_fmt_args(al->name), ptr);
+
+  if (ptr == NULL) {
+    dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+    return;
+  }
+
+  mem_slab_ctx_t *ctx = al->ctx;
+  mem_slab_t *slab = slab_of_(ptr);
+
+  if (slab->class_idx == MEM_SLAB_LARGE_CLASS) {
+    slab_free_large_(ctx, slab);
+  } else {
+    MEM_ASSERT(slab->class_idx < MEM_SLAB_CLASS_COUNT,
+               "Expected: ptr from this allocator, Received: %p with class %u", ptr, slab->class_idx);
+
+    mem_slab_free_t *obj = ptr;
+    obj->next = ctx->classes[slab->class_idx].free_list;
+    ctx->classes[slab->class_idx].free_list = obj;
+  }
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void *slab_realloc(const mem_allocator_t *const al, void *ptr, const size_t old_sz, const size_t new_sz)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p, old size = %zu, new size = %zu",
+      sv_fmt_args(al->name), ptr, old_sz, new_sz);
+
+  if (ptr == NULL) {
+    return slab_malloc(al, new_sz);
+  }
+
+  const mem_slab_t *slab = slab_of_(ptr);
+
+  // still fits in the object it already has (size classes round up so this is common)
+  if (new_sz <= slab->obj_sz) {
+    dbg("<< [allocator "SV_FMT"]: realloced ptr = %p (in place)", sv_fmt_args(al->name), ptr);
+    return ptr;
+  }
+
+  void *new_ptr = slab_malloc(al, new_sz);
+
+  if (new_ptr) {
+    memcpy(new_ptr, ptr, old_sz < slab->obj_sz ? old_sz : slab->obj_sz);
+    slab_free(al, ptr);
+  }
+
+  dbg("<< [allocator "SV_FMT"]: realloced ptr = %p", sv_fmt_args(al->name), new_ptr);
+  return new_ptr;
+}
+
+static void slab_empty(const mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  slab_ctx_empty_(al->ctx);
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void slab_deinit(mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  sv_t name = al->name;
+  (void) name;
+
+  if (al->ctx) {
+    slab_ctx_release_(al->ctx);
+  }
+
+  al->name = (sv_t){0};
+  free(al->ctx);
+  al->ctx = NULL;
+
+  dbg("<< [allocator "SV_FMT"] Destroyed!", sv_fmt_args(name));
+}
+
+/**
+ * Slab allocator
+ *   This function initializes an allocator that serves requests up to
+ *   1 << MEM_SLAB_MAX_CLASS_SHIFT bytes from power of 2 size classes carved out of
+ *   MEM_SLAB_SIZE byte mmap'd slabs. Freed objects go on a per size class free list and
+ *   are handed out again before any new memory is touched. Bigger requests get a
+ *   dedicated mapping that is unmapped on free.
+ *
+ *   empty() drops every live object at once while keeping the small slabs mapped for reuse.
+ *   deinit() unmaps everything.
+ *
+ * Example:
+ *   mem_allocator_t slab = mem_slab_init("nodes");
+ *   node_t *n = slab.alloc(&slab, sizeof(*n));
+ *   ...
+ *   ...
+ *   slab.free(&slab, n);   // or slab.empty(&slab) to drop all nodes at once
+ *   ...
+ *   ...
+ *   slab.deinit(&slab);
+ *
+ * NOTES
+ *   Not thread safe. ctx is heap allocated so .ctx is NULL if that allocation fails.
+ *   Memory is not returned to the OS on free (except for large objects) until deinit.
+ */
+MEM_API mem_allocator_t mem_slab_init(const char name_cstr[const static 1])
+{
+  MEM_ASSERT_NONNULL((void *)name_cstr);
+  dbg(">> name = %s", name_cstr);
+
+  mem_allocator_t allocator = {
+    .ctx = calloc(1, sizeof(mem_slab_ctx_t)),
+    .name = sv_from_cstr(name_cstr),
+    .alloc = slab_malloc,
+    .calloc = slab_calloc,
+    .realloc = slab_realloc,
+    .free = slab_free,
+    .empty = slab_empty,
+    .deinit = slab_deinit,
+  };
+
+  dbg("<< [allocator "SV_FMT"] ctx = %p", sv_fmt_args(allocator.name), allocator.ctx);
+  return allocator;
+}
+
+
+// ----------------------------------------------------------------------------------------------------------------
+// Thread caching allocator
+
+// objects moved between a thread's cache and the central depot in one go
+#ifndef MEM_TCACHE_BATCH
+#define MEM_TCACHE_BATCH 32
+#endif // MEM_TCACHE_BATCH
+
+// a thread cache holding more than this many objects of a size class drains a batch back to the depot
+#ifndef MEM_TCACHE_MAX
+#define MEM_TCACHE_MAX (MEM_TCACHE_BATCH * 2)
+#endif // MEM_TCACHE_MAX
+
+_Static_assert(MEM_TCACHE_MAX >= MEM_TCACHE_BATCH, "MEM_TCACHE_MAX must be at least MEM_TCACHE_BATCH");
+
+typedef struct mem_tcache_ctx_t mem_tcache_ctx_t;
+
+typedef struct mem_tcache_t {
+  mem_tcache_ctx_t *owner;
+  struct mem_tcache_t *next;  // every live thread cache of the owner
+  struct mem_tcache_t *prev;
+  mem_slab_free_t *bins[MEM_SLAB_CLASS_COUNT];
+  size_t counts[MEM_SLAB_CLASS_COUNT];
+} mem_tcache_t;
+
+typedef struct mem_tcache_ctx_t {
+  pthread_mutex_t lock;       // guards depot and caches
+  pthread_key_t key;          // this allocator's mem_tcache_t for the calling thread
+  mem_slab_ctx_t depot;
+  mem_tcache_t *caches;
+} mem_tcache_ctx_t;
+
+/* gives every cached object back to the depot. Expects ctx->lock to be held */
+static void tcache_flush_locked_(mem_tcache_ctx_t *const ctx, mem_tcache_t *const tc)
+{
+  for (size_t i = 0; i < MEM_SLAB_CLASS_COUNT; i++) {
+    mem_slab_free_t *obj = tc->bins[i];
+
+    while (obj) {
+      mem_slab_free_t *next = obj->next;
+      obj->next = ctx->depot.classes[i].free_list;
+      ctx->depot.classes[i].free_list = obj;
+      obj = next;
+    }
+
+    tc->bins[i] = NULL;
+    tc->counts[i] = 0;
+  }
+}
+
+/* pthread key destructor, runs when a thread that used the allocator exits */
+static void tcache_thread_exit_(void *arg)
+{
+  mem_tcache_t *tc = arg;
+  mem_tcache_ctx_t *ctx = tc->owner;
+
+  pthread_mutex_lock(&ctx->lock);
+
+  tcache_flush_locked_(ctx, tc);
+
+  if (tc->prev) {
+    tc->prev->next = tc->next;
+  } else {
+    ctx->caches = tc->next;
+  }
+  if (tc->next) {
+    tc->next->prev = tc->prev;
+  }
+
+  pthread_mutex_unlock(&ctx->lock);
+
+  free(tc);
+}
+
+static mem_tcache_t *tcache_get_(mem_tcache_ctx_t *const ctx)
+{
+  mem_tcache_t *tc = pthread_getspecific(ctx->key);
+
+  if (tc) {
+    return tc;
+  }
+
+  tc = calloc(1, sizeof(*tc));
+  if (tc == NULL) {
+    return NULL;
+  }
+
+  if (pthread_setspecific(ctx->key, tc) != 0) {
+    free(tc);
+    return NULL;
+  }
+
+  tc->owner = ctx;
+
+  pthread_mutex_lock(&ctx->lock);
+  tc->next = ctx->caches;
+  if (ctx->caches) {
+    ctx->caches->prev = tc;
+  }
+  ctx->caches = tc;
+  pthread_mutex_unlock(&ctx->lock);
+
+  return tc;
+}
+
+/* moves up to MEM_TCACHE_BATCH objects of class_idx from the depot into the thread cache */
+static void tcache_refill_(mem_tcache_ctx_t *const ctx, mem_tcache_t *const tc, const uint32_t class_idx)
+{
+  pthread_mutex_lock(&ctx->lock);
+
+  for (size_t i = 0; i < MEM_TCACHE_BATCH; i++) {
+    mem_slab_free_t *obj = slab_alloc_small_(&ctx->depot, class_idx);
+
+    if (obj == NULL) {
+      break;
+    }
+
+    obj->next = tc->bins[class_idx];
+    tc->bins[class_idx] = obj;
+    tc->counts[class_idx]++;
+  }
+
+  pthread_mutex_unlock(&ctx->lock);
+}
+
+/* hands MEM_TCACHE_BATCH objects of class_idx back to the depot */
+static void tcache_drain_(mem_tcache_ctx_t *const ctx, mem_tcache_t *const tc, const uint32_t class_idx)
+{
+  // detach the batch before taking the lock so the critical section is just a splice
+  mem_slab_free_t *head = tc->bins[class_idx];
+  mem_slab_free_t *tail = head;
+
+  for (size_t i = 1; i < MEM_TCACHE_BATCH; i++) {
+    tail = tail->next;
+  }
+
+  tc->bins[class_idx] = tail->next;
+  tc->counts[class_idx] -= MEM_TCACHE_BATCH;
+
+  pthread_mutex_lock(&ctx->lock);
+  tail->next = ctx->depot.classes[class_idx].free_list;
+  ctx->depot.classes[class_idx].free_list = head;
+  pthread_mutex_unlock(&ctx->lock);
+}
+
+static void *tcache_malloc(const mem_allocator_t *const al, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: size = %zu", sv_fmt_args(al->name), sz);
+
+  mem_tcache_ctx_t *ctx = al->ctx;
+  void *ptr = NULL;
+
+  if (sz > ((size_t)1 << MEM_SLAB_MAX_CLASS_SHIFT)) {
+    pthread_mutex_lock(&ctx->lock);
+    ptr = slab_alloc_large_(&ctx->depot, sz);
+    pthread_mutex_unlock(&ctx->lock);
+
+    dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+    return ptr;
+  }
+
+  const uint32_t class_idx = slab_class_idx_(sz);
+  mem_tcache_t *tc = tcache_get_(ctx);
+
+  if (tc == NULL) {
+    dbg("<< [allocator "SV_FMT"]: could not create thread cache", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  if (tc->bins[class_idx] == NULL) {
+    tcache_refill_(ctx, tc, class_idx);
+  }
+
+  mem_slab_free_t *obj = tc->bins[class_idx];
+  if (obj) {
+    tc->bins[class_idx] = obj->next;
+    tc->counts[class_idx]--;
+  }
+  ptr = obj;
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void *tcache_calloc(const mem_allocator_t *const al, const size_t count, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]: count = %zu, size = %zu",
+      sv_fmt_args(al->name), count, sz);
+
+  if (sz && count > SIZE_MAX / sz) {
+    dbg("<< [allocator "SV_FMT"]: overflow", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  void *ptr = tcache_malloc(al, count * sz);
+
+  if (ptr) {
+    memset(ptr, 0, count * sz);
+  }
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void tcache_free(const mem_allocator_t *const al, void *ptr)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p", sv_fmt_args(al->name), ptr);
+
+  if (ptr == NULL) {
+    dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+    return;
+  }
+
+  mem_tcache_ctx_t *ctx = al->ctx;
+  mem_slab_t *slab = slab_of_(ptr);
+
+  if (slab->class_idx == MEM_SLAB_LARGE_CLASS) {
+    pthread_mutex_lock(&ctx->lock);
+    slab_free_large_(&ctx->depot, slab);
+    pthread_mutex_unlock(&ctx->lock);
+
+    dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+    return;
+  }
+
+  MEM_ASSERT(slab->class_idx < MEM_SLAB_CLASS_COUNT,
+             "Expected: ptr from this allocator, Received: %p with class %u", ptr, slab->class_idx);
+
+  const uint32_t class_idx = slab->class_idx;
+  mem_slab_free_t *obj = ptr;
+  mem_tcache_t *tc = tcache_get_(ctx);
+
+  // no thread cache to park it in, give it straight back to the depot
+  if (tc == NULL) {
+    pthread_mutex_lock(&ctx->lock);
+    obj->next = ctx->depot.classes[class_idx].free_list;
+    ctx->depot.classes[class_idx].free_list = obj;
+    pthread_mutex_unlock(&ctx->lock);
+
+    dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+    return;
+  }
+
+  obj->next = tc->bins[class_idx];
+  tc->bins[class_idx] = obj;
+  tc->counts[class_idx]++;
+
+  if (tc->counts[class_idx] > MEM_TCACHE_MAX) {
+    tcache_drain_(ctx, tc, class_idx);
+  }
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void *tcache_realloc(const mem_allocator_t *const al, void *ptr, const size_t old_sz, const size_t new_sz)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p, old size = %zu, new size = %zu",
+      sv_fmt_args(al->name), ptr, old_sz, new_sz);
+
+  if (ptr == NULL) {
+    return tcache_malloc(al, new_sz);
+  }
+
+  const mem_slab_t *slab = slab_of_(ptr);
+
+  if (new_sz <= slab->obj_sz) {
+    dbg("<< [allocator "SV_FMT"]: realloced ptr = %p (in place)", sv_fmt_args(al->name), ptr);
+    return ptr;
+  }
+
+  void *new_ptr = tcache_malloc(al, new_sz);
+
+  if (new_ptr) {
+    memcpy(new_ptr, ptr, old_sz < slab->obj_sz ? old_sz : slab->obj_sz);
+    tcache_free(al, ptr);
+  }
+
+  dbg("<< [allocator "SV_FMT"]: realloced ptr = %p", sv_fmt_args(al->name), new_ptr);
+  return new_ptr;
+}
+
+static void tcache_empty(const mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  mem_tcache_ctx_t *ctx = al->ctx;
+
+  pthread_mutex_lock(&ctx->lock);
+
+  // cached objects point into slabs that are about to be rewound, so just forget them
+  for (mem_tcache_t *tc = ctx->caches; tc; tc = tc->next) {
+    memset(tc->bins, 0, sizeof(tc->bins));
+    memset(tc->counts, 0, sizeof(tc->counts));
+  }
+
+  slab_ctx_empty_(&ctx->depot);
+
+  pthread_mutex_unlock(&ctx->lock);
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void tcache_deinit(mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  sv_t name = al->name;
+  (void) name;
+
+  mem_tcache_ctx_t *ctx = al->ctx;
+
+  if (ctx) {
+    // deleting the key first means no thread exit destructor can race with the teardown below
+    pthread_key_delete(ctx->key);
+
+    mem_tcache_t *tc = ctx->caches;
+    while (tc) {
+      mem_tcache_t *next = tc->next;
+      free(tc);
+      tc = next;
+    }
+
+    slab_ctx_release_(&ctx->depot);
+    pthread_mutex_destroy(&ctx->lock);
+  }
+
+  al->name = (sv_t){0};
+  free(al->ctx);
+  al->ctx = NULL;
+
+  dbg("<< [allocator "SV_FMT"] Destroyed!", sv_fmt_args(name));
+}
+
+/**
+ * Thread caching allocator
+ *   This function initializes a thread safe allocator with the same size classes and slabs as
+ *   mem_slab_init() where every thread keeps a small cache of free objects per size class.
+ *   Most alloc/free calls only touch the calling thread's cache. A thread that runs out
+ *   refills MEM_TCACHE_BATCH objects at a time from a mutex protected central depot, and a
+ *   thread holding more than MEM_TCACHE_MAX objects of a class drains a batch back, so objects
+ *   freed on a different thread than they were allocated on find their way back into circulation.
+ *
+ * Example:
+ *   mem_allocator_t tc = mem_tcache_init("workers");
+ *   // from any thread
+ *   job_t *job = tc.alloc(&tc, sizeof(*job));
+ *   ...
+ *   ...
+ *   tc.free(&tc, job);
+ *   ...
+ *   ...
+ *   // once all threads are done with it
+ *   tc.deinit(&tc);
+ *
+ * NOTES
+ *   empty() and deinit() must not race with alloc/free on other threads. A thread's cache is
+ *   returned to the depot when the thread exits. ctx is NULL if setting up the allocator fails.
+ */
+MEM_API mem_allocator_t mem_tcache_init(const char name_cstr[const static 1])
+{
+  MEM_ASSERT_NONNULL((void *)name_cstr);
+  dbg(">> name = %s", name_cstr);
+
+  mem_tcache_ctx_t *ctx = calloc(1, sizeof(*ctx));
+
+  if (ctx && pthread_mutex_init(&ctx->lock, NULL) != 0) {
+    free(ctx);
+    ctx = NULL;
+  }
+
+  if (ctx && pthread_key_create(&ctx->key, tcache_thread_exit_) != 0) {
+    pthread_mutex_destroy(&ctx->lock);
+    free(ctx);
+    ctx = NULL;
+  }
+
+  mem_allocator_t allocator = {
+    .ctx = ctx,
+    .name = sv_from_cstr(name_cstr),
+    .alloc = tcache_malloc,
+    .calloc = tcache_calloc,
+    .realloc = tcache_realloc,
+    .free = tcache_free,
+    .empty = tcache_empty,
+    .deinit = tcache_deinit,
+  };
+
+  dbg("<< [allocator "SV_FMT"] ctx = %p", sv_fmt_args(allocator.name), allocator.ctx);
+  return allocator;
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// Tracing allocator
+
+_Static_assert(sizeof(mem_trace_record_t) == 24, "mem_trace_record_t must stay 24 bytes as it's written to disk");
+
+// each allocation is prefixed with its trace id so that frees/reallocs can be matched up with it
+#define MEM_TRACE_PREFIX_SIZE \
+  ((sizeof(uint32_t) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+#ifndef MEM_TRACE_BUF_SIZE
+#define MEM_TRACE_BUF_SIZE (64 * 1024)
+#endif // MEM_TRACE_BUF_SIZE
+
+typedef struct mem_trace_ctx_t {
+  const mem_allocator_t *inner;
+  FILE *file;
+  uint64_t start_ns;
+  uint32_t next_id;
+} mem_trace_ctx_t;
+
+static inline uint64_t trace_now_ns_(void)
+{
+  struct timespec ts = {0};
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void trace_record_(mem_trace_ctx_t *const ctx, const mem_trace_op_t op, const uint32_t id, const size_t sz)
+{
+  const mem_trace_record_t record = {
+    .ns = trace_now_ns_() - ctx->start_ns,
+    .size = sz,
+    .id = id,
+    .op = (uint8_t)op,
+  };
+
+  fwrite(&record, sizeof(record), 1, ctx->file);
+}
+
+static void *trace_alloc_(mem_trace_ctx_t *const ctx, const mem_trace_op_t op, const size_t sz)
+{
+  if (sz > SIZE_MAX - MEM_TRACE_PREFIX_SIZE) {
+    return NULL;
+  }
+
+  uint32_t *prefix = op == MEM_TRACE_CALLOC
+    ? ctx->inner->calloc(ctx->inner, 1, MEM_TRACE_PREFIX_SIZE + sz)
+    : ctx->inner->alloc(ctx->inner, MEM_TRACE_PREFIX_SIZE + sz);
+
+  // failed allocations aren't recorded as there is nothing a replay could do with them
+  if (prefix == NULL) {
+    return NULL;
+  }
+
+  *prefix = ++ctx->next_id;
+  trace_record_(ctx, op, *prefix, sz);
+
+  return (char *)prefix + MEM_TRACE_PREFIX_SIZE;
+}
+
+static void *trace_malloc(const mem_allocator_t *const al, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: size = %zu", sv_fmt_args(al->name), sz);
+
+  void *ptr = trace_alloc_(al->ctx, MEM_TRACE_ALLOC, sz);
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void *trace_calloc(const mem_allocator_t *const al, const size_t count, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: count = %zu, size = %zu",
+      sv_fmt_args(al->name), count, sz);
+
+  void *ptr = sz && count > SIZE_MAX / sz ? NULL : trace_alloc_(al->ctx, MEM_TRACE_CALLOC, count * sz);
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void *trace_realloc(const mem_allocator_t *const al, void *ptr, const size_t old_sz, const size_t new_sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p, old size = %zu, new size = %zu",
+      sv_fmt_args(al->name), ptr, old_sz, new_sz);
+
+  mem_trace_ctx_t *ctx = al->ctx;
+
+  if (ptr == NULL) {
+    void *new_ptr = trace_alloc_(ctx, MEM_TRACE_ALLOC, new_sz);
+
+    dbg("<< [allocator "SV_FMT"]: realloced ptr = %p", sv_fmt_args(al->name), new_ptr);
+    return new_ptr;
+  }
+
+  uint32_t *prefix = (uint32_t *)((char *)ptr - MEM_TRACE_PREFIX_SIZE);
+  uint32_t *new_prefix = new_sz <= SIZE_MAX - MEM_TRACE_PREFIX_SIZE
+    ? ctx->inner->realloc(ctx->inner, prefix, MEM_TRACE_PREFIX_SIZE + old_sz, MEM_TRACE_PREFIX_SIZE + new_sz)
+    : NULL;
+
+  if (new_prefix == NULL) {
+    dbg("<< [allocator "SV_FMT"]: NULL", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  trace_record_(ctx, MEM_TRACE_REALLOC, *new_prefix, new_sz);
+
+  void *new_ptr = (char *)new_prefix + MEM_TRACE_PREFIX_SIZE;
+  dbg("<< [allocator "SV_FMT"]: realloced ptr = %p", sv_fmt_args(al->name), new_ptr);
+  return new_ptr;
+}
+
+static void trace_free(const mem_allocator_t *const al, void *ptr)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p", sv_fmt_args(al->name), ptr);
+
+  if (ptr == NULL) {
+    dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+    return;
+  }
+
+  mem_trace_ctx_t *ctx = al->ctx;
+  uint32_t *prefix = (uint32_t *)((char *)ptr - MEM_TRACE_PREFIX_SIZE);
+
+  trace_record_(ctx, MEM_TRACE_FREE, *prefix, 0);
+  ctx->inner->free(ctx->inner, prefix);
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void trace_empty(const mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  mem_trace_ctx_t *ctx = al->ctx;
+
+  trace_record_(ctx, MEM_TRACE_EMPTY, 0, 0);
+  ctx->inner->empty(ctx->inner);
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void trace_deinit(mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  sv_t name = al->name;
+  (void) name;
+
+  mem_trace_ctx_t *ctx = al->ctx;
+
+  // the wrapped allocator belongs to the caller, the trace file belongs to us
+  if (ctx) {
+    fclose(ctx->file);
+  }
+
+  al->name = (sv_t){0};
+  free(al->ctx);
+  al->ctx = NULL;
+
+  dbg("<< [allocator "SV_FMT"] Destroyed!", sv_fmt_args(name));
+}
+
+/**
+ * Tracing allocator
+ *   This function wraps inner in an allocator that forwards every call to it and appends a
+ *   24 byte mem_trace_record_t (op, size, allocation id, timestamp) per call to the file at path,
+ *   after a mem_trace_header_t. Allocations are numbered from 1 in the order they are made so a
+ *   trace can be replayed against any other allocator without knowing the original pointers
+ *   (see benchmarks/zdx_memory_replay_benchmark.c).
+ *
+ * Example:
+ *   mem_allocator_t gpa = mem_gpa_init("gpa");
+ *   mem_allocator_t trace = mem_trace_init("trace", &gpa, "/tmp/app.trace");
+ *   // run the workload with trace instead of gpa
+ *   ...
+ *   ...
+ *   trace.deinit(&trace); // flushes and closes the trace file
+ *   gpa.deinit(&gpa);
+ *
+ * NOTES
+ *   Records are buffered in MEM_TRACE_BUF_SIZE chunks and the file is complete only after deinit().
+ *   Every allocation is prefixed with its id so pointers must only be passed back to this allocator.
+ *   inner stays owned by the caller and must outlive the tracing allocator. Not thread safe.
+ *   ctx is NULL if the trace file can't be created.
+ */
+MEM_API mem_allocator_t mem_trace_init(const char name_cstr[const static 1], const mem_allocator_t *const inner,
+                                       const char path[const static 1])
+{
+  MEM_ASSERT_NONNULL((void *)name_cstr);
+  MEM_ASSERT_NONNULL((void *)inner);
+  MEM_ASSERT_NONNULL((void *)path);
+  dbg(">> name = %s, inner = "SV_FMT", path = %s", name_cstr, sv_fmt_args(inner->name), path);
+
+  mem_trace_ctx_t *ctx = calloc(1, sizeof(*ctx));
+
+  if (ctx) {
+    ctx->inner = inner;
+    ctx->file = fopen(path, "wb");
+    ctx->start_ns = trace_now_ns_();
+
+    const mem_trace_header_t header = {
+      .magic = MEM_TRACE_MAGIC,
+      .version = MEM_TRACE_VERSION,
+      .record_size = sizeof(mem_trace_record_t),
+    };
+
+    if (ctx->file == NULL ||
+        setvbuf(ctx->file, NULL, _IOFBF, MEM_TRACE_BUF_SIZE) != 0 ||
+        fwrite(&header, sizeof(header), 1, ctx->file) != 1) {
+      if (ctx->file) {
+        fclose(ctx->file);
+      }
+      free(ctx);
+      ctx = NULL;
+    }
+  }
+
+  mem_allocator_t allocator = {
+    .ctx = ctx,
+    .name = sv_from_cstr(name_cstr),
+    .alloc = trace_malloc,
+    .calloc = trace_calloc,
+    .realloc = trace_realloc,
+    .free = trace_free,
+    .empty = trace_empty,
+    .deinit = trace_deinit,
+  };
+
+  dbg("<< [allocator "SV_FMT"] ctx = %p", sv_fmt_args(allocator.name), allocator.ctx);
+  return allocator;
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// Arena adapter
+
+typedef struct mem_arena_ctx_t {
+  arena_t *arena;
+  // most recent allocation so that free() of it can hand the bytes back with arena_free_last()
+  void *last;
+  size_t last_sz;
+} mem_arena_ctx_t;
+
+static void *arena_adapter_malloc(const mem_allocator_t *const al, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: size = %zu", sv_fmt_args(al->name), sz);
+
+  mem_arena_ctx_t *ctx = al->ctx;
+  void *ptr = arena_alloc(ctx->arena, sz);
+
+  if (ptr) {
+    ctx->last = ptr;
+    ctx->last_sz = sz;
+  }
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void *arena_adapter_calloc(const mem_allocator_t *const al, const size_t count, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: count = %zu, size = %zu",
+      sv_fmt_args(al->name), count, sz);
+
+  mem_arena_ctx_t *ctx = al->ctx;
+  void *ptr = arena_calloc(ctx->arena, count, sz);
+
+  if (ptr) {
+    ctx->last = ptr;
+    ctx->last_sz = count * sz;
+  }
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void *arena_adapter_realloc(const mem_allocator_t *const al, void *ptr, const size_t old_sz, const size_t new_sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p, old size = %zu, new size = %zu",
+      sv_fmt_args(al->name), ptr, old_sz, new_sz);
+
+  mem_arena_ctx_t *ctx = al->ctx;
+  // arena_realloc grows/shrinks the most recent allocation in place
+  void *new_ptr = arena_realloc(ctx->arena, ptr, old_sz, new_sz);
+
+  if (new_ptr) {
+    ctx->last = new_ptr;
+    ctx->last_sz = new_sz;
+  }
+
+  dbg("<< [allocator "SV_FMT"]: realloced ptr = %p", sv_fmt_args(al->name), new_ptr);
+  return new_ptr;
+}
+
+static void arena_adapter_free(const mem_allocator_t *const al, void *ptr)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p", sv_fmt_args(al->name), ptr);
+
+  mem_arena_ctx_t *ctx = al->ctx;
+
+  // only the most recent allocation can be given back; everything else waits for empty()
+  if (ptr != NULL && ptr == ctx->last) {
+    arena_free_last(ctx->arena, ptr, ctx->last_sz);
+    ctx->last = NULL;
+    ctx->last_sz = 0;
+  }
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void arena_adapter_empty(const mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  mem_arena_ctx_t *ctx = al->ctx;
+  arena_reset(ctx->arena);
+  ctx->last = NULL;
+  ctx->last_sz = 0;
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void arena_adapter_deinit(mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  sv_t name = al->name;
+  (void) name;
+
+  // the arena belongs to the caller, only the adapter's own ctx is released
+  al->name = (sv_t){0};
+  free(al->ctx);
+  al->ctx = NULL;
+
+  dbg("<< [allocator "SV_FMT"] Destroyed!", sv_fmt_args(name));
+}
+
+/**
+ * Arena adapter
+ *   This function wraps an existing arena_t from zdx_simple_arena.h in a mem_allocator_t so
+ *   allocator-parameterised code can be switched to bump allocation at runtime.
+ *   alloc/calloc/realloc forward to arena_alloc/arena_calloc/arena_realloc, free gives the
+ *   bytes back only when ptr is the most recent allocation (LIFO) and is a no-op otherwise,
+ *   and empty() resets the arena.
+ *
+ * Example:
+ *   arena_t arena = arena_create(1 MB);
+ *   mem_allocator_t al = mem_arena_init("frame", &arena);
+ *   node_t *n = al.alloc(&al, sizeof(*n));
+ *   ...
+ *   ...
+ *   al.empty(&al);   // arena_reset(&arena)
+ *   ...
+ *   ...
+ *   al.deinit(&al);
+ *   arena_free(&arena);
+ *
+ * NOTES
+ *   The arena stays owned by the caller and must outlive the allocator. deinit() does not
+ *   arena_free() it. Errors are reported through the arena's "err" property.
+ */
+MEM_API mem_allocator_t mem_arena_init(const char name_cstr[const static 1], arena_t *const ar)
+{
+  MEM_ASSERT_NONNULL((void *)name_cstr);
+  MEM_ASSERT_NONNULL((void *)ar);
+  dbg(">> name = %s, arena = %p", name_cstr, (void *)ar);
+
+  mem_arena_ctx_t *ctx = calloc(1, sizeof(*ctx));
+  if (ctx) {
+    ctx->arena = ar;
+  }
+
+  mem_allocator_t allocator = {
+    .ctx = ctx,
+    .name = sv_from_cstr(name_cstr),
+    .alloc = arena_adapter_malloc,
+    .calloc = arena_adapter_calloc,
+    .realloc = arena_adapter_realloc,
+    .free = arena_adapter_free,
+    .empty = arena_adapter_empty,
+    .deinit = arena_adapter_deinit,
+  };
+
+  dbg("<< [allocator "SV_FMT"] ctx = %p", sv_fmt_args(allocator.name), allocator.ctx);
+  return allocator;
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// Buddy allocator
+
+_Static_assert(MEM_BUDDY_MIN_SHIFT >= 4, "MEM_BUDDY_MIN_SHIFT must leave room for a mem_buddy_free_t in every block");
+
+#define MEM_BUDDY_MAX_ORDER (sizeof(size_t) * 8 - 1)
+#define MEM_BUDDY_FREE 0x80  // set in the order byte of a free block
+
+typedef struct mem_buddy_free_t {
+  struct mem_buddy_free_t *next;
+  struct mem_buddy_free_t *prev;
+} mem_buddy_free_t;
+
+typedef struct mem_buddy_ctx_t {
+  arena_t region;  // only its mapping is used, blocks are carved out of region.arena directly
+  char *base;
+  size_t capacity;
+  size_t max_order;  // capacity == 1 << max_order
+  size_t allocated_bytes;
+  size_t alloc_count;
+  size_t free_count;
+  size_t failed_count;
+  mem_buddy_free_t *free_lists[MEM_BUDDY_MAX_ORDER + 1];  // doubly linked so a buddy can be unlinked in O(1)
+  size_t free_counts[MEM_BUDDY_MAX_ORDER + 1];
+  // one byte per 1 << MEM_BUDDY_MIN_SHIFT bytes of the region holding the order of the block that starts
+  // there, | MEM_BUDDY_FREE if it is free. Only bytes at the start of a block are kept up to date
+  uint8_t orders[];
+} mem_buddy_ctx_t;
+
+static inline size_t buddy_order_of_(size_t sz)
+{
+  if (sz <= ((size_t)1 << MEM_BUDDY_MIN_SHIFT)) {
+    return MEM_BUDDY_MIN_SHIFT;
+  }
+
+  sz = CLOSESTPOWEROF2(sz);
+  return sizeof(size_t) * 8 - 1 - (size_t)NONZERO_CLZG(sz);
+}
+
+static inline uint8_t *buddy_order_byte_(mem_buddy_ctx_t *const ctx, const size_t offset)
+{
+  return &ctx->orders[offset >> MEM_BUDDY_MIN_SHIFT];
+}
+
+static void buddy_push_(mem_buddy_ctx_t *const ctx, const size_t offset, const size_t order)
+{
+  mem_buddy_free_t *block = (mem_buddy_free_t *)(ctx->base + offset);
+
+  block->prev = NULL;
+  block->next = ctx->free_lists[order];
+  if (block->next) {
+    block->next->prev = block;
+  }
+  ctx->free_lists[order] = block;
+  ctx->free_counts[order]++;
+
+  *buddy_order_byte_(ctx, offset) = (uint8_t)(order | MEM_BUDDY_FREE);
+}
+
+static void buddy_unlink_(mem_buddy_ctx_t *const ctx, const size_t offset, const size_t order)
+{
+  mem_buddy_free_t *block = (mem_buddy_free_t *)(ctx->base + offset);
+
+  if (block->prev) {
+    block->prev->next = block->next;
+  } else {
+    ctx->free_lists[order] = block->next;
+  }
+  if (block->next) {
+    block->next->prev = block->prev;
+  }
+  ctx->free_counts[order]--;
+}
+
+/* frees every block at once by going back to a single free block spanning the whole region */
+static void buddy_ctx_reset_(mem_buddy_ctx_t *const ctx)
+{
+  memset(ctx->free_lists, 0, sizeof(ctx->free_lists));
+  memset(ctx->free_counts, 0, sizeof(ctx->free_counts));
+  ctx->allocated_bytes = 0;
+
+  buddy_push_(ctx, 0, ctx->max_order);
+}
+
+static void *buddy_malloc(const mem_allocator_t *const al, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: size = %zu", sv_fmt_args(al->name), sz);
+
+  mem_buddy_ctx_t *ctx = al->ctx;
+
+  if (sz > ctx->capacity) {
+    ctx->failed_count++;
+    dbg("<< [allocator "SV_FMT"]: bigger than the region", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  const size_t order = buddy_order_of_(sz);
+  size_t split_order = order;
+
+  while (split_order <= ctx->max_order && ctx->free_lists[split_order] == NULL) {
+    split_order++;
+  }
+
+  if (split_order > ctx->max_order) {
+    ctx->failed_count++;
+    dbg("<< [allocator "SV_FMT"]: no free block of order %zu or above", sv_fmt_args(al->name), order);
+    return NULL;
+  }
+
+  const size_t offset = (size_t)((char *)ctx->free_lists[split_order] - ctx->base);
+  buddy_unlink_(ctx, offset, split_order);
+
+  // keep the lower half and put the upper half on the free list until the block is as small as it can be
+  while (split_order > order) {
+    split_order--;
+    buddy_push_(ctx, offset + ((size_t)1 << split_order), split_order);
+  }
+
+  *buddy_order_byte_(ctx, offset) = (uint8_t)order;
+  ctx->allocated_bytes += (size_t)1 << order;
+  ctx->alloc_count++;
+
+  void *ptr = ctx->base + offset;
+
+  dbg("<< [allocator "SV_FMT"]: %p (order %zu)", sv_fmt_args(al->name), ptr, order);
+  return ptr;
+}
+
+static void *buddy_calloc(const mem_allocator_t *const al, const size_t count, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]: count = %zu, size = %zu",
+      sv_fmt_args(al->name), count, sz);
+
+  if (sz && count > SIZE_MAX / sz) {
+    dbg("<< [allocator "SV_FMT"]: overflow", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  void *ptr = buddy_malloc(al, count * sz);
+
+  // freed blocks are recycled as is so zero them unconditionally
+  if (ptr) {
+    memset(ptr, 0, count * sz);
+  }
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void buddy_free(const mem_allocator_t *const al, void *ptr)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p", sv_fmt_args(al->name), ptr);
+
+  if (ptr == NULL) {
+    dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+    return;
+  }
+
+  mem_buddy_ctx_t *ctx = al->ctx;
+  size_t offset = (size_t)((char *)ptr - ctx->base);
+
+  MEM_ASSERT((char *)ptr >= ctx->base && offset < ctx->capacity &&
+             (offset & (((size_t)1 << MEM_BUDDY_MIN_SHIFT) - 1)) == 0,
+             "Expected: ptr from this allocator, Received: %p", ptr);
+
+  size_t order = *buddy_order_byte_(ctx, offset);
+
+  MEM_ASSERT(!(order & MEM_BUDDY_FREE), "Expected: ptr to be allocated, Received: %p which is already free", ptr);
+
+  ctx->allocated_bytes -= (size_t)1 << order;
+  ctx->free_count++;
+
+  // merge with the buddy for as long as it is free and whole i.e. not split into smaller blocks
+  while (order < ctx->max_order) {
+    const size_t buddy_offset = offset ^ ((size_t)1 << order);
+
+    if (*buddy_order_byte_(ctx, buddy_offset) != (order | MEM_BUDDY_FREE)) {
+      break;
+    }
+
+    buddy_unlink_(ctx, buddy_offset, order);
+    offset &= ~((size_t)1 << order);
+    order++;
+  }
+
+  buddy_push_(ctx, offset, order);
+
+  dbg("<< [allocator "SV_FMT"]: freed block of order %zu", sv_fmt_args(al->name), order);
+}
+
+/* grows the block at offset to order in place if every upper buddy on the way there is free and whole */
+static bool buddy_grow_in_place_(mem_buddy_ctx_t *const ctx, const size_t offset, const size_t order,
+                                 const size_t new_order)
+{
+  if (new_order > ctx->max_order) {
+    return false;
+  }
+
+  for (size_t o = order; o < new_order; o++) {
+    const size_t buddy_offset = offset + ((size_t)1 << o);
+
+    // the block has to be the lower buddy at every step for the merged block to start at offset
+    if ((offset & ((size_t)1 << o)) || *buddy_order_byte_(ctx, buddy_offset) != (o | MEM_BUDDY_FREE)) {
+      return false;
+    }
+  }
+
+  for (size_t o = order; o < new_order; o++) {
+    buddy_unlink_(ctx, offset + ((size_t)1 << o), o);
+  }
+
+  *buddy_order_byte_(ctx, offset) = (uint8_t)new_order;
+  ctx->allocated_bytes += ((size_t)1 << new_order) - ((size_t)1 << order);
+
+  return true;
+}
+
+static void *buddy_realloc(const mem_allocator_t *const al, void *ptr, const size_t old_sz, const size_t new_sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p, old size = %zu, new size = %zu",
+      sv_fmt_args(al->name), ptr, old_sz, new_sz);
+
+  if (ptr == NULL) {
+    return buddy_malloc(al, new_sz);
+  }
+
+  mem_buddy_ctx_t *ctx = al->ctx;
+  const size_t offset = (size_t)((char *)ptr - ctx->base);
+  const size_t order = *buddy_order_byte_(ctx, offset);
+  const size_t block_sz = (size_t)1 << order;
+
+  // still fits in the block it already has (sizes round up to a power of 2 so this is common)
+  if (new_sz <= block_sz) {
+    dbg("<< [allocator "SV_FMT"]: realloced ptr = %p (in place)", sv_fmt_args(al->name), ptr);
+    return ptr;
+  }
+
+  if (new_sz <= ctx->capacity && buddy_grow_in_place_(ctx, offset, order, buddy_order_of_(new_sz))) {
+    dbg("<< [allocator "SV_FMT"]: realloced ptr = %p (merged with buddies)", sv_fmt_args(al->name), ptr);
+    return ptr;
+  }
+
+  void *new_ptr = buddy_malloc(al, new_sz);
+
+  if (new_ptr) {
+    memcpy(new_ptr, ptr, old_sz < block_sz ? old_sz : block_sz);
+    buddy_free(al, ptr);
+  }
+
+  dbg("<< [allocator "SV_FMT"]: realloced ptr = %p", sv_fmt_args(al->name), new_ptr);
+  return new_ptr;
+}
+
+static void buddy_empty(const mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  buddy_ctx_reset_(al->ctx);
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void buddy_deinit(mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  sv_t name = al->name;
+  (void) name;
+
+  mem_buddy_ctx_t *ctx = al->ctx;
+  if (ctx) {
+    arena_free(&ctx->region);
+  }
+
+  al->name = (sv_t){0};
+  free(ctx);
+  al->ctx = NULL;
+
+  dbg("<< [allocator "SV_FMT"] Destroyed!", sv_fmt_args(name));
+}
+
+/**
+ * Buddy allocator
+ *   This function initializes an allocator that carves power of 2 sized blocks out of a single
+ *   mmap'd region of sz bytes rounded up to a power of 2. A request is rounded up to the nearest
+ *   power of 2 (at least 1 << MEM_BUDDY_MIN_SHIFT bytes) and served by splitting the smallest free
+ *   block that fits in halves. A freed block is merged with its buddy (the other half of the block
+ *   it was split from) for as long as the buddy is free, so blocks of any size can be freed
+ *   individually without the region fragmenting into pieces too small to reuse.
+ *
+ *   alloc() and free() are O(log(sz)). realloc() grows in place when the buddies after the block
+ *   are free. empty() frees every block at once. deinit() unmaps the region.
+ *
+ * Example:
+ *   mem_allocator_t buddy = mem_buddy_init("sessions", 64 * 1024 * 1024);
+ *   session_t *s = buddy.alloc(&buddy, sizeof(*s) + payload_sz);
+ *   ...
+ *   ...
+ *   buddy.free(&buddy, s);
+ *   mem_buddy_stats_t stats = mem_buddy_stats(&buddy);  // fragmentation, see mem_buddy_stats_t
+ *   ...
+ *   ...
+ *   buddy.deinit(&buddy);
+ *
+ * NOTES
+ *   Not thread safe. The region never grows so allocations fail (return NULL) once no free block
+ *   is big enough. .ctx is NULL if the region couldn't be mapped or sz is too big to round up.
+ *   Bookkeeping takes one byte per 1 << MEM_BUDDY_MIN_SHIFT bytes of the region, kept outside of it
+ *   so blocks stay aligned to their own size.
+ */
+MEM_API mem_allocator_t mem_buddy_init(const char name_cstr[const static 1], const size_t sz)
+{
+  MEM_ASSERT_NONNULL((void *)name_cstr);
+  dbg(">> name = %s, size = %zu", name_cstr, sz);
+
+  size_t capacity = sz < ((size_t)1 << MEM_BUDDY_MIN_SHIFT) ? ((size_t)1 << MEM_BUDDY_MIN_SHIFT) : sz;
+  mem_buddy_ctx_t *ctx = NULL;
+
+  // CLOSESTPOWEROF2 overflows to 0 past the top bit
+  if (capacity <= ((size_t)1 << MEM_BUDDY_MAX_ORDER)) {
+    capacity = CLOSESTPOWEROF2(capacity);
+    ctx = calloc(1, sizeof(*ctx) + (capacity >> MEM_BUDDY_MIN_SHIFT));
+  }
+
+  if (ctx) {
+    ctx->region = arena_create(capacity);
+
+    if (ctx->region.err) {
+      dbg("!! region of %zu bytes could not be mapped: %s", capacity, ctx->region.err);
+      free(ctx);
+      ctx = NULL;
+    }
+  }
+
+  if (ctx) {
+    ctx->base = ctx->region.arena;
+    ctx->capacity = capacity;
+    ctx->max_order = buddy_order_of_(capacity);
+    buddy_ctx_reset_(ctx);
+  }
+
+  mem_allocator_t allocator = {
+    .ctx = ctx,
+    .name = sv_from_cstr(name_cstr),
+    .alloc = buddy_malloc,
+    .calloc = buddy_calloc,
+    .realloc = buddy_realloc,
+    .free = buddy_free,
+    .empty = buddy_empty,
+    .deinit = buddy_deinit,
+  };
+
+  dbg("<< [allocator "SV_FMT"] ctx = %p", sv_fmt_args(allocator.name), allocator.ctx);
+  return allocator;
+}
+
+MEM_API mem_buddy_stats_t mem_buddy_stats(const mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+  MEM_ASSERT(al->alloc == buddy_malloc, "Expected: buddy allocator, Received: "SV_FMT, sv_fmt_args(al->name));
+
+  const mem_buddy_ctx_t *ctx = al->ctx;
+  mem_buddy_stats_t stats = {
+    .capacity = ctx->capacity,
+    .allocated_bytes = ctx->allocated_bytes,
+    .free_bytes = ctx->capacity - ctx->allocated_bytes,
+    .alloc_count = ctx->alloc_count,
+    .free_count = ctx->free_count,
+    .failed_count = ctx->failed_count,
+  };
+
+  for (size_t order = MEM_BUDDY_MIN_SHIFT; order <= ctx->max_order; order++) {
+    stats.free_blocks += ctx->free_counts[order];
+
+    if (ctx->free_counts[order]) {
+      stats.largest_free = (size_t)1 << order;
+    }
+  }
+
+  return stats;
+}
+
+// ----------------------------------------------------------------------------------------------------------------
+// Profiling allocator
+
+_Static_assert((MEM_PROF_MAX_SITES & (MEM_PROF_MAX_SITES - 1)) == 0, "MEM_PROF_MAX_SITES must be a power of 2");
+
+// every allocation is prefixed with this so that free() knows how many bytes went away and where they came from
+typedef struct mem_prof_prefix_t {
+  size_t sz;
+  size_t site;  // index into sites + 1, 0 when the call site isn't known
+} mem_prof_prefix_t;
+
+#define MEM_PROF_PREFIX_SIZE \
+  ((sizeof(mem_prof_prefix_t) + _Alignof(max_align_t) - 1) & ~(_Alignof(max_align_t) - 1))
+
+typedef struct mem_prof_ctx_t {
+  const mem_allocator_t *inner;
+  mem_prof_stats_t stats;
+  mem_prof_site_t sites[MEM_PROF_MAX_SITES];
+} mem_prof_ctx_t;
+
+typedef struct mem_prof_call_site_t {
+  const char *file;
+  int line;
+} mem_prof_call_site_t;
+
+// set by mem_*_at() for the duration of a single vtable call
+static _Thread_local mem_prof_call_site_t mem_prof_call_site_;
+
+static inline size_t prof_bucket_(size_t sz)
+{
+  size_t bucket = 0;
+
+  while (sz) {
+    bucket++;
+    sz >>= 1;
+  }
+
+  return bucket < MEM_PROF_HISTOGRAM_BUCKETS ? bucket : MEM_PROF_HISTOGRAM_BUCKETS - 1;
+}
+
+/* finds or claims the slot for the current call site. Returns 0 if there is none or the table is full */
+static size_t prof_site_(mem_prof_ctx_t *const ctx)
+{
+  const mem_prof_call_site_t cs = mem_prof_call_site_;
+
+  if (cs.file == NULL) {
+    return 0;
+  }
+
+  // __FILE__ of one translation unit is the same string literal so hashing the pointer is enough
+  uint64_t h = ((uint64_t)(uintptr_t)cs.file ^ ((uint64_t)(unsigned)cs.line << 32)) * 0x9E3779B97F4A7C15ull;
+  size_t idx = (size_t)(h >> 32) & (MEM_PROF_MAX_SITES - 1);
+
+  for (size_t probe = 0; probe < MEM_PROF_MAX_SITES; probe++) {
+    mem_prof_site_t *site = &ctx->sites[idx];
+
+    if (site->file == NULL) {
+      site->file = cs.file;
+      site->line = cs.line;
+      return idx + 1;
+    }
+    if (site->file == cs.file && site->line == cs.line) {
+      return idx + 1;
+    }
+
+    idx = (idx + 1) & (MEM_PROF_MAX_SITES - 1);
+  }
+
+  ctx->stats.dropped_sites++;
+  return 0;
+}
+
+/* fallback_site is used when the call didn't come through a call site macro, e.g., to keep a realloc'ed
+   allocation attributed to where it was first made */
+static void prof_track_alloc_(mem_prof_ctx_t *const ctx, mem_prof_prefix_t *const prefix, const size_t sz,
+                              const size_t fallback_site)
+{
+  mem_prof_stats_t *stats = &ctx->stats;
+  const size_t call_site = prof_site_(ctx);
+
+  prefix->sz = sz;
+  prefix->site = call_site ? call_site : fallback_site;
+
+  stats->live_bytes += sz;
+  stats->total_bytes += sz;
+  stats->peak_bytes = stats->live_bytes > stats->peak_bytes ? stats->live_bytes : stats->peak_bytes;
+  stats->histogram[prof_bucket_(sz)]++;
+
+  if (prefix->site) {
+    mem_prof_site_t *site = &ctx->sites[prefix->site - 1];
+    site->alloc_count++;
+    site->total_bytes += sz;
+    site->live_bytes += sz;
+    site->peak_bytes = site->live_bytes > site->peak_bytes ? site->live_bytes : site->peak_bytes;
+  }
+}
+
+static void prof_track_free_(mem_prof_ctx_t *const ctx, const mem_prof_prefix_t *const prefix)
+{
+  ctx->stats.live_bytes -= prefix->sz;
+
+  if (prefix->site) {
+    ctx->sites[prefix->site - 1].live_bytes -= prefix->sz;
+  }
+}
+
+static void *prof_alloc_(mem_prof_ctx_t *const ctx, const size_t sz)
+{
+  mem_prof_prefix_t *prefix = sz <= SIZE_MAX - MEM_PROF_PREFIX_SIZE
+    ? ctx->inner->alloc(ctx->inner, MEM_PROF_PREFIX_SIZE + sz)
+    : NULL;
+
+  if (prefix == NULL) {
+    ctx->stats.failed_count++;
+    return NULL;
+  }
+
+  prof_track_alloc_(ctx, prefix, sz, 0);
+
+  return (char *)prefix + MEM_PROF_PREFIX_SIZE;
+}
+
+static void *prof_malloc(const mem_allocator_t *const al, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: size = %zu", sv_fmt_args(al->name), sz);
+
+  mem_prof_ctx_t *ctx = al->ctx;
+  ctx->stats.alloc_count++;
+
+  void *ptr = prof_alloc_(ctx, sz);
+
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void *prof_calloc(const mem_allocator_t *const al, const size_t count, const size_t sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: count = %zu, size = %zu",
+      sv_fmt_args(al->name), count, sz);
+
+  mem_prof_ctx_t *ctx = al->ctx;
+  ctx->stats.calloc_count++;
+
+  if (sz && count > (SIZE_MAX - MEM_PROF_PREFIX_SIZE) / sz) {
+    ctx->stats.failed_count++;
+    dbg("<< [allocator "SV_FMT"]: overflow", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  // the prefix is zeroed as well, which is harmless, and lets the inner allocator keep its calloc fast path
+  const size_t total = MEM_PROF_PREFIX_SIZE + count * sz;
+  mem_prof_prefix_t *prefix = ctx->inner->calloc(ctx->inner, 1, total);
+
+  if (prefix == NULL) {
+    ctx->stats.failed_count++;
+    dbg("<< [allocator "SV_FMT"]: NULL", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  prof_track_alloc_(ctx, prefix, count * sz, 0);
+
+  void *ptr = (char *)prefix + MEM_PROF_PREFIX_SIZE;
+  dbg("<< [allocator "SV_FMT"]: %p", sv_fmt_args(al->name), ptr);
+  return ptr;
+}
+
+static void *prof_realloc(const mem_allocator_t *const al, void *ptr, const size_t old_sz, const size_t new_sz)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p, old size = %zu, new size = %zu",
+      sv_fmt_args(al->name), ptr, old_sz, new_sz);
+
+  (void) old_sz; // the prefix knows the real old size
+
+  mem_prof_ctx_t *ctx = al->ctx;
+  ctx->stats.realloc_count++;
+
+  if (ptr == NULL) {
+    void *new_ptr = prof_alloc_(ctx, new_sz);
+
+    dbg("<< [allocator "SV_FMT"]: realloced ptr = %p", sv_fmt_args(al->name), new_ptr);
+    return new_ptr;
+  }
+
+  mem_prof_prefix_t *prefix = (mem_prof_prefix_t *)((char *)ptr - MEM_PROF_PREFIX_SIZE);
+  const mem_prof_prefix_t before = *prefix;
+
+  mem_prof_prefix_t *new_prefix = new_sz <= SIZE_MAX - MEM_PROF_PREFIX_SIZE
+    ? ctx->inner->realloc(ctx->inner, prefix, MEM_PROF_PREFIX_SIZE + before.sz, MEM_PROF_PREFIX_SIZE + new_sz)
+    : NULL;
+
+  if (new_prefix == NULL) {
+    ctx->stats.failed_count++;
+    dbg("<< [allocator "SV_FMT"]: NULL", sv_fmt_args(al->name));
+    return NULL;
+  }
+
+  prof_track_free_(ctx, &before);
+  prof_track_alloc_(ctx, new_prefix, new_sz, before.site);
+
+  // only the bytes it grew by are newly allocated
+  const size_t kept = before.sz < new_sz ? before.sz : new_sz;
+  ctx->stats.total_bytes -= kept;
+  if (new_prefix->site) {
+    ctx->sites[new_prefix->site - 1].total_bytes -= kept;
+  }
+
+  void *new_ptr = (char *)new_prefix + MEM_PROF_PREFIX_SIZE;
+  dbg("<< [allocator "SV_FMT"]: realloced ptr = %p", sv_fmt_args(al->name), new_ptr);
+  return new_ptr;
+}
+
+static void prof_free(const mem_allocator_t *const al, void *ptr)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]: ptr = %p", sv_fmt_args(al->name), ptr);
+
+  if (ptr == NULL) {
+    dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+    return;
+  }
+
+  mem_prof_ctx_t *ctx = al->ctx;
+  mem_prof_prefix_t *prefix = (mem_prof_prefix_t *)((char *)ptr - MEM_PROF_PREFIX_SIZE);
+
+  ctx->stats.free_count++;
+  prof_track_free_(ctx, prefix);
+  ctx->inner->free(ctx->inner, prefix);
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void prof_empty(const mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  mem_prof_ctx_t *ctx = al->ctx;
+
+  ctx->inner->empty(ctx->inner);
+  ctx->stats.empty_count++;
+  ctx->stats.live_bytes = 0;
+  for (size_t i = 0; i < MEM_PROF_MAX_SITES; i++) {
+    ctx->sites[i].live_bytes = 0;
+  }
+
+  dbg("<< [allocator "SV_FMT"]", sv_fmt_args(al->name));
+}
+
+static void prof_deinit(mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+
+  dbg(">> [allocator "SV_FMT"]", sv_fmt_args(al->name));
+
+  sv_t name = al->name;
+  (void) name;
+
+  // the wrapped allocator belongs to the caller
+  al->name = (sv_t){0};
+  free(al->ctx);
+  al->ctx = NULL;
+
+  dbg("<< [allocator "SV_FMT"] Destroyed!", sv_fmt_args(name));
+}
+
+/**
+ * Profiling allocator
+ *   This function wraps inner in an allocator that forwards every call to it and records live
+ *   and peak bytes, call counts per operation and a power of 2 histogram of requested sizes.
+ *   Allocations made through the mem_alloc()/mem_calloc()/mem_realloc() macros are also
+ *   aggregated per __FILE__:__LINE__ call site. Read the numbers back with mem_prof_stats() or
+ *   print a report with mem_prof_dump().
+ *
+ * Example:
+ *   mem_allocator_t gpa = mem_gpa_init("gpa");
+ *   mem_allocator_t prof = mem_prof_init("prof", &gpa);
+ *   int *a = mem_alloc(&prof, sizeof(*a) * 10);
+ *   ...
+ *   ...
+ *   mem_free(&prof, a);
+ *   mem_prof_dump(&prof, stderr);
+ *   prof.deinit(&prof);
+ *   gpa.deinit(&gpa);
+ *
+ * NOTES
+ *   Every allocation is prefixed with a small header holding its size and call site, so pointers
+ *   from a profiling allocator must only be passed back to it, never to inner directly.
+ *   inner stays owned by the caller and must outlive the profiling allocator.
+ *   Counters are plain fields so a profiling allocator shared between threads needs external locking
+ *   even if inner is thread safe.
+ */
+MEM_API mem_allocator_t mem_prof_init(const char name_cstr[const static 1], const mem_allocator_t *const inner)
+{
+  MEM_ASSERT_NONNULL((void *)name_cstr);
+  MEM_ASSERT_NONNULL((void *)inner);
+  dbg(">> name = %s, inner = "SV_FMT, name_cstr, sv_fmt_args(inner->name));
+
+  mem_prof_ctx_t *ctx = calloc(1, sizeof(*ctx));
+  if (ctx) {
+    ctx->inner = inner;
+  }
+
+  mem_allocator_t allocator = {
+    .ctx = ctx,
+    .name = sv_from_cstr(name_cstr),
+    .alloc = prof_malloc,
+    .calloc = prof_calloc,
+    .realloc = prof_realloc,
+    .free = prof_free,
+    .empty = prof_empty,
+    .deinit = prof_deinit,
+  };
+
+  dbg("<< [allocator "SV_FMT"] ctx = %p", sv_fmt_args(allocator.name), allocator.ctx);
+  return allocator;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function returns a snapshot of the counters of a profiling allocator created with
+ * mem_prof_init(). Per call site numbers are only part of mem_prof_dump().
+ */
+MEM_API mem_prof_stats_t mem_prof_stats(const mem_allocator_t *const al)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  const mem_prof_ctx_t *ctx = al->ctx;
+  return ctx->stats;
+}
+
+static int prof_site_cmp_(const void *a, const void *b)
+{
+  const mem_prof_site_t *sa = *(const mem_prof_site_t *const *)a;
+  const mem_prof_site_t *sb = *(const mem_prof_site_t *const *)b;
+
+  return (sa->total_bytes < sb->total_bytes) - (sa->total_bytes > sb->total_bytes);
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function prints the counters of a profiling allocator to stream, followed by the non-empty
+ * buckets of the size histogram and every known call site ordered by the total bytes it allocated,
+ * i.e., the allocation hot spots come first.
+ */
+MEM_API void mem_prof_dump(const mem_allocator_t *const al, FILE *const stream)
+{
+  MEM_ASSERT_NONNULL(al);
+  MEM_ASSERT_NONNULL(al->ctx);
+
+  const mem_prof_ctx_t *ctx = al->ctx;
+  const mem_prof_stats_t *stats = &ctx->stats;
+
+  fprintf(stream, "allocator "SV_FMT" (inner "SV_FMT") stats\n", sv_fmt_args(al->name), sv_fmt_args(ctx->inner->name));
+  fprintf(stream, "  live bytes      : %zu\n", stats->live_bytes);
+  fprintf(stream, "  peak bytes      : %zu\n", stats->peak_bytes);
+  fprintf(stream, "  total bytes     : %zu\n", stats->total_bytes);
+  fprintf(stream, "  alloc/calloc    : %zu/%zu\n", stats->alloc_count, stats->calloc_count);
+  fprintf(stream, "  realloc         : %zu\n", stats->realloc_count);
+  fprintf(stream, "  free            : %zu\n", stats->free_count);
+  fprintf(stream, "  empty           : %zu\n", stats->empty_count);
+  fprintf(stream, "  failed          : %zu\n", stats->failed_count);
+
+  fprintf(stream, "  size histogram\n");
+  for (size_t i = 0; i < MEM_PROF_HISTOGRAM_BUCKETS; i++) {
+    if (stats->histogram[i] == 0) {
+      continue;
+    }
+
+    const size_t lo = i ? (size_t)1 << (i - 1) : 0;
+    if (i == MEM_PROF_HISTOGRAM_BUCKETS - 1) {
+      fprintf(stream, "    %10zu+           : %zu\n", lo, stats->histogram[i]);
+    } else {
+      const size_t hi = (size_t)1 << i;
+      fprintf(stream, "    %10zu - %-10zu: %zu\n", lo, hi - 1, stats->histogram[i]);
+    }
+  }
+
+  const mem_prof_site_t *sites[MEM_PROF_MAX_SITES] = {0};
+  size_t site_count = 0;
+
+  for (size_t i = 0; i < MEM_PROF_MAX_SITES; i++) {
+    if (ctx->sites[i].file) {
+      sites[site_count++] = &ctx->sites[i];
+    }
+  }
+
+  if (site_count == 0) {
+    return;
+  }
+
+  qsort(sites, site_count, sizeof(sites[0]), prof_site_cmp_);
+
+  fprintf(stream, "  call sites (%zu, %zu allocations dropped)\n", site_count, stats->dropped_sites);
+  fprintf(stream, "    %12s | %12s | %12s | %12s | %s\n", "allocs", "total bytes", "live bytes", "peak bytes", "site");
+  for (size_t i = 0; i < site_count; i++) {
+    fprintf(stream, "    %12zu | %12zu | %12zu | %12zu | %s:%d\n",
+            sites[i]->alloc_count, sites[i]->total_bytes, sites[i]->live_bytes, sites[i]->peak_bytes,
+            sites[i]->file, sites[i]->line);
+  }
+}
+
+MEM_API void *mem_alloc_at(const mem_allocator_t *const al, const size_t sz, const char *const file, const int line)
+{
+  mem_prof_call_site_ = (mem_prof_call_site_t){ .file = file, .line = line };
+  void *ptr = al->alloc(al, sz);
+  mem_prof_call_site_ = (mem_prof_call_site_t){0};
+
+  return ptr;
+}
+
+MEM_API void *mem_calloc_at(const mem_allocator_t *const al, const size_t count, const size_t sz,
+                            const char *const file, const int line)
+{
+  mem_prof_call_site_ = (mem_prof_call_site_t){ .file = file, .line = line };
+  void *ptr = al->calloc(al, count, sz);
+  mem_prof_call_site_ = (mem_prof_call_site_t){0};
+
+  return ptr;
+}
+
+MEM_API void *mem_realloc_at(const mem_allocator_t *const al, void *ptr, const size_t old_sz, const size_t new_sz,
+                             const char *const file, const int line)
+{
+  mem_prof_call_site_ = (mem_prof_call_site_t){ .file = file, .line = line };
+  void *new_ptr = al->realloc(al, ptr, old_sz, new_sz);
+  mem_prof_call_site_ = (mem_prof_call_site_t){0};
+
+  return new_ptr;
+}
+
 #endif // ZDX_MEMORY_IMPLEMENTATION
 #endif // ZDX_MEMORY_H_
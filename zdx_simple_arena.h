@@ -30,11 +30,89 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #pragma GCC diagnostic error "-Wnonnull"
 #pragma GCC diagnostic error "-Wnull-dereference"
 #pragma GCC diagnostic error "-Wsign-conversion"
 
+/*
+ * Header placed at the start of every mmap'd block of a growable arena.
+ * Blocks are chained in the order they were acquired and are retained across
+ * arena_reset() so that a reset arena can be refilled without calling mmap again.
+ */
+typedef struct arena_block {
+  struct arena_block *next;
+  size_t size; /* total size of the block including this header */
+} arena_block_t;
+
+/* What arena_reset() does with memory beyond the "reset_retain" bytes of an arena */
+typedef enum arena_reset_policy {
+  ARENA_RESET_RETAIN = 0, /* arena_reset() only rewinds the arena in O(1). This is the default */
+  ARENA_RESET_DECOMMIT,   /* arena_reset() also gives memory back to the OS right away via MADV_DONTNEED */
+  ARENA_RESET_FREE,       /* like ARENA_RESET_DECOMMIT but via MADV_FREE so the OS only takes it back under memory pressure */
+} arena_reset_policy_t;
+
+/* Flags for arena_create_with_flags(). They can be OR'd together */
+typedef enum arena_create_flags {
+  ARENA_CREATE_DEFAULT = 0,
+  ARENA_CREATE_THP = 1 << 0,      /* ask for transparent huge pages via madvise(MADV_HUGEPAGE) */
+  ARENA_CREATE_HUGETLB = 1 << 1,  /* explicit huge pages via MAP_HUGETLB. Falls back to ARENA_CREATE_THP */
+  ARENA_CREATE_PREFAULT = 1 << 2, /* fault in every page at creation via MAP_POPULATE or by touching each page */
+} arena_create_flags_t;
+
+#if defined(SA_STATS_ENABLE)
+#include <stdio.h> /* for FILE in arena_stats_dump */
+
+/*
+ * Usage statistics of an arena. Only tracked if SA_STATS_ENABLE is defined (consistently for every
+ * file that includes this header) so that arenas pay nothing for them otherwise.
+ * They accumulate over the lifetime of the arena and are not cleared by arena_reset().
+ * arena_alloc_concurrent() does not update them to keep its hot path a single compare and swap.
+ */
+typedef struct arena_stats {
+  size_t alloc_count;     /* successful allocations */
+  size_t bytes_requested; /* sum of the sizes requested by successful allocations */
+  size_t bytes_padding;   /* bytes lost to alignment padding by successful allocations */
+  size_t peak_offset;     /* highest offset the arena (or a block of a growable arena) was bumped to */
+  size_t reset_count;
+  size_t enomem_count;    /* allocations that failed due to the arena running out of memory */
+} arena_stats_t;
+#endif // SA_STATS_ENABLE
+
+/*
+ * Header placed at the start of the mapping of a file backed arena (see arena_open_file()) or a shared
+ * arena (see arena_create_shared()). It only uses fixed width types as it is written to disk and read
+ * back by later processes or mapped by other processes at the same time. For shared arenas, "offset" is
+ * the live bump offset that every process bumps atomically.
+ * It is padded to 64 bytes so that the usable region of the arena starts cache line aligned.
+ */
+typedef struct arena_header {
+  uint64_t magic;   /* SA_HEADER_MAGIC */
+  uint64_t version; /* SA_HEADER_VERSION */
+  uint64_t size;    /* size of the whole mapping including this header */
+  uint64_t offset;  /* bump offset into the usable region. Written back by arena_sync() and arena_free() */
+  uint64_t root;    /* offset of the root object from the start of the usable region + 1. 0 means no root */
+  uint64_t flags;
+  uint64_t reserved[2];
+} arena_header_t;
+
+/*
+ * Self-relative pointers for data structures in file backed arenas. A relative pointer stores the
+ * distance from its own address to the address it points to, so structures stay valid no matter
+ * where the arena gets mapped in the next process. 0 is used as NULL (a pointer to itself).
+ *
+ * typedef struct node { int value; arena_relptr_t next; } node_t;
+ * arena_relptr_set(a->next, b);
+ * node_t *next = arena_relptr_get(a->next, node_t);
+ */
+typedef int64_t arena_relptr_t;
+
+#define arena_relptr_set(field, ptr)                                                    \
+  ((field) = (ptr) == NULL ? 0 : (arena_relptr_t)((uintptr_t)(ptr) - (uintptr_t)&(field)))
+#define arena_relptr_get(field, type) \
+  ((field) == 0 ? (type *)NULL : (type *)((uintptr_t)&(field) + (uintptr_t)(field)))
+
 typedef struct Arena {
   size_t size;
   size_t offset;
@@ -48,19 +126,183 @@ typedef struct Arena {
    * for their last call.
    */
   const char *err;
+  /*
+   * Only set for growable arenas (see arena_create_growable()). "arena", "size" and "offset"
+   * always describe the block currently being bump allocated from so that arena_alloc()
+   * does the same amount of work on its fast path for both growable and fixed arenas.
+   */
+  arena_block_t *first_block_;
+  arena_block_t *curr_block_;
+  /*
+   * Only set for reserved arenas (see arena_create_reserved()). "size" is the committed (usable)
+   * part of the reserved range and is grown in steps of commit_sz_ bytes.
+   */
+  size_t reserved_;
+  size_t commit_sz_;
+  /* can be set by the user at any time. Defaults to ARENA_RESET_RETAIN */
+  arena_reset_policy_t reset_policy;
+  /*
+   * can be set by the user at any time. The number of bytes from the start of the arena that stay
+   * resident when arena_reset() gives memory back to the OS as per reset_policy. Defaults to 0
+   */
+  size_t reset_retain;
+  /*
+   * Set by arena_create_with_flags() to the arena_create_flags_t flags that actually took effect,
+   * e.g., ARENA_CREATE_HUGETLB is not set here if there were no huge pages available.
+   */
+  unsigned create_flags;
+  /* Only set for file backed and shared arenas (see arena_open_file()). "arena" points right after it */
+  arena_header_t *header_;
+  /* Only set for shared arenas (see arena_create_shared()). Share it with other processes to map the arena */
+  int shared_fd;
+#if defined(SA_STATS_ENABLE)
+  arena_stats_t stats;
+#endif
 } arena_t;
 
+/*
+ * A saved position in an arena that it can be rewound to with arena_restore(). Markers
+ * must be restored in the reverse order they were saved in (i.e., like a stack) and only
+ * on the arena they were saved from.
+ */
+typedef struct arena_marker {
+  arena_block_t *block; /* only used by growable arenas */
+  size_t offset;
+} arena_marker_t;
+
+/* Scratch scope on top of an existing arena. See arena_scratch_begin() and arena_with_scratch() */
+typedef struct arena_scratch {
+  arena_t *arena;
+  arena_marker_t marker;
+} arena_scratch_t;
+
+/*
+ * Runs the block following it with a scratch scope on arena ar named "scratch". Everything
+ * allocated in ar inside the block is released when the block ends.
+ * Do not return, break or goto out of the block as that skips releasing the scratch memory.
+ *
+ * arena_with_scratch(scratch, &request_arena) {
+ *   char *tmp = arena_alloc(scratch.arena, 1024);
+ *   ...
+ * }
+ */
+#define arena_with_scratch(scratch, ar)                 \
+  for (arena_scratch_t scratch = arena_scratch_begin((ar)); \
+       (scratch).arena != NULL;                         \
+       arena_scratch_end((scratch)), (scratch).arena = NULL)
+
+#ifndef SA_CACHE_LINE_SIZE
+#define SA_CACHE_LINE_SIZE 64
+#endif // SA_CACHE_LINE_SIZE
+
+/*
+ * Pool of fixed size slots carved out of an arena with O(1) alloc and free. Freed slots are kept
+ * in an intrusive singly linked list (the first bytes of a free slot point to the next free slot)
+ * and handed out again before new slots are carved out of the arena. See arena_pool_init().
+ */
+typedef struct arena_pool {
+  arena_t *arena;
+  size_t slot_size; /* size of each slot, rounded up to a multiple of alignment */
+  size_t alignment;
+  void *free_list;
+} arena_pool_t;
+
+/*
+ * Pool of slots for objects of type "type", aligned to _Alignof(type)
+ *
+ * arena_pool_t pool = arena_pool_init_type(&arena, node_t);
+ */
+#define arena_pool_init_type(ar, type) arena_pool_init((ar), sizeof(type), _Alignof(type))
+
+/*
+ * Stable 32-bit handle to a movable block of memory in an arena_handles_t. The low SA_HANDLE_INDEX_BITS
+ * bits are the index of the handle's slot + 1 and the high bits are a generation that changes every time
+ * the slot is reused, so a stale handle to a freed block is caught rather than pointing to another block.
+ * 0 is never a valid handle.
+ */
+typedef uint32_t arena_handle_t;
+
+#ifndef SA_HANDLE_INDEX_BITS
+#define SA_HANDLE_INDEX_BITS 20
+#endif // SA_HANDLE_INDEX_BITS
+
+typedef struct arena_handle_slot {
+  size_t offset;       /* offset of the block in the arena while live */
+  uint32_t generation;
+  uint32_t next_free;  /* index + 1 of the next free slot while free, 0 for the last one */
+  bool live;
+} arena_handle_slot_t;
+
+/*
+ * Blocks of any size addressed by handles rather than pointers so that arena_handles_compact() can
+ * slide them down over the holes left by freed blocks. See arena_handles_init().
+ */
+typedef struct arena_handles {
+  arena_t *arena;
+  arena_handle_slot_t *slots; /* max_handles slots allocated from the arena up front */
+  uint32_t max_handles;
+  uint32_t slot_count;        /* slots that were handed out atleast once */
+  uint32_t free_slot;         /* index + 1 of the most recently freed slot, 0 if there is none */
+  size_t start;               /* offset in the arena of the first block */
+  size_t live_bytes;          /* bytes taken by live blocks including their headers */
+  size_t dead_bytes;          /* bytes taken by freed blocks that arena_handles_compact() gives back */
+} arena_handles_t;
+
+/*
+ * Typed allocations that are aligned to _Alignof(type) rather than to the size of the allocation.
+ *
+ * vec4_t *v = arena_alloc_type(&arena, vec4_t);
+ * float *samples = arena_alloc_array(&arena, float, 1024);
+ */
+#define arena_alloc_type(ar, type) ((type *)arena_alloc_aligned((ar), sizeof(type), _Alignof(type)))
+#define arena_alloc_array(ar, type, count) ((type *)arena_alloc_aligned((ar), sizeof(type) * (count), _Alignof(type)))
+#define arena_calloc_array(ar, type, count) ((type *)arena_calloc_aligned((ar), (count), sizeof(type), _Alignof(type)))
+
 arena_t arena_create(const size_t sz);
+arena_t arena_create_with_flags(size_t sz, const unsigned flags);
+arena_t arena_create_growable(const size_t sz);
+arena_t arena_create_reserved(const size_t reserve_sz, const size_t commit_sz);
 arena_t arena_create_from_buf(void *const buf, const size_t sz);
+arena_t arena_open_file(const char *const path, const size_t sz);
+bool arena_sync(arena_t *const ar);
+bool arena_set_root(arena_t *const ar, void *const ptr);
+void *arena_get_root(const arena_t *const ar);
+arena_t arena_create_shared(const size_t sz);
+arena_t arena_open_shared(const int fd);
 bool arena_free(arena_t *const ar);
 bool arena_reset(arena_t *const ar);
 void *arena_alloc(arena_t *const ar, const size_t sz);
 void *arena_calloc(arena_t *const ar, const size_t count, const size_t sz);
+void *arena_alloc_aligned(arena_t *const ar, const size_t sz, const size_t alignment);
+void *arena_calloc_aligned(arena_t *const ar, const size_t count, const size_t sz, const size_t alignment);
 void *arena_realloc(arena_t *const ar, void *ptr, const size_t old_sz, const size_t new_sz);
+bool arena_free_last(arena_t *const ar, void *const ptr, const size_t sz);
+void *arena_alloc_concurrent(arena_t *const ar, const size_t sz);
+arena_marker_t arena_save(const arena_t *const ar);
+bool arena_restore(arena_t *const ar, const arena_marker_t marker);
+arena_scratch_t arena_scratch_begin(arena_t *const ar);
+void arena_scratch_end(const arena_scratch_t scratch);
+arena_scratch_t arena_scratch_get(arena_t *const conflicts[], const size_t conflicts_count);
+bool arena_scratch_pool_free(void);
+arena_pool_t arena_pool_init(arena_t *const ar, const size_t obj_sz, const size_t alignment);
+void *arena_pool_alloc(arena_pool_t *const pool);
+void arena_pool_free(arena_pool_t *const pool, void *const ptr);
+void arena_pool_reset(arena_pool_t *const pool);
+arena_handles_t arena_handles_init(arena_t *const ar, const uint32_t max_handles);
+arena_handle_t arena_handles_alloc(arena_handles_t *const handles, const size_t sz);
+void *arena_handles_get(const arena_handles_t *const handles, const arena_handle_t handle);
+bool arena_handles_free(arena_handles_t *const handles, const arena_handle_t handle);
+size_t arena_handles_compact(arena_handles_t *const handles);
+void arena_handles_reset(arena_handles_t *const handles);
+#if defined(SA_STATS_ENABLE)
+void arena_stats_dump(const arena_t *const ar, FILE *const stream);
+#endif
 
 #endif // ZDX_SIMPLE_ARENA_H_
 
-#ifdef ZDX_SIMPLE_ARENA_IMPLEMENTATION
+/* guarded separately as zdx_memory.h may include this header again after the implementation */
+#if defined(ZDX_SIMPLE_ARENA_IMPLEMENTATION) && !defined(ZDX_SIMPLE_ARENA_IMPLEMENTATION_INCLUDED_)
+#define ZDX_SIMPLE_ARENA_IMPLEMENTATION_INCLUDED_
 
 #include <stdint.h>
 #include <string.h> /* for memset in arena_create and memcpy in arena_realloc */
@@ -77,11 +319,27 @@ void *arena_realloc(arena_t *const ar, void *ptr, const size_t old_sz, const siz
 #define ar_dbg(...)
 #endif
 
+#if defined(SA_STATS_ENABLE)
+#define ar_stats_alloc(ar, sz, padding) ((ar)->stats.alloc_count++,           \
+                                         (ar)->stats.bytes_requested += (sz), \
+                                         (ar)->stats.bytes_padding += (padding))
+#define ar_stats_peak(ar) ((ar)->stats.peak_offset = (ar)->offset > (ar)->stats.peak_offset ? (ar)->offset : (ar)->stats.peak_offset)
+#define ar_stats_inc(ar, field) ((ar)->stats.field++)
+#else
+#define ar_stats_alloc(...)
+#define ar_stats_peak(...)
+#define ar_stats_inc(...)
+#endif
+
 /* gg windows */
 #if defined(__unix__) || defined(__unix) || defined(__linux__) || defined(__APPLE__) || defined(__MACH__)
 
+#include <errno.h> /* for the MADV_FREE fallback in arena_release_pages_ */
+#include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h> /* for freeing the scratch arenas of a thread when it exits */
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 typedef enum {
   ARENA_ENOMEM = 0,
@@ -106,30 +364,35 @@ static const char *arena_get_err_msg_(arena_err_code_t err_code)
 
 #define SA_DEFAULT_PAGE_SIZE_IF_UNDEF 4096
 
+/* This function never fails and falls back to SA_DEFAULT_PAGE_SIZE_IF_UNDEF if sysconf does */
+static inline size_t arena_page_size_(void)
+{
+  long page_size = sysconf(_SC_PAGESIZE);
+
+  if (page_size < 0) {
+    dbg("!! sysconf failed. Will use %d as page size", SA_DEFAULT_PAGE_SIZE_IF_UNDEF);
+  }
+
+  /* use SA_DEFAULT_PAGE_SIZE_IF_UNDEF if sysconf failed (-1) or returned 0 for some reason */
+  return page_size <= 0 ? SA_DEFAULT_PAGE_SIZE_IF_UNDEF : (size_t)page_size;
+}
+
 /*
  * This function should never fail. When called with size sz <= 0,
  * it returns sz as-is as we want to only round up +ve values to
- * system page size.
+ * page_size which is the system page size or the huge page size.
  */
-static inline size_t arena_round_up_to_page_size_(size_t sz)
+static inline size_t arena_round_up_to_page_size_(size_t sz, const size_t page_size)
 {
   if (sz <= 0) {
     dbg("<< Invalid size to round up: %zu", sz);
     return sz;
   }
 
-  long page_size = sysconf(_SC_PAGESIZE);
-  dbg(">> size %zu \t| system page size %ld", sz, page_size);
-
-  if (page_size < 0) {
-    dbg("!! sysconf failed. Will round up to %d", SA_DEFAULT_PAGE_SIZE_IF_UNDEF);
-  }
-
-  /* round up to SA_DEFAULT_PAGE_SIZE_IF_UNDEF if sysconf failed (-1) or returned 0 for some reason */
-  page_size = page_size <= 0 ? SA_DEFAULT_PAGE_SIZE_IF_UNDEF : page_size;
+  dbg(">> size %zu \t| page size %zu", sz, page_size);
 
   /* round up requested size of a multiple of page_size + 1 page size bytes more */
-  size_t rounded_up_sz = sz < (size_t)page_size ? (size_t)page_size : ((sz / (size_t)page_size) + 1) * (size_t)page_size;
+  size_t rounded_up_sz = sz < page_size ? page_size : ((sz / page_size) + 1) * page_size;
 
   dbg("<< rounded up size %zu", rounded_up_sz);
   return rounded_up_sz;
@@ -171,7 +434,7 @@ arena_t arena_create(size_t sz)
    * in arena_free(). Also, arena_create(0) failing just makes sense from the API consumer's
    * perspective imho.
    */
-  sz = arena_round_up_to_page_size_(sz);
+  sz = arena_round_up_to_page_size_(sz, arena_page_size_());
 
   /* MAP_PRIVATE or MAP_SHARED must always be specified */
   /* from mmap man page - "Conforming applications must specify either MAP_PRIVATE or MAP_SHARED." */
@@ -194,6 +457,164 @@ arena_t arena_create(size_t sz)
   return ar;
 }
 
+#ifndef SA_HUGE_PAGE_SIZE
+#define SA_HUGE_PAGE_SIZE ((size_t)2 * 1024 * 1024) /* 2 MiB is the default huge page size on x86_64 and aarch64 linux */
+#endif // SA_HUGE_PAGE_SIZE
+
+#if defined(MADV_HUGEPAGE)
+/*
+ * mmaps sz bytes aligned to align bytes as THP can only back naturally aligned huge page ranges.
+ * It maps sz + align bytes and unmaps the unaligned head and the tail. Returns MAP_FAILED on failure.
+ */
+static void *arena_map_aligned_(const size_t sz, const size_t align)
+{
+  void *mem = mmap(NULL, sz + align, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+  if (mem == MAP_FAILED) {
+    return mem;
+  }
+
+  uintptr_t start = (uintptr_t)mem;
+  uintptr_t aligned_start = (start + align - 1) & ~(uintptr_t)(align - 1);
+  size_t head = aligned_start - start;
+  size_t tail = align - head;
+
+  if (head) {
+    munmap(mem, head);
+  }
+  if (tail) {
+    munmap((void *)(aligned_start + sz), tail);
+  }
+
+  return (void *)aligned_start;
+}
+#endif // MADV_HUGEPAGE
+
+/* writes to every page so that the kernel faults them all in now rather than on first use */
+static inline void arena_prefault_(void *const mem, const size_t sz)
+{
+  const size_t page_size = arena_page_size_();
+
+  for (size_t i = 0; i < sz; i += page_size) {
+    ((volatile char *)mem)[i] = 0;
+  }
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function creates an arena just like arena_create() but lets the caller pick how the
+ * backing memory is paged in with arena_create_flags_t flags OR'd together -
+ *
+ * ARENA_CREATE_THP: the arena is aligned to SA_HUGE_PAGE_SIZE and madvise(MADV_HUGEPAGE) is called
+ * on it so that the kernel can back it with transparent huge pages, which cuts down on TLB misses.
+ * ARENA_CREATE_HUGETLB: the arena is mapped with MAP_HUGETLB from the pool of pre-allocated huge pages
+ * (see /proc/sys/vm/nr_hugepages). If that fails, it falls back to ARENA_CREATE_THP.
+ * ARENA_CREATE_PREFAULT: every page is faulted in at creation via MAP_POPULATE or by writing to each
+ * page (after madvise() when THP is requested), so that hot loops don't take page faults later on.
+ *
+ * With either of the huge page flags, the size is rounded up to SA_HUGE_PAGE_SIZE (2 MiB by default)
+ * instead of the system page size.
+ *
+ * RETURN VALUES
+ *
+ * Success: The newly created arena is returned by value just like arena_create(). The "create_flags"
+ * property is set to the flags that actually took effect.
+ * Error: If there was an error, then an empty arena is created that has no backing memory
+ * and the "err" property is set with the error message. It can be passed to arena_free().
+ *
+ * NOTES
+ *
+ * Huge pages are a request to the OS and not a guarantee. Flags that are not supported by the
+ * platform are ignored, e.g., on macOS only ARENA_CREATE_PREFAULT has any effect. Check "create_flags"
+ * if you need to know what you got. Transparent huge pages also need to be enabled system wide
+ * with "madvise" or "always" in /sys/kernel/mm/transparent_hugepage/enabled.
+ */
+arena_t arena_create_with_flags(size_t sz, const unsigned flags)
+{
+  dbg(">> requested size %zu \t| flags %u", sz, flags);
+
+  arena_t ar = {0};
+  const bool huge = flags & (ARENA_CREATE_THP | ARENA_CREATE_HUGETLB);
+  const bool prefault = flags & ARENA_CREATE_PREFAULT;
+  int map_flags = MAP_ANONYMOUS | MAP_PRIVATE;
+  bool populated = false; /* whether the mmap call that succeeded already faulted in every page */
+
+  if (sz <= 0) {
+    ar.err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  sz = arena_round_up_to_page_size_(sz, huge ? SA_HUGE_PAGE_SIZE : arena_page_size_());
+  ar.arena = MAP_FAILED;
+
+#if defined(MAP_POPULATE)
+  /* for THP, MAP_POPULATE would fault in normal pages before madvise() gets a chance to run */
+  const bool populate = prefault && !(flags & ARENA_CREATE_THP);
+  if (populate) {
+    map_flags |= MAP_POPULATE;
+  }
+#else
+  const bool populate = false;
+#endif
+
+#if defined(MAP_HUGETLB)
+  if (flags & ARENA_CREATE_HUGETLB) {
+    ar.arena = mmap(NULL, sz, PROT_READ | PROT_WRITE, map_flags | MAP_HUGETLB, -1, 0);
+
+    if (ar.arena != MAP_FAILED) {
+      ar.create_flags |= ARENA_CREATE_HUGETLB;
+      populated = populate;
+    } else {
+      dbg("!! MAP_HUGETLB failed for size %zu. Falling back to transparent huge pages", sz);
+    }
+  }
+#endif
+
+#if defined(MADV_HUGEPAGE)
+  if (ar.arena == MAP_FAILED && huge) {
+    ar.arena = arena_map_aligned_(sz, SA_HUGE_PAGE_SIZE);
+
+    if (ar.arena != MAP_FAILED && madvise(ar.arena, sz, MADV_HUGEPAGE) == 0) {
+      ar.create_flags |= ARENA_CREATE_THP;
+    }
+  }
+#endif
+
+  if (ar.arena == MAP_FAILED) {
+    ar.arena = mmap(NULL, sz, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+    populated = populate;
+  }
+
+  if (ar.arena == MAP_FAILED) {
+    ar.err = arena_get_err_msg_(ARENA_EACQFAIL);
+    ar.arena = NULL;
+    ar.create_flags = 0;
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  if (prefault) {
+    /* the THP path never maps with MAP_POPULATE so we touch the pages ourselves after madvise() */
+    if (!populated) {
+      arena_prefault_(ar.arena, sz);
+    }
+    ar.create_flags |= ARENA_CREATE_PREFAULT;
+  }
+
+#if defined(DEBUG)
+  memset(ar.arena, SA_DEBUG_BYTE, sz); // same as arena_create()
+#endif
+
+  ar.size = sz;
+
+  ar_dbg("<<", &ar);
+  return ar;
+}
+
 /*
  * DESCRIPTION
  *
@@ -235,40 +656,76 @@ arena_t arena_create_from_buf(void *const buf, const size_t sz)
   return ar;
 }
 
+#ifndef SA_GROWTH_FACTOR
+#define SA_GROWTH_FACTOR 2
+#endif // SA_GROWTH_FACTOR
+
+#define SA_BLOCK_HEADER_SIZE sizeof(arena_block_t)
+
+/* returns NULL if mmap failed. The returned block is not linked into any chain yet */
+static arena_block_t *arena_map_block_(size_t sz)
+{
+  sz = arena_round_up_to_page_size_(sz, arena_page_size_());
+
+  arena_block_t *block = mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+
+  if (block == MAP_FAILED) {
+    dbg("<< mmap failed for block of size %zu", sz);
+    return NULL;
+  }
+#if defined(DEBUG)
+  memset(block, SA_DEBUG_BYTE, sz); // same as arena_create()
+#endif
+
+  block->next = NULL;
+  block->size = sz;
+
+  dbg("<< block %p \t| size %zu", (void *)block, sz);
+  return block;
+}
+
+/* points the bump allocation members of the arena at the usable region of block */
+static inline void arena_use_block_(arena_t *const ar, arena_block_t *const block)
+{
+  ar->curr_block_ = block;
+  ar->arena = (void *)((uintptr_t)block + SA_BLOCK_HEADER_SIZE);
+  ar->size = block->size - SA_BLOCK_HEADER_SIZE;
+  ar->offset = 0;
+}
+
 /*
- * DESCRIPTION
- *
- * This function frees the memory backing the arena that's passed in.
- * arena_free() is a safe function to call even with an "invalid" arena that
- * for e.g., has "err" property set or is wrecked in some way so that
- * users aren't stuck with invalid arenas and with no way to clear them.
- * Also, from my tests on aarch64, munmap(NULL, size > 0) seems to always succeed.
- * Whereas, munmap(NULL, 0) always fails due to size being 0.
- * But that could be implementation specific.
- * Either way, munmap() failures are handled so we are good.
- *
- * RETURN VALUES
- *
- * Success: true is returned if the backing memory of the arena was freed.
- * Error: false is returned if an error occured and the "err" property is set to the
- * error message.
+ * Moves a growable arena onto a block that has atleast min_sz usable bytes. Blocks retained
+ * from before an arena_reset() are reused when they are large enough, otherwise a new block
+ * that is SA_GROWTH_FACTOR times the size of the current block (or large enough to hold min_sz
+ * bytes, whichever is larger) is mmap'd and linked in right after the current block.
  */
-bool arena_free(arena_t *const ar)
+static bool arena_grow_(arena_t *const ar, const size_t min_sz)
 {
   ar_dbg(">>", ar);
+  dbg(">> min size %zu", min_sz);
 
-  /* we leave error handling of NULL addr or size <= 0 to munmap */
-  if (munmap(ar->arena, ar->size) < 0) {
-    ar->err = arena_get_err_msg_(ARENA_ERELFAIL);
+  arena_block_t *curr = ar->curr_block_;
+  arena_block_t *next = curr->next;
 
-    ar_dbg("<<", ar);
-    return false;
+  if (next == NULL || (next->size - SA_BLOCK_HEADER_SIZE) < min_sz) {
+    size_t block_sz = curr->size * SA_GROWTH_FACTOR;
+    block_sz = block_sz < (min_sz + SA_BLOCK_HEADER_SIZE) ? (min_sz + SA_BLOCK_HEADER_SIZE) : block_sz;
+
+    arena_block_t *block = arena_map_block_(block_sz);
+
+    if (block == NULL) {
+      ar->err = arena_get_err_msg_(ARENA_EACQFAIL);
+
+      ar_dbg("<<", ar);
+      return false;
+    }
+
+    block->next = next;
+    curr->next = block;
+    next = block;
   }
 
-  ar->size = 0;
-  ar->offset = 0;
-  ar->arena = NULL;
-  ar->err = NULL;
+  arena_use_block_(ar, next);
 
   ar_dbg("<<", ar);
   return true;
@@ -277,258 +734,2115 @@ bool arena_free(arena_t *const ar)
 /*
  * DESCRIPTION
  *
- * This function resets an arena without deallocating the backing memory to allow
- * for reuse of the arena without the overhead of freeing and reallocation. It also
- * clears the "err" property of the arena. It always suceeds and can therefore, be
- * safely called without any guards.
+ * This function creates a growable arena whose first block has a backing memory of *atleast*
+ * size bytes. Unlike arenas from arena_create(), a growable arena never fails an allocation with
+ * ARENA_ENOMEM. Instead, when the current block is exhausted a new block is mmap'd and chained
+ * to it. Each new block is SA_GROWTH_FACTOR (2 by default) times the size of the one before it.
  *
  * RETURN VALUES
  *
- * Success: true is always returned.
- * Error: this function never fails/errors.
+ * Success: The newly created arena is returned by value just like arena_create().
+ * Error: If there was an error, then an empty arena is created that has no backing memory
+ * and the "err" property is set with the error message. It can be passed to arena_free().
  *
  * NOTES
  *
- * Given that this function clears the "err" property, if the arena *did* have an error
- * before this was called, the error will be lost upon returning from this function.
+ * arena_reset() on a growable arena is still O(1). It rewinds to the first block and retains
+ * all the blocks so that they are reused by subsequent allocations. Memory is only given back
+ * to the OS on arena_free().
+ * Pointers into a growable arena are never moved but consecutive allocations are not guaranteed
+ * to be contiguous as they might land in different blocks.
  */
-bool arena_reset(arena_t *const ar)
+arena_t arena_create_growable(const size_t sz)
 {
-  ar_dbg(">>", ar);
+  dbg(">> requested size %zu", sz);
 
-  ar->offset = 0;
-  ar->err = NULL;
+  arena_t ar = {0};
 
-  ar_dbg("<<", ar);
-  return true;
+  if (sz <= 0) {
+    ar.err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  arena_block_t *block = arena_map_block_(sz + SA_BLOCK_HEADER_SIZE);
+
+  if (block == NULL) {
+    ar.err = arena_get_err_msg_(ARENA_EACQFAIL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  ar.first_block_ = block;
+  arena_use_block_(&ar, block);
+
+  ar_dbg("<<", &ar);
+  return ar;
 }
 
-/* this is to enable cross platform tests that assume an alignment */
-#ifndef SA_DEFAULT_ALIGNMENT
-#define SA_DEFAULT_ALIGNMENT sizeof(max_align_t)
-#endif
+#ifndef SA_DEFAULT_RESERVE_SIZE
+#define SA_DEFAULT_RESERVE_SIZE ((size_t)64 * 1024 * 1024 * 1024) /* 64 GiB of address space. Not memory! */
+#endif // SA_DEFAULT_RESERVE_SIZE
+
+#ifndef SA_DEFAULT_COMMIT_SIZE
+#define SA_DEFAULT_COMMIT_SIZE ((size_t)1024 * 1024)
+#endif // SA_DEFAULT_COMMIT_SIZE
+
+/* rounds sz up to the nearest multiple of "multiple" without adding an extra multiple like arena_round_up_to_page_size_ does */
+static inline size_t arena_round_up_to_multiple_(const size_t sz, const size_t multiple)
+{
+  return ((sz + multiple - 1) / multiple) * multiple;
+}
 
 /*
- * Unaligned memory accesses occur when you try to read N bytes of data
- * starting from an address that is not evenly divisible by N (i.e. addr % N != 0).
- * For example, reading 4 bytes of data from address 0x10004 is fine,
- * but reading 4 bytes of data from address 0x10005 would be an unaligned memory access.
- *
- * Source: https://www.kernel.org/doc/html/v6.1/core-api/unaligned-memory-access.html#the-definition-of-an-unaligned-access
- *
- * Also, this is wasteful alignment as knowing proper alignment requires knowing the type
- * so that we can use _Alignof() for example. But this comes from the quote below -
- *
- * Pointers returned by allocation functions such as malloc are suitably aligned for any object,
- * which means they are aligned at least as strictly as max_align_t. max_align_t is usually
- * synonymous with the largest scalar type, which is long double on most platforms, and
- * its alignment requirement is either 8 or 16.
- *
- * Source: https://en.cppreference.com/w/c/types/max_align_t and https://stackoverflow.com/a/60133364
+ * Commits enough of the reserved range for the arena to have atleast min_sz usable bytes.
+ * Memory is committed in multiples of ar->commit_sz_ so that we don't call mprotect on every
+ * allocation. It sets ar->err and returns false on failure.
  */
-static inline size_t arena_get_alignment_(size_t sz)
+static bool arena_commit_(arena_t *const ar, const size_t min_sz)
 {
-  /* this guard is so that we don't return an alignment value > SA_DEFAULT_ALIGNMENT */
-  if (sz < SA_DEFAULT_ALIGNMENT) {
+  ar_dbg(">>", ar);
+  dbg(">> min size %zu", min_sz);
+
+  if (min_sz > ar->reserved_) {
+    ar->err = arena_get_err_msg_(ARENA_ENOMEM);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  size_t new_sz = arena_round_up_to_multiple_(min_sz, ar->commit_sz_);
+  new_sz = new_sz > ar->reserved_ ? ar->reserved_ : new_sz;
+
+  void *commit_start = (void *)((uintptr_t)ar->arena + ar->size);
+  size_t commit_len = new_sz - ar->size;
+
+  if (mprotect(commit_start, commit_len, PROT_READ | PROT_WRITE) < 0) {
+    ar->err = arena_get_err_msg_(ARENA_EACQFAIL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+#if defined(DEBUG)
+  memset(commit_start, SA_DEBUG_BYTE, commit_len); // same as arena_create()
+#endif
+
+  ar->size = new_sz;
+
+  ar_dbg("<<", ar);
+  return true;
+}
+
+#define SA_HEADER_MAGIC ((uint64_t)0x5a44584152454e41) /* "ZDXARENA" */
+#define SA_HEADER_VERSION ((uint64_t)1)
+#define SA_HEADER_SIZE sizeof(arena_header_t)
+#define SA_HEADER_SHARED ((uint64_t)1 << 0) /* header flag for arenas from arena_create_shared() */
+
+/* shared arenas have a header just like file backed ones but their offset only ever lives in it */
+static inline bool arena_is_shared_(const arena_t *const ar)
+{
+  return ar->header_ != NULL && (ar->header_->flags & SA_HEADER_SHARED);
+}
+
+/*
+ * madvise()s the whole pages of page_size bytes within [start, end) with advice. MADV_FREE falls back to MADV_DONTNEED
+ * on kernels that don't support it. Returns false if madvise() failed.
+ */
+static bool arena_release_pages_(const uintptr_t start, const uintptr_t end, const uintptr_t page_size, const int advice)
+{
+  const uintptr_t page_start = (start + page_size - 1) & ~(page_size - 1);
+  const uintptr_t page_end = end & ~(page_size - 1);
+
+  if (page_start >= page_end) {
+    return true;
+  }
+
+  dbg("++ releasing %p - %p (advice %d)", (void *)page_start, (void *)page_end, advice);
+
+  if (madvise((void *)page_start, page_end - page_start, advice) == 0) {
+    return true;
+  }
+
+#if defined(MADV_FREE)
+  if (advice == MADV_FREE && errno == EINVAL) {
+    return madvise((void *)page_start, page_end - page_start, MADV_DONTNEED) == 0;
+  }
+#endif
+
+  return false;
+}
+
+/*
+ * Gives the memory of the arena beyond the first ar->reset_retain bytes back to the OS as per
+ * ar->reset_policy. For reserved arenas, atleast the first commit_sz_ bytes are retained and the rest
+ * is also made inaccessible again. For growable arenas, reset_retain bytes are retained across the
+ * chain of blocks starting from the first one and block headers are never released.
+ * It sets ar->err and returns false on failure.
+ */
+static bool arena_decommit_(arena_t *const ar)
+{
+  ar_dbg(">>", ar);
+
+  int advice = MADV_DONTNEED;
+#if defined(MADV_FREE)
+  if (ar->reset_policy == ARENA_RESET_FREE) {
+    advice = MADV_FREE;
+  }
+#endif
+
+  /* MADV_DONTNEED and MADV_FREE only unmap shared memory pages from this process, MADV_REMOVE frees them */
+  if (arena_is_shared_(ar)) {
+#if defined(MADV_REMOVE)
+    advice = MADV_REMOVE;
+#else
+    ar->err = arena_get_err_msg_(ARENA_ERELFAIL);
+
+    ar_dbg("<<", ar);
+    return false;
+#endif
+  }
+
+  /* hugetlb mappings can only be madvise()'d in multiples of the huge page size */
+  const size_t page_size = ar->create_flags & ARENA_CREATE_HUGETLB ? SA_HUGE_PAGE_SIZE : arena_page_size_();
+  bool released = true;
+
+  if (ar->reserved_) {
+    const size_t retain = ar->reset_retain > ar->commit_sz_ ? ar->reset_retain : ar->commit_sz_;
+    const size_t keep = arena_round_up_to_multiple_(retain, ar->commit_sz_);
+
+    if (ar->size > keep) {
+      void *decommit_start = (void *)((uintptr_t)ar->arena + keep);
+      size_t decommit_len = ar->size - keep;
+
+      /* MADV_DONTNEED drops the pages so the RSS goes down and PROT_NONE makes any stray access fault */
+      released = arena_release_pages_((uintptr_t)decommit_start, (uintptr_t)decommit_start + decommit_len, page_size, advice) &&
+                 mprotect(decommit_start, decommit_len, PROT_NONE) == 0;
+
+      if (released) {
+        ar->size = keep;
+      }
+    }
+  } else if (ar->first_block_) {
+    size_t retain = ar->reset_retain;
+
+    /* try to release every block even if one of them fails just like arena_free() */
+    for (arena_block_t *block = ar->first_block_; block; block = block->next) {
+      const size_t usable = block->size - SA_BLOCK_HEADER_SIZE;
+      const size_t keep = retain < usable ? retain : usable;
+      const uintptr_t start = (uintptr_t)block + SA_BLOCK_HEADER_SIZE + keep;
+
+      if (!arena_release_pages_(start, (uintptr_t)block + block->size, page_size, advice)) {
+        released = false;
+      }
+      retain -= keep;
+    }
+  } else {
+    const uintptr_t start = (uintptr_t)ar->arena + (ar->reset_retain < ar->size ? ar->reset_retain : ar->size);
+    released = arena_release_pages_(start, (uintptr_t)ar->arena + ar->size, page_size, advice);
+  }
+
+  if (!released) {
+    ar->err = arena_get_err_msg_(ARENA_ERELFAIL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  ar_dbg("<<", ar);
+  return true;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function creates an arena that reserves reserve_sz bytes of virtual address space
+ * upfront but only commits (i.e., makes usable and backed by memory) commit_sz bytes of it
+ * at a time as allocations need it. Both sizes are rounded up to the page size of the machine.
+ * SA_DEFAULT_RESERVE_SIZE (64 GiB) and SA_DEFAULT_COMMIT_SIZE (1 MiB) are sane defaults.
+ *
+ * The whole arena is one contiguous range of memory that never moves. This means that, unlike
+ * a growable arena, consecutive allocations are always contiguous and the RSS of the process
+ * only grows with what is actually used.
+ *
+ * RETURN VALUES
+ *
+ * Success: The newly created arena is returned by value with the first commit_sz bytes committed.
+ * Error: If either size is 0, commit_sz is larger than reserve_sz or reserving/committing memory failed,
+ * then an empty arena is created that has no backing memory and the "err" property is set with the
+ * error message. It can be passed to arena_free().
+ *
+ * NOTES
+ *
+ * Set the "reset_policy" property to ARENA_RESET_DECOMMIT or ARENA_RESET_FREE for arena_reset() to
+ * also give back all but the first commit_sz bytes (or "reset_retain" bytes, if larger) to the OS.
+ * The default policy (ARENA_RESET_RETAIN) keeps arena_reset() O(1) and keeps everything committed
+ * so far around for reuse.
+ */
+arena_t arena_create_reserved(const size_t reserve_sz, const size_t commit_sz)
+{
+  dbg(">> reserve size %zu \t| commit size %zu", reserve_sz, commit_sz);
+
+  arena_t ar = {0};
+
+  if (reserve_sz <= 0 || commit_sz <= 0 || commit_sz > reserve_sz) {
+    ar.err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  const size_t page_size = arena_page_size_();
+  const size_t reserved = arena_round_up_to_multiple_(reserve_sz, page_size);
+
+  int flags = MAP_ANONYMOUS | MAP_PRIVATE;
+#ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE; /* don't count the reservation against swap/overcommit limits */
+#endif
+
+  ar.arena = mmap(NULL, reserved, PROT_NONE, flags, -1, 0);
+
+  if (ar.arena == MAP_FAILED) {
+    ar.err = arena_get_err_msg_(ARENA_EACQFAIL);
+    ar.arena = NULL;
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  ar.reserved_ = reserved;
+  ar.commit_sz_ = arena_round_up_to_multiple_(commit_sz, page_size);
+
+  if (!arena_commit_(&ar, ar.commit_sz_)) {
+    munmap(ar.arena, ar.reserved_);
+    ar.arena = NULL;
+    ar.size = 0;
+    ar.reserved_ = 0;
+    ar.commit_sz_ = 0;
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  ar_dbg("<<", &ar);
+  return ar;
+}
+
+/* checks that the header at the start of a mapping of map_sz bytes is one we wrote */
+static inline bool arena_header_valid_(const arena_header_t *const header, const size_t map_sz)
+{
+  return header->magic == SA_HEADER_MAGIC &&
+         header->version == SA_HEADER_VERSION &&
+         header->size == map_sz &&
+         header->offset <= map_sz - SA_HEADER_SIZE &&
+         header->root <= map_sz - SA_HEADER_SIZE;
+}
+
+/*
+ * leaves the file at path the way arena_open_file() found it after a failure and closes fd. A file that it
+ * created is removed and one that was empty before is truncated back to 0 bytes if it was sized (is_new)
+ */
+static void arena_undo_new_file_(const char *const path, const int fd, const bool created, const bool is_new)
+{
+  if (created) {
+    unlink(path);
+  } else if (is_new && ftruncate(fd, 0) < 0) {
+    dbg("!! could not truncate %s back to 0 bytes", path);
+  }
+  close(fd);
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function opens (or creates) the file at path and maps it with MAP_SHARED as the backing memory
+ * of an arena, so that whatever is allocated in the arena persists in the file and is there again the
+ * next time the file is opened, e.g., by the next run of the program. The file starts with an
+ * arena_header_t that records the offset of the arena and a root pointer (see arena_set_root()).
+ *
+ * If the file is empty, it is grown to sz bytes (rounded up to the page size, header included) and a
+ * fresh header is written. Otherwise sz is ignored, the whole file is mapped and the arena picks up
+ * from the offset saved in the header.
+ *
+ * RETURN VALUES
+ *
+ * Success: The arena is returned by value just like arena_create().
+ * Error: If opening, growing or mapping the file failed or the file has an invalid header (i.e., it wasn't
+ * created by this function), then an empty arena is created that has no backing memory and the "err"
+ * property is set with the error message. It can be passed to arena_free(). A file created by the failed
+ * call is removed again and an empty file that was passed in is left empty.
+ *
+ * NOTES
+ *
+ * The arena can be mapped at a different address each time, so data structures built in it must only
+ * point within the arena with arena_relptr_t (or plain offsets) and never with raw pointers.
+ * The offset is written to the header by arena_sync() and arena_free(). Everything allocated after the
+ * last one of those calls is lost if the process exits without calling either of them.
+ * The file is not locked and opening the same file as an arena in two processes at once is not supported
+ * (see arena_create_shared() for that).
+ * The header is written in the byte order of the machine.
+ */
+arena_t arena_open_file(const char *const path, const size_t sz)
+{
+  dbg(">> path %s \t| requested size %zu", path, sz);
+
+  arena_t ar = {0};
+
+  int fd = open(path, O_RDWR);
+  bool created = false;
+
+  /* only create the file once we know sz is valid so that a bad call doesn't leave an empty file behind */
+  if (fd < 0 && errno == ENOENT && sz > 0) {
+    fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    created = fd >= 0;
+  }
+
+  if (fd < 0) {
+    ar.err = arena_get_err_msg_(errno == ENOENT && sz <= 0 ? ARENA_EINVAL : ARENA_EACQFAIL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  struct stat st = {0};
+
+  if (fstat(fd, &st) < 0) {
+    ar.err = arena_get_err_msg_(ARENA_EACQFAIL);
+    arena_undo_new_file_(path, fd, created, false);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  size_t map_sz = (size_t)st.st_size;
+  /* an empty file (e.g., from mkstemp()) is turned into an arena just like one we created */
+  const bool is_new = map_sz == 0;
+
+  if (is_new) {
+    map_sz = arena_round_up_to_multiple_(sz + SA_HEADER_SIZE, arena_page_size_());
+
+    if (sz <= 0 || ftruncate(fd, (off_t)map_sz) < 0) {
+      ar.err = arena_get_err_msg_(sz <= 0 ? ARENA_EINVAL : ARENA_EACQFAIL);
+      arena_undo_new_file_(path, fd, created, is_new);
+
+      ar_dbg("<<", &ar);
+      return ar;
+    }
+  } else if (map_sz <= SA_HEADER_SIZE) {
+    ar.err = arena_get_err_msg_(ARENA_EINVAL);
+    close(fd);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  arena_header_t *header = mmap(NULL, map_sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (header == MAP_FAILED) {
+    ar.err = arena_get_err_msg_(ARENA_EACQFAIL);
+    /* a sized file without a header would be rejected by every later call */
+    arena_undo_new_file_(path, fd, created, is_new);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  /* the mapping keeps the file open so we don't need the fd anymore */
+  close(fd);
+
+  if (is_new) {
+    *header = (arena_header_t){
+      .magic = SA_HEADER_MAGIC,
+      .version = SA_HEADER_VERSION,
+      .size = map_sz,
+    };
+  } else if (!arena_header_valid_(header, map_sz)) {
+    dbg("!! invalid header in %s", path);
+    munmap(header, map_sz);
+    ar.err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  ar.header_ = header;
+  ar.arena = (void *)((uintptr_t)header + SA_HEADER_SIZE);
+  ar.size = map_sz - SA_HEADER_SIZE;
+  ar.offset = (size_t)header->offset;
+
+  ar_dbg("<<", &ar);
+  return ar;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function writes the offset of a file backed arena to its header and flushes the whole
+ * mapping to the file with msync() so that it survives a crash of the process or the machine.
+ *
+ * RETURN VALUES
+ *
+ * Success: true is returned.
+ * Error: If the arena is not file backed or msync() failed, then false is returned and the "err"
+ * property is set with the error message.
+ */
+bool arena_sync(arena_t *const ar)
+{
+  ar_dbg(">>", ar);
+
+  if (ar->header_ == NULL) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  /* shared arenas bump the offset in the header directly */
+  if (!arena_is_shared_(ar)) {
+    ar->header_->offset = ar->offset;
+  }
+
+  if (msync(ar->header_, (size_t)ar->header_->size, MS_SYNC) < 0) {
+    ar->err = arena_get_err_msg_(ARENA_ERELFAIL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  ar_dbg("<<", ar);
+  return true;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function records ptr as the root of a file backed arena, i.e., the entry point to whatever
+ * was built in the arena, so that it can be found again with arena_get_root() after a restart.
+ * Passing NULL clears the root.
+ *
+ * RETURN VALUES
+ *
+ * Success: true is returned.
+ * Error: If the arena is not file backed or ptr is not within the arena, then false is returned and
+ * the "err" property is set with the error message.
+ */
+bool arena_set_root(arena_t *const ar, void *const ptr)
+{
+  const bool in_arena = (uintptr_t)ptr >= (uintptr_t)ar->arena && (uintptr_t)ptr < (uintptr_t)ar->arena + ar->size;
+
+  if (ar->header_ == NULL || (ptr != NULL && !in_arena)) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  ar->header_->root = ptr == NULL ? 0 : (uint64_t)((uintptr_t)ptr - (uintptr_t)ar->arena) + 1;
+
+  return true;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function returns the root of a file backed arena set with arena_set_root() in this or an
+ * earlier process, translated to where the arena is mapped now.
+ *
+ * RETURN VALUES
+ *
+ * It returns the root or NULL if there is none or if the arena is not file backed.
+ */
+void *arena_get_root(const arena_t *const ar)
+{
+  if (ar->header_ == NULL || ar->header_->root == 0) {
+    return NULL;
+  }
+
+  return (void *)((uintptr_t)ar->arena + (uintptr_t)ar->header_->root - 1);
+}
+
+/* maps the shared memory behind fd and points the arena at it. It sets ar->err and returns false on failure */
+static bool arena_map_shared_(arena_t *const ar, const int fd, const size_t map_sz)
+{
+  arena_header_t *header = mmap(NULL, map_sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  if (header == MAP_FAILED) {
+    ar->err = arena_get_err_msg_(ARENA_EACQFAIL);
+    return false;
+  }
+
+  ar->header_ = header;
+  ar->arena = (void *)((uintptr_t)header + SA_HEADER_SIZE);
+  ar->size = map_sz - SA_HEADER_SIZE;
+  /* the live offset is in the shared header. This makes the non-atomic allocation functions fail with ARENA_ENOMEM */
+  ar->offset = ar->size;
+  ar->shared_fd = fd;
+
+  return true;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function creates an arena of atleast sz bytes in anonymous shared memory (memfd_create() on
+ * linux and an unlinked shm_open() object elsewhere) that can be mapped by other processes too. The
+ * bump offset lives in the arena_header_t at the start of the shared memory and is bumped atomically
+ * by arena_alloc_concurrent(), so threads of any process that has the arena mapped can allocate out of
+ * it at the same time. This lets producers allocate messages directly in shared memory and consumers
+ * read them in place without copying.
+ *
+ * Processes forked after this call inherit the mapping and can use the arena as-is. Other processes
+ * need the file descriptor in the "shared_fd" property (e.g., passed via SCM_RIGHTS or inherited across
+ * exec) to call arena_open_shared() with.
+ *
+ * RETURN VALUES
+ *
+ * Success: The arena is returned by value just like arena_create().
+ * Error: If sz is 0 or creating or mapping the shared memory failed, then an empty arena is created that
+ * has no backing memory and the "err" property is set with the error message. It can be passed to arena_free().
+ *
+ * NOTES
+ *
+ * Only arena_alloc_concurrent() allocates out of a shared arena. arena_alloc() and friends fail with
+ * ARENA_ENOMEM. arena_realloc(), arena_free_last() and arena_restore() fail with ARENA_EINVAL as they
+ * would move the offset of this process only. The arena can be mapped at a different address in each process, so only pass offsets
+ * from the "arena" property (or use arena_relptr_t) between processes and never raw pointers.
+ * arena_reset() rewinds the arena for every process. It is a data race with allocations in any process.
+ * With a reset policy other than ARENA_RESET_RETAIN, it also frees the pages with MADV_REMOVE so they
+ * read as zero in every process. See arena_reset() for platforms without MADV_REMOVE.
+ */
+arena_t arena_create_shared(const size_t sz)
+{
+  dbg(">> requested size %zu", sz);
+
+  arena_t ar = {0};
+
+  if (sz <= 0) {
+    ar.err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+  /* no MFD_CLOEXEC as passing the fd to exec'd workers is a valid way of sharing the arena */
+  int fd = memfd_create("zdx_simple_arena", 0);
+#else
+  /* the name only needs to be unique until it is unlinked right after */
+  static unsigned shm_counter = 0;
+  char shm_name[64] = {0};
+  snprintf(shm_name, sizeof(shm_name), "/zdx_arena_%ld_%u", (long)getpid(), __atomic_fetch_add(&shm_counter, 1, __ATOMIC_RELAXED));
+
+  int fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd >= 0) {
+    shm_unlink(shm_name);
+  }
+#endif
+
+  if (fd < 0) {
+    ar.err = arena_get_err_msg_(ARENA_EACQFAIL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  const size_t map_sz = arena_round_up_to_multiple_(sz + SA_HEADER_SIZE, arena_page_size_());
+
+  if (ftruncate(fd, (off_t)map_sz) < 0 || !arena_map_shared_(&ar, fd, map_sz)) {
+    ar.err = arena_get_err_msg_(ARENA_EACQFAIL);
+    close(fd);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  *ar.header_ = (arena_header_t){
+    .magic = SA_HEADER_MAGIC,
+    .version = SA_HEADER_VERSION,
+    .size = map_sz,
+    .flags = SA_HEADER_SHARED,
+  };
+
+  ar_dbg("<<", &ar);
+  return ar;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function maps a shared arena created by arena_create_shared() in another process from its file
+ * descriptor fd. The returned arena takes ownership of fd, which is closed by arena_free().
+ *
+ * RETURN VALUES
+ *
+ * Success: The arena is returned by value just like arena_create().
+ * Error: If fd is invalid, mapping it failed or it isn't a shared arena, then an empty arena is created
+ * that has no backing memory and the "err" property is set with the error message. fd is not closed in
+ * that case. The arena can be passed to arena_free().
+ */
+arena_t arena_open_shared(const int fd)
+{
+  dbg(">> fd %d", fd);
+
+  arena_t ar = {0};
+  struct stat st = {0};
+
+  if (fd < 0 || fstat(fd, &st) < 0 || (size_t)st.st_size <= SA_HEADER_SIZE) {
+    ar.err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  const size_t map_sz = (size_t)st.st_size;
+
+  if (!arena_map_shared_(&ar, fd, map_sz)) {
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  if (!arena_header_valid_(ar.header_, map_sz) || !arena_is_shared_(&ar)) {
+    munmap(ar.header_, map_sz);
+    ar = (arena_t){ .err = arena_get_err_msg_(ARENA_EINVAL) };
+
+    ar_dbg("<<", &ar);
+    return ar;
+  }
+
+  ar_dbg("<<", &ar);
+  return ar;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function frees the memory backing the arena that's passed in.
+ * arena_free() is a safe function to call even with an "invalid" arena that
+ * for e.g., has "err" property set or is wrecked in some way so that
+ * users aren't stuck with invalid arenas and with no way to clear them.
+ * Also, from my tests on aarch64, munmap(NULL, size > 0) seems to always succeed.
+ * Whereas, munmap(NULL, 0) always fails due to size being 0.
+ * But that could be implementation specific.
+ * Either way, munmap() failures are handled so we are good.
+ *
+ * RETURN VALUES
+ *
+ * Success: true is returned if the backing memory of the arena was freed.
+ * Error: false is returned if an error occured and the "err" property is set to the
+ * error message.
+ */
+bool arena_free(arena_t *const ar)
+{
+  ar_dbg(">>", ar);
+
+  if (ar->first_block_) {
+    bool released = true;
+    arena_block_t *block = ar->first_block_;
+
+    /* try to release every block even if one of them fails so that we leak as little as possible */
+    while (block) {
+      arena_block_t *next = block->next;
+
+      if (munmap(block, block->size) < 0) {
+        released = false;
+      }
+      block = next;
+    }
+
+    ar->first_block_ = NULL;
+    ar->curr_block_ = NULL;
+
+    if (!released) {
+      ar->size = 0;
+      ar->offset = 0;
+      ar->arena = NULL;
+      ar->err = arena_get_err_msg_(ARENA_ERELFAIL);
+
+      ar_dbg("<<", ar);
+      return false;
+    }
+  } else if (ar->header_) {
+    const bool shared = arena_is_shared_(ar);
+
+    /* file backed arenas persist their offset for the next time they are opened */
+    if (!shared) {
+      ar->header_->offset = ar->offset;
+    }
+
+    if (munmap(ar->header_, SA_HEADER_SIZE + ar->size) < 0) {
+      ar->err = arena_get_err_msg_(ARENA_ERELFAIL);
+
+      ar_dbg("<<", ar);
+      return false;
+    }
+
+    if (shared) {
+      close(ar->shared_fd);
+      ar->shared_fd = -1;
+    }
+    ar->header_ = NULL;
+  } else if (munmap(ar->arena, ar->reserved_ ? ar->reserved_ : ar->size) < 0) { /* we leave error handling of NULL addr or size <= 0 to munmap */
+    ar->err = arena_get_err_msg_(ARENA_ERELFAIL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  ar->reserved_ = 0;
+  ar->commit_sz_ = 0;
+  ar->size = 0;
+  ar->offset = 0;
+  ar->arena = NULL;
+  ar->err = NULL;
+
+  ar_dbg("<<", ar);
+  return true;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function resets an arena without deallocating the backing memory to allow
+ * for reuse of the arena without the overhead of freeing and reallocation. It also
+ * clears the "err" property of the arena. With the default reset policy (ARENA_RESET_RETAIN)
+ * it is O(1), always suceeds and can therefore, be safely called without any guards.
+ *
+ * With ARENA_RESET_DECOMMIT or ARENA_RESET_FREE, the pages beyond the first "reset_retain" bytes
+ * of the arena are also given back to the OS with madvise() so that an arena that spiked once
+ * doesn't keep its peak resident set forever. MADV_DONTNEED (ARENA_RESET_DECOMMIT) drops the pages
+ * right away and they are zero-filled on next use. MADV_FREE (ARENA_RESET_FREE) is cheaper as the OS
+ * only reclaims them under memory pressure, but the RSS doesn't go down until it does.
+ *
+ * RETURN VALUES
+ *
+ * Success: true is returned.
+ * Error: this function can only fail if the reset policy is not ARENA_RESET_RETAIN and giving
+ * memory back to the OS failed. In that case false is returned, the "err" property is set
+ * to the error message and the arena is still rewound.
+ *
+ * NOTES
+ *
+ * Reserved arenas always retain atleast their commit size and the rest is made inaccessible until it
+ * is committed again. Growable arenas keep all their blocks mapped and only give back their pages.
+ * For arenas from arena_create_from_buf(), only whole pages within the buffer are given back.
+ * Shared arenas free their pages for every process with MADV_REMOVE instead, as MADV_DONTNEED and
+ * MADV_FREE leave shared memory pages resident. Where MADV_REMOVE isn't available, they fail with
+ * ARENA_ERELFAIL and only ARENA_RESET_RETAIN works for them.
+ *
+ * Given that this function clears the "err" property, if the arena *did* have an error
+ * before this was called, the error will be lost upon returning from this function.
+ */
+bool arena_reset(arena_t *const ar)
+{
+  ar_dbg(">>", ar);
+
+  /* growable arenas rewind to their first block and keep the rest around for reuse */
+  if (ar->first_block_) {
+    arena_use_block_(ar, ar->first_block_);
+  }
+
+  ar->offset = 0;
+  ar->err = NULL;
+  ar_stats_inc(ar, reset_count);
+
+  /* shared arenas rewind the offset in the header for every process. See arena_map_shared_() for why ar->offset is the size */
+  if (arena_is_shared_(ar)) {
+    __atomic_store_n(&ar->header_->offset, 0, __ATOMIC_RELEASE);
+    ar->offset = ar->size;
+  }
+
+  if (ar->reset_policy != ARENA_RESET_RETAIN && !arena_decommit_(ar)) {
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  ar_dbg("<<", ar);
+  return true;
+}
+
+/* this is to enable cross platform tests that assume an alignment */
+#ifndef SA_DEFAULT_ALIGNMENT
+#define SA_DEFAULT_ALIGNMENT sizeof(max_align_t)
+#endif
+
+/*
+ * Unaligned memory accesses occur when you try to read N bytes of data
+ * starting from an address that is not evenly divisible by N (i.e. addr % N != 0).
+ * For example, reading 4 bytes of data from address 0x10004 is fine,
+ * but reading 4 bytes of data from address 0x10005 would be an unaligned memory access.
+ *
+ * Source: https://www.kernel.org/doc/html/v6.1/core-api/unaligned-memory-access.html#the-definition-of-an-unaligned-access
+ *
+ * Also, this is wasteful alignment as knowing proper alignment requires knowing the type
+ * so that we can use _Alignof() for example. But this comes from the quote below -
+ *
+ * Pointers returned by allocation functions such as malloc are suitably aligned for any object,
+ * which means they are aligned at least as strictly as max_align_t. max_align_t is usually
+ * synonymous with the largest scalar type, which is long double on most platforms, and
+ * its alignment requirement is either 8 or 16.
+ *
+ * Source: https://en.cppreference.com/w/c/types/max_align_t and https://stackoverflow.com/a/60133364
+ */
+static inline size_t arena_get_alignment_(size_t sz)
+{
+  /* this guard is so that we don't return an alignment value > SA_DEFAULT_ALIGNMENT */
+  if (sz < SA_DEFAULT_ALIGNMENT) {
     /* the branches below return "natural alignment" for values belows SA_DEFAULT_ALIGNMENT */
     /* the code below obviously assumes SA_DEFAULT_ALIGNMENT to be a max of 32 */
     if (sz <= 1) {
       return sz;
     }
-    if (sz <= 2) {
-      return 2;
+    if (sz <= 2) {
+      return 2;
+    }
+    if (sz <= 4) {
+      return 4;
+    }
+    if (sz <= 8) {
+      return 8;
+    }
+    if (sz <= 16) {
+      return 16;
+    }
+  }
+  return SA_DEFAULT_ALIGNMENT;
+}
+
+/* bump allocates sz bytes aligned to alignment which must be a power of 2. Shared by arena_alloc() and arena_alloc_aligned() */
+static inline void *arena_alloc_with_alignment_(arena_t *const ar, const size_t sz, const size_t alignment)
+{
+  ar_dbg(">>", ar);
+  dbg(">> requested size %zu \t| alignment %zu", sz, alignment);
+
+  /*
+   * Strict validity check as we don't want to allocate in invalid arenas to prevent
+   * data loss for the user.
+   * Although, We don't check for ar->err, as, for e.g. a previous allocation attempt
+   * might have failed due to ARENA_ENOMEM but the currently requested allocation
+   * _might_ fit in the remaining arena memory. We want to allow that.
+   *
+   * Also, as mentioned in the struct definition of arena_t,  ar->err is more for
+   * signaling error to the caller rather than using it for checks within functions
+   * in this lib. Functions here should do their own validations on the arena before
+   * proceeding or signal an error of their own. They should always clobber ar->err
+   * with their own reason for failure.
+   */
+  if (sz <= 0 || ar->arena == NULL || ar->size <= 0 || ar->offset < 0 || ar->offset > ar->size) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return NULL;
+  }
+
+  uintptr_t ptr = (uintptr_t)ar->arena + ar->offset;
+
+  if (sz > 0) {
+    size_t remainder = 0;
+
+    if ((remainder = ptr % alignment) != 0) {
+      size_t padding = alignment - remainder;
+      ptr += padding;
+      dbg("++ padding %zu", padding);
+    }
+    /* not using ptrdiff_t as ptr is guaranteed to be greater than ar->arena due to checks and ptr assignment above */
+    size_t ptr_offset = ptr - (uintptr_t)ar->arena;
+    /* the padding alone can run past the end of the arena, in which case nothing remains */
+    size_t remaining = ptr_offset < ar->size ? ar->size - ptr_offset : 0;
+    dbg("++ remaining %zu", remaining);
+
+    if (sz > remaining) {
+      /* non-resizeable arena hence we return NULL to signal error */
+      if (ar->curr_block_ == NULL && ar->reserved_ == 0) {
+        ar->err = arena_get_err_msg_(ARENA_ENOMEM);
+        ar_stats_inc(ar, enomem_count);
+
+        ar_dbg("<<", ar);
+        return NULL;
+      }
+
+      /* a sz this close to SIZE_MAX would wrap ptr_offset + sz or the size of the next block around to a small value */
+      if (ptr_offset > SIZE_MAX - alignment - SA_BLOCK_HEADER_SIZE ||
+          sz > SIZE_MAX - alignment - SA_BLOCK_HEADER_SIZE - ptr_offset) {
+        ar->err = arena_get_err_msg_(ARENA_ENOMEM);
+        ar_stats_inc(ar, enomem_count);
+
+        ar_dbg("<<", ar);
+        return NULL;
+      }
+
+      if (ar->reserved_) {
+        /* reserved arenas commit more memory in place so ptr stays valid. arena_commit_ sets ar->err on failure */
+        if (!arena_commit_(ar, ptr_offset + sz)) {
+          ar_stats_inc(ar, enomem_count);
+
+          ar_dbg("<<", ar);
+          return NULL;
+        }
+      } else {
+        /* + alignment as the usable region of the next block might need padding too. arena_grow_ sets ar->err on failure */
+        if (!arena_grow_(ar, sz + alignment)) {
+          ar_stats_inc(ar, enomem_count);
+
+          ar_dbg("<<", ar);
+          return NULL;
+        }
+
+        /* we are at the start of a fresh block now so redo the padding from there */
+        ptr = (uintptr_t)ar->arena;
+
+        if ((remainder = ptr % alignment) != 0) {
+          ptr += alignment - remainder;
+        }
+        ptr_offset = ptr - (uintptr_t)ar->arena;
+      }
+    }
+
+    dbg("++ padded ptr %p", (void *)ptr);
+    /* ar->offset is 0 here if we just moved to a new block */
+    ar_stats_alloc(ar, sz, ptr_offset - ar->offset);
+
+    /* we need to point to address after the one we are returning in ptr */
+    ar->offset = ptr_offset + sz;
+    ar_stats_peak(ar);
+  }
+
+  /* clear errors as the allocation was successful */
+  ar->err = NULL;
+
+  ar_dbg("<<", ar);
+  dbg("<< allocated ptr %p", (void *)ptr);
+  return (void *)ptr;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This allocates size bytes in the arena and returns a pointer to the beginning of
+ * the allocated memory. It is an aligned allocator. It uses natural alignment for
+ * size values below sizeof(max_align_t). Greater than that, it aligns to sizeof(max_align_t).
+ *
+ * RETURN VALUES
+ *
+ * Success: If arena is "valid" and size is > zero it either returns a pointer to the beginning
+ * of the allocated memory.
+ * Error: If either arena is "invalid" or size is <= 0 or allocation failed, then it sets
+ * the "err" property of the arena with the error message and returns NULL.
+ */
+void *arena_alloc(arena_t *const ar, const size_t sz)
+{
+  return arena_alloc_with_alignment_(ar, sz, arena_get_alignment_(sz));
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This allocates size bytes in the arena aligned to exactly "alignment" bytes instead of the size
+ * based alignment of arena_alloc(). Use it for buffers that need more than sizeof(max_align_t), e.g.,
+ * 64 byte cache line aligned data shared between threads or 32/64 byte aligned SIMD buffers, or for
+ * small objects that need less, so that they can be packed tightly. See arena_alloc_type() and
+ * arena_alloc_array() for the typed versions that use _Alignof() of the type.
+ *
+ * RETURN VALUES
+ *
+ * Success: If arena is "valid", size is > zero and alignment is a power of 2 it returns a pointer
+ * to the beginning of the allocated memory.
+ * Error: If either arena is "invalid" or size is <= 0 or alignment is not a power of 2 or allocation
+ * failed, then it sets the "err" property of the arena with the error message and returns NULL.
+ */
+void *arena_alloc_aligned(arena_t *const ar, const size_t sz, const size_t alignment)
+{
+  if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return NULL;
+  }
+
+  return arena_alloc_with_alignment_(ar, sz, alignment);
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function allocates memory for "count" objects, each of size bytes. It then zero-fills
+ * the memory region and returns a pointer to the beginning of the allocated memory.
+ *
+ * RETURN VALUES
+ *
+ * Success: If arena is "valid" and (count * size) is > zero it either returns a pointer to the beginning
+ * of the allocated memory or NULL if out of memory.
+ * Error: If either arena is "invalid" or size is <= 0, then it sets the "err" property of the arena with
+ * the error message and returns NULL.
+ */
+void *arena_calloc(arena_t *const ar, const size_t count, const size_t sz)
+{
+  dbg(">> count %zu \t| size %zu", count, sz);
+  size_t total_size = count * sz;
+  void *ptr = arena_alloc(ar, total_size);
+
+  if (ptr == NULL) {
+    dbg("<< Could not allocate memory");
+    return ptr;
+  }
+
+  /*
+   * not zeroing memory before returning as unix, linux and macos return zero-filled memory on MAP_ANONYMOUS
+   * unless DEBUG is defined as arena_create() in debug mode memset's the whole arena to SA_DEBUG_BYTE
+   * which is 0xcd by default. If we don't memset requested bytes to 0 in debug mode, functions that rely on
+   * arena_calloc zero-ing memory behavior will fail in debug mode.
+   */
+#if defined(DEBUG)
+  memset(ptr, 0, total_size);
+#endif
+
+  dbg("<< allocated ptr %p", ptr);
+  return ptr;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function is arena_calloc() with the alignment of arena_alloc_aligned(). It allocates memory
+ * for "count" objects, each of size bytes, aligned to "alignment" bytes and zero-fills it.
+ *
+ * RETURN VALUES
+ *
+ * Success: If arena is "valid", (count * size) is > zero and alignment is a power of 2 it returns a
+ * pointer to the beginning of the allocated memory.
+ * Error: If either arena is "invalid" or size is <= 0 or alignment is not a power of 2 or allocation
+ * failed, then it sets the "err" property of the arena with the error message and returns NULL.
+ */
+void *arena_calloc_aligned(arena_t *const ar, const size_t count, const size_t sz, const size_t alignment)
+{
+  dbg(">> count %zu \t| size %zu \t| alignment %zu", count, sz, alignment);
+  size_t total_size = count * sz;
+  void *ptr = arena_alloc_aligned(ar, total_size, alignment);
+
+  if (ptr == NULL) {
+    dbg("<< Could not allocate memory");
+    return ptr;
+  }
+
+  /* see arena_calloc() for why this is only done in debug mode */
+#if defined(DEBUG)
+  memset(ptr, 0, total_size);
+#endif
+
+  dbg("<< allocated ptr %p", ptr);
+  return ptr;
+}
+
+/*
+ * arena_alloc_concurrent() for shared arenas. It is the same compare and swap loop but on the offset in
+ * the shared header, which is a uint64_t rather than a size_t as it is mapped by other processes too.
+ */
+static void *arena_alloc_shared_(arena_t *const ar, const uintptr_t base, const size_t size,
+                                 const size_t sz, const size_t alignment)
+{
+  uint64_t offset = __atomic_load_n(&ar->header_->offset, __ATOMIC_RELAXED);
+  uint64_t new_offset = 0;
+  uintptr_t ptr = 0;
+
+  do {
+    ptr = base + (uintptr_t)offset;
+
+    size_t remainder = ptr % alignment;
+    if (remainder != 0) {
+      ptr += alignment - remainder;
+    }
+
+    /* checked before adding sz as a sz close to SIZE_MAX would wrap new_offset around to a small value */
+    if (offset > size || ptr - base > size || sz > size - (ptr - base)) {
+      __atomic_store_n(&ar->err, arena_get_err_msg_(ARENA_ENOMEM), __ATOMIC_RELAXED);
+
+      dbg("<< out of shared memory");
+      return NULL;
+    }
+
+    new_offset = (ptr - base) + sz;
+  } while (!__atomic_compare_exchange_n(&ar->header_->offset, &offset, new_offset, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  dbg("<< allocated ptr %p (offset %zu)", (void *)ptr, (size_t)(ptr - base));
+  return (void *)ptr;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This is a thread-safe version of arena_alloc() that lets many threads allocate out of one
+ * shared arena at the same time. The offset of the arena is bumped with an atomic compare and
+ * swap so alignment padding is computed for exactly the offset that gets claimed and allocations
+ * are aligned the same way arena_alloc() aligns them.
+ * Only arenas from arena_create(), arena_create_from_buf() and arena_create_shared() are supported
+ * as growing or committing more memory would require a lock. For shared arenas, the offset in the
+ * shared header is bumped instead, which makes this safe to call from many processes at once too.
+ *
+ * RETURN VALUES
+ *
+ * Success: a pointer to the beginning of the allocated memory is returned.
+ * Error: If either arena is "invalid", growable or reserved or size is <= 0 or the arena is full,
+ * then it sets the "err" property of the arena with the error message and returns NULL.
+ *
+ * NOTES
+ *
+ * Unlike arena_alloc(), a successful allocation does not clear the "err" property of the arena as
+ * another thread could have just set it. Always check the returned pointer instead.
+ * It is safe to mix this with arena_alloc_concurrent() calls from other threads only. Calling any other
+ * function in this lib on the same arena at the same time, for e.g. arena_reset(), is a data race.
+ */
+void *arena_alloc_concurrent(arena_t *const ar, const size_t sz)
+{
+  dbg(">> requested size %zu", sz);
+
+  if (sz <= 0 || ar->arena == NULL || ar->size <= 0 || ar->curr_block_ != NULL || ar->reserved_ != 0) {
+    __atomic_store_n(&ar->err, arena_get_err_msg_(ARENA_EINVAL), __ATOMIC_RELAXED);
+
+    dbg("<< invalid arena or size");
+    return NULL;
+  }
+
+  const uintptr_t base = (uintptr_t)ar->arena;
+  const size_t size = ar->size;
+  const size_t alignment = arena_get_alignment_(sz);
+
+  if (arena_is_shared_(ar)) {
+    return arena_alloc_shared_(ar, base, size, sz, alignment);
+  }
+
+  size_t offset = __atomic_load_n(&ar->offset, __ATOMIC_RELAXED);
+  size_t new_offset = 0;
+  uintptr_t ptr = 0;
+
+  do {
+    ptr = base + offset;
+
+    size_t remainder = ptr % alignment;
+    if (remainder != 0) {
+      ptr += alignment - remainder;
+    }
+
+    /* checked before adding sz as a sz close to SIZE_MAX would wrap new_offset around to a small value */
+    if (offset > size || ptr - base > size || sz > size - (ptr - base)) {
+      __atomic_store_n(&ar->err, arena_get_err_msg_(ARENA_ENOMEM), __ATOMIC_RELAXED);
+
+      dbg("<< out of memory");
+      return NULL;
+    }
+
+    new_offset = (ptr - base) + sz;
+    /* on failure, offset is updated to what another thread bumped it to and we redo the padding */
+  } while (!__atomic_compare_exchange_n(&ar->offset, &offset, new_offset, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+  dbg("<< allocated ptr %p", (void *)ptr);
+  return (void *)ptr;
+}
+
+/*
+ * Checks if the block of sz bytes starting at ptr lies within the arena. For growable arenas
+ * every block from the first one up to and including the current one is checked.
+ */
+static bool arena_contains_(const arena_t *const ar, const void *const ptr, const size_t sz)
+{
+  const uintptr_t start = (uintptr_t)ptr;
+  const uintptr_t end = start + sz;
+
+  if (ar->first_block_ == NULL) {
+    return ptr >= ar->arena && end < ((uintptr_t)ar->arena + ar->size);
+  }
+
+  for (const arena_block_t *block = ar->first_block_; block; block = block->next) {
+    const uintptr_t block_start = (uintptr_t)block + SA_BLOCK_HEADER_SIZE;
+    const uintptr_t block_end = (uintptr_t)block + block->size;
+
+    if (start >= block_start && end <= block_end) {
+      return true;
     }
-    if (sz <= 4) {
-      return 4;
+
+    /* blocks after the current one only hold data from before the last arena_reset() */
+    if (block == ar->curr_block_) {
+      break;
     }
-    if (sz <= 8) {
-      return 8;
+  }
+
+  return false;
+}
+
+/*
+ * checks if the sz bytes starting at ptr are the most recent allocation in the arena. Never true for shared
+ * arenas as ar->offset is pinned to the size there and moving it would let arena_alloc() hand out memory that
+ * other processes own (see arena_map_shared_())
+ */
+static inline bool arena_is_last_(const arena_t *const ar, const void *const ptr, const size_t sz)
+{
+  return ar->arena != NULL && !arena_is_shared_(ar) && (uintptr_t)ptr >= (uintptr_t)ar->arena &&
+         (uintptr_t)ptr + sz == (uintptr_t)ar->arena + ar->offset;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function reallocates the memory pointed to by ptr from old_sz to new_sz. If ptr + old_sz is
+ * the most recent allocation in the arena, it is grown or shrunk in place by moving the offset of the
+ * arena and ptr is returned as-is. Otherwise, it allocates new_sz bytes ahead in the arena and then
+ * copies over old_sz bytes starting from ptr to newly allocated memory.
+ * If ptr is NULL, then this function behaves like arena_alloc().
+ *
+ * RETURN VALUES
+ *
+ * Success: If arena is "valid" and the ptr + old_sz block is within the arena, a pointer to
+ * the new memory allocation is returned.
+ * Error: If either arena is "invalid" or ptr + old_sz block is outside of arena, then it sets
+ * the "err" property of the arena with the error message and returns NULL.
+ *
+ * NOTES
+ *
+ * Since this is a simple arena allocator, we don't track the size of each allocation represented
+ * by a pointer to the arena memory. This means that, if ptr + old_sz is greater than the actual
+ * allocation size of the call that returned ptr but ptr + old_sz is still within the arena, then
+ * arena_realloc will not complain and copy ptr + old_sz bytes to the new allocation. This means
+ * that the new allocation will contain data from some other allocation.
+ * We are ok with trading this off for simplicity though as this allocator is meant to be freed
+ * often - for e.g., on each render loop of a game or text editor.
+ * In place growth means that growing a single buffer (e.g., a dynamic array or a string builder)
+ * that is the only thing being allocated into an arena never copies. Growable arenas still copy
+ * when the current block runs out as blocks are not contiguous.
+ */
+void *arena_realloc(arena_t *const ar, void *ptr, const size_t old_sz, const size_t new_sz)
+{
+  ar_dbg(">>", ar);
+  dbg(">> ptr to realloc %p \t| old size %zu \t| new size %zu", ptr, old_sz, new_sz);
+
+  /* if ptr is null, act like a call to arena_alloc() just like realloc() does */
+  /* also, old_sz is ignored when ptr is NULL so it can be 0, 12312, whatever */
+  if (ptr == NULL) {
+    void *new_ptr = arena_alloc(ar, new_sz);
+
+    if (new_ptr == NULL) {
+      dbg("<< Could not allocate memory");
+      return NULL;
     }
-    if (sz <= 16) {
-      return 16;
+
+    ar_dbg("<<", ar);
+    return new_ptr;
+  }
+
+  /* only arena_alloc_concurrent() can allocate out of a shared arena */
+  if (arena_is_shared_(ar)) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return NULL;
+  }
+
+  /* ptr is the most recent allocation so it can be resized without copying by moving the offset */
+  if (old_sz > 0 && new_sz > 0 && arena_is_last_(ar, ptr, old_sz)) {
+    const size_t ptr_offset = (uintptr_t)ptr - (uintptr_t)ar->arena;
+
+    /* reserved arenas can commit more memory in place. arena_commit_ sets ar->err on failure */
+    if (new_sz <= ar->size - ptr_offset ||
+        (ar->reserved_ && new_sz <= SIZE_MAX - ptr_offset && arena_commit_(ar, ptr_offset + new_sz))) {
+      ar->offset = ptr_offset + new_sz;
+      ar->err = NULL;
+      ar_stats_alloc(ar, new_sz > old_sz ? new_sz - old_sz : 0, 0);
+      ar_stats_peak(ar);
+
+      ar_dbg("<<", ar);
+      return ptr;
+    }
+    /* out of room in place. Growable arenas move to a new block below whereas others fail with ARENA_ENOMEM */
+  }
+
+  /* bounds check on the incoming ptr + old size combo to make sure they are within arena */
+  if (old_sz <= 0 || !arena_contains_(ar, ptr, old_sz)) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return NULL;
+  }
+
+  void *new_ptr = arena_alloc(ar, new_sz);
+
+  if (new_ptr == NULL) {
+    dbg("<< Could not allocate memory");
+    return NULL;
+  }
+
+  memcpy(new_ptr, ptr, new_sz < old_sz ? new_sz : old_sz);
+
+  ar_dbg("<<", ar);
+  return new_ptr;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function releases the most recent allocation in the arena by moving the offset of the arena
+ * back to ptr. ptr and sz must be exactly what the last call to arena_alloc(), arena_calloc() or
+ * arena_realloc() returned and was called with. This allows for LIFO (stack like) freeing on top
+ * of the usual free everything at once of arena_reset() and arena_free().
+ *
+ * RETURN VALUES
+ *
+ * Success: true is returned and the released memory is reused by the next allocation.
+ * Error: If ptr + sz is not the most recent allocation, then false is returned, the arena is left
+ * untouched and the "err" property is set with the error message.
+ *
+ * NOTES
+ *
+ * The alignment padding before ptr, if any, is not released. For growable arenas, only allocations
+ * in the current block can be released as we don't go back to an earlier block. Shared arenas always
+ * fail as other processes may have allocated right after ptr in the meantime.
+ */
+bool arena_free_last(arena_t *const ar, void *const ptr, const size_t sz)
+{
+  ar_dbg(">>", ar);
+  dbg(">> ptr to free %p \t| size %zu", ptr, sz);
+
+  if (sz <= 0 || !arena_is_last_(ar, ptr, sz)) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  ar->offset = (uintptr_t)ptr - (uintptr_t)ar->arena;
+  ar->err = NULL;
+
+  ar_dbg("<<", ar);
+  return true;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function returns a marker for the current position of the arena. Passing it to
+ * arena_restore() later releases everything allocated after this call in O(1).
+ *
+ * RETURN VALUES
+ *
+ * It always returns a marker and never fails.
+ */
+arena_marker_t arena_save(const arena_t *const ar)
+{
+  ar_dbg(">>", ar);
+
+  arena_marker_t marker = {
+    .block = ar->curr_block_,
+    .offset = ar->offset,
+  };
+
+  dbg("<< marker block %p \t| offset %zu", (void *)marker.block, marker.offset);
+  return marker;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function rewinds the arena to a marker returned by arena_save() in O(1) which releases
+ * every allocation made after the marker was saved. Allocations made before it are untouched.
+ * Just like arena_reset(), no memory is given back to the OS.
+ *
+ * RETURN VALUES
+ *
+ * Success: true is returned and the "err" property of the arena is cleared.
+ * Error: If the marker is ahead of the current position of the arena (e.g., it was restored out of
+ * order) or doesn't belong to a growable arena that is passed in, then false is returned and the "err"
+ * property is set with the error message. The arena is left untouched in that case.
+ *
+ * NOTES
+ *
+ * For growable arenas, we can only check in O(1) that a marker is not ahead of the current position
+ * if it was saved in the current block. Restoring a marker from another arena is undefined behavior.
+ * Shared arenas always fail as their offset is shared with other processes (use arena_reset() instead).
+ */
+bool arena_restore(arena_t *const ar, const arena_marker_t marker)
+{
+  ar_dbg(">>", ar);
+  dbg(">> marker block %p \t| offset %zu", (void *)marker.block, marker.offset);
+
+  if (arena_is_shared_(ar)) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  if (marker.block != ar->curr_block_) {
+    if (ar->curr_block_ == NULL || marker.block == NULL || marker.offset > marker.block->size - SA_BLOCK_HEADER_SIZE) {
+      ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+      ar_dbg("<<", ar);
+      return false;
+    }
+
+    /* marker is in an earlier block so make it the current block again */
+    arena_use_block_(ar, marker.block);
+  } else if (marker.offset > ar->offset) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return false;
+  }
+
+  ar->offset = marker.offset;
+  ar->err = NULL;
+
+  ar_dbg("<<", ar);
+  return true;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function starts a scratch scope on an arena that is already in use. Everything allocated in
+ * the arena after this call is released by calling arena_scratch_end() with the returned scratch.
+ * This lets one arena be used for both long lived allocations and short lived temporary ones.
+ * Scratch scopes can be nested as long as they are ended in the reverse order they were begun in.
+ * See arena_with_scratch() for a scoped version of this.
+ *
+ * RETURN VALUES
+ *
+ * It always returns a scratch scope and never fails.
+ */
+arena_scratch_t arena_scratch_begin(arena_t *const ar)
+{
+  return (arena_scratch_t){
+    .arena = ar,
+    .marker = arena_save(ar),
+  };
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function ends a scratch scope started by arena_scratch_begin() and releases everything that
+ * was allocated in the arena since. Nothing allocated in the scratch scope can be used after this.
+ *
+ * RETURN VALUES
+ *
+ * This function returns nothing. If restoring fails, the "err" property of the arena is set.
+ */
+void arena_scratch_end(const arena_scratch_t scratch)
+{
+  /* scratch.arena is NULL if arena_scratch_get() failed */
+  if (scratch.arena == NULL) {
+    return;
+  }
+
+  arena_restore(scratch.arena, scratch.marker);
+}
+
+/* no. of scratch arenas per thread. 2 is enough for a function to never scratch into the arena its caller allocates results in */
+#ifndef SA_SCRATCH_COUNT
+#define SA_SCRATCH_COUNT 2
+#endif // SA_SCRATCH_COUNT
+
+/* size of the first block of each scratch arena. They are growable so this is not a limit */
+#ifndef SA_SCRATCH_SIZE
+#define SA_SCRATCH_SIZE (64 * 1024)
+#endif // SA_SCRATCH_SIZE
+
+_Static_assert(SA_SCRATCH_COUNT > 0, "SA_SCRATCH_COUNT should be atleast 1");
+
+static _Thread_local arena_t arena_scratch_pool_[SA_SCRATCH_COUNT];
+
+/* only used to have pthread call arena_scratch_thread_exit_() when a thread that has scratch arenas exits */
+static pthread_key_t arena_scratch_key_;
+static pthread_once_t arena_scratch_key_once_ = PTHREAD_ONCE_INIT;
+static bool arena_scratch_key_ok_ = false;
+
+static void arena_scratch_thread_exit_(void *arg)
+{
+  (void)arg;
+  arena_scratch_pool_free();
+}
+
+static void arena_scratch_key_create_(void)
+{
+  arena_scratch_key_ok_ = pthread_key_create(&arena_scratch_key_, arena_scratch_thread_exit_) == 0;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function returns a scratch scope on one of the calling thread's scratch arenas. The scratch
+ * arenas are growable arenas that are lazily created on first use and are reused for the lifetime of
+ * the thread, so temporary allocations don't need an arena to be created or passed down to them.
+ *
+ * Pass the arenas that the caller is allocating results into as conflicts. The returned scratch
+ * arena is guaranteed to not be any of them, so that releasing the scratch memory never releases
+ * results that the caller wants to keep.
+ *
+ * arena_t *result_arena = ...;
+ * arena_scratch_t scratch = arena_scratch_get((arena_t *[]){ result_arena }, 1);
+ * char *tmp = arena_alloc(scratch.arena, 1024);
+ * ...
+ * arena_scratch_end(scratch);
+ *
+ * RETURN VALUES
+ *
+ * Success: a scratch scope that must be ended with arena_scratch_end()
+ * Error: If every scratch arena is in conflicts or creating a scratch arena failed, a scratch scope with
+ * a NULL arena is returned. arena_scratch_end() can still be safely called with it.
+ *
+ * NOTES
+ *
+ * Scratch arenas are freed automatically when a thread created with pthread_create() exits. This
+ * doesn't happen for the main thread, so call arena_scratch_pool_free() there (or in any thread that
+ * wants its memory back early) to give it back to the OS.
+ */
+arena_scratch_t arena_scratch_get(arena_t *const conflicts[], const size_t conflicts_count)
+{
+  dbg(">> conflicts %p \t| count %zu", (void *)conflicts, conflicts_count);
+
+  for (size_t i = 0; i < SA_SCRATCH_COUNT; i++) {
+    arena_t *const ar = &arena_scratch_pool_[i];
+    bool has_conflict = false;
+
+    for (size_t j = 0; j < conflicts_count; j++) {
+      if (conflicts[j] == ar) {
+        has_conflict = true;
+        break;
+      }
+    }
+
+    if (has_conflict) {
+      continue;
+    }
+
+    if (ar->arena == NULL) {
+      *ar = arena_create_growable(SA_SCRATCH_SIZE);
+
+      if (ar->err) {
+        dbg("<< failed to create scratch arena %zu: %s", i, ar->err);
+        return (arena_scratch_t){0};
+      }
+
+      /* any non-NULL value makes pthread call the destructor on thread exit. Without it, we leak like before */
+      pthread_once(&arena_scratch_key_once_, arena_scratch_key_create_);
+      if (arena_scratch_key_ok_ && pthread_setspecific(arena_scratch_key_, arena_scratch_pool_) != 0) {
+        dbg("++ scratch arenas will not be freed on thread exit");
+      }
+    }
+
+    dbg("<< scratch arena %zu (%p)", i, (void *)ar);
+    return arena_scratch_begin(ar);
+  }
+
+  dbg("<< all scratch arenas conflict");
+  return (arena_scratch_t){0};
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function frees the scratch arenas of the calling thread. Any scratch memory still in use
+ * becomes invalid. Scratch arenas are created again if arena_scratch_get() is called after this.
+ *
+ * RETURN VALUES
+ *
+ * Success: true is returned if every scratch arena of the calling thread was freed.
+ * Error: false is returned if freeing any of them failed.
+ */
+bool arena_scratch_pool_free(void)
+{
+  bool freed = true;
+
+  for (size_t i = 0; i < SA_SCRATCH_COUNT; i++) {
+    arena_t *const ar = &arena_scratch_pool_[i];
+
+    if (ar->arena != NULL && !arena_free(ar)) {
+      freed = false;
     }
   }
-  return SA_DEFAULT_ALIGNMENT;
+
+  return freed;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function creates a pool of slots of obj_sz bytes each, aligned to "alignment" bytes, that are
+ * carved out of arena ar on demand. Unlike allocations straight out of an arena, slots can be freed
+ * individually with arena_pool_free() and are reused by the next arena_pool_alloc() call, which makes
+ * pools a good fit for same sized objects that churn constantly, e.g., nodes or connection records.
+ * All slots are released in bulk by resetting the arena followed by arena_pool_reset().
+ *
+ * Passing SA_CACHE_LINE_SIZE as the alignment gives each slot its own cache line(s) so that objects
+ * used by different threads don't share a cache line (false sharing). Passing 0 uses the same alignment
+ * as arena_alloc() would for obj_sz bytes. See arena_pool_init_type() for a typed version.
+ *
+ * RETURN VALUES
+ *
+ * Success: The pool is returned by value. It does not allocate anything up front.
+ * Error: If obj_sz is 0 or alignment is not 0 or a power of 2, then a pool with a NULL "arena" is returned
+ * and the "err" property of the arena is set with the error message.
+ *
+ * NOTES
+ *
+ * Slots are atleast sizeof(void *) bytes as a free slot holds a pointer to the next free slot.
+ * A pool only tracks its free slots and not the arena, so it must be reset with arena_pool_reset()
+ * whenever the arena is reset (or restored to before any of its slots) otherwise it hands out stale slots.
+ */
+arena_pool_t arena_pool_init(arena_t *const ar, const size_t obj_sz, const size_t alignment)
+{
+  dbg(">> object size %zu \t| alignment %zu", obj_sz, alignment);
+
+  if (obj_sz <= 0 || (alignment & (alignment - 1)) != 0) {
+    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+
+    ar_dbg("<<", ar);
+    return (arena_pool_t){0};
+  }
+
+  size_t slot_alignment = alignment ? alignment : arena_get_alignment_(obj_sz);
+  /* free slots store a pointer to the next free slot */
+  slot_alignment = slot_alignment < _Alignof(void *) ? _Alignof(void *) : slot_alignment;
+  const size_t slot_size = arena_round_up_to_multiple_(obj_sz < sizeof(void *) ? sizeof(void *) : obj_sz, slot_alignment);
+
+  dbg("<< slot size %zu \t| slot alignment %zu", slot_size, slot_alignment);
+  return (arena_pool_t){
+    .arena = ar,
+    .slot_size = slot_size,
+    .alignment = slot_alignment,
+  };
 }
 
 /*
  * DESCRIPTION
  *
- * This allocates size bytes in the arena and returns a pointer to the beginning of
- * the allocated memory. It is an aligned allocator. It uses natural alignment for
- * size values below sizeof(max_align_t). Greater than that, it aligns to sizeof(max_align_t).
+ * This function returns a slot from the pool. It pops the most recently freed slot if there is one
+ * and carves a new slot out of the arena of the pool otherwise.
  *
  * RETURN VALUES
  *
- * Success: If arena is "valid" and size is > zero it either returns a pointer to the beginning
- * of the allocated memory.
- * Error: If either arena is "invalid" or size is <= 0 or allocation failed, then it sets
- * the "err" property of the arena with the error message and returns NULL.
+ * Success: a pointer to a slot of atleast the object size the pool was created with is returned.
+ * Error: If the pool is invalid, NULL is returned. If the arena is out of memory, NULL is returned and the
+ * "err" property of the arena is set with the error message.
+ *
+ * NOTES
+ *
+ * Slots are not zeroed. A reused slot holds whatever was in it when it was freed.
  */
-void *arena_alloc(arena_t *const ar, const size_t sz)
+void *arena_pool_alloc(arena_pool_t *const pool)
+{
+  void *slot = pool->free_list;
+
+  if (slot != NULL) {
+    pool->free_list = *(void **)slot;
+    return slot;
+  }
+
+  if (pool->arena == NULL) {
+    dbg("<< invalid pool");
+    return NULL;
+  }
+
+  return arena_alloc_with_alignment_(pool->arena, pool->slot_size, pool->alignment);
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function gives a slot returned by arena_pool_alloc() back to the pool for reuse. Freeing NULL
+ * is a no-op just like free(). Freeing a slot twice or a pointer that didn't come from the pool is
+ * undefined behavior.
+ */
+void arena_pool_free(arena_pool_t *const pool, void *const ptr)
+{
+  if (ptr == NULL) {
+    return;
+  }
+
+#if defined(DEBUG)
+  memset(ptr, SA_DEBUG_BYTE, pool->slot_size); // make use after free show up in debug tooling
+#endif
+
+  *(void **)ptr = pool->free_list;
+  pool->free_list = ptr;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function forgets every slot of the pool. It must be called whenever the arena of the pool is
+ * reset (e.g., with arena_reset()) to release all slots in bulk. The pool can be used right after.
+ */
+void arena_pool_reset(arena_pool_t *const pool)
+{
+  pool->free_list = NULL;
+}
+
+#define SA_HANDLE_MAX_INDEX (((uint32_t)1 << SA_HANDLE_INDEX_BITS) - 1)
+#define SA_HANDLE_GENERATION_MASK (UINT32_MAX >> SA_HANDLE_INDEX_BITS)
+#define SA_HANDLE_DEAD UINT32_MAX
+
+_Static_assert(SA_HANDLE_INDEX_BITS > 0 && SA_HANDLE_INDEX_BITS < 32,
+               "SA_HANDLE_INDEX_BITS should be between 1 and 31");
+
+/* header in front of every block of an arena_handles_t so that arena_handles_compact() can walk the blocks */
+typedef struct arena_handle_block {
+  size_t size;   /* size of the whole block including this header */
+  uint32_t slot; /* index of the slot owning the block, SA_HANDLE_DEAD once freed */
+} arena_handle_block_t;
+
+/* padded so that the memory handed out is SA_DEFAULT_ALIGNMENT aligned */
+#define SA_HANDLE_HEADER_SIZE arena_round_up_to_multiple_(sizeof(arena_handle_block_t), SA_DEFAULT_ALIGNMENT)
+
+static inline arena_handle_block_t *arena_handle_block_(const arena_handles_t *const handles, const size_t offset)
+{
+  return (arena_handle_block_t *)((uintptr_t)handles->arena->arena + offset);
+}
+
+/* returns the slot of handle or NULL if handle is 0, out of range or stale */
+static inline arena_handle_slot_t *arena_handle_slot_(const arena_handles_t *const handles,
+                                                      const arena_handle_t handle)
+{
+  const uint32_t index = handle & SA_HANDLE_MAX_INDEX;
+
+  if (index == 0 || index > handles->slot_count) {
+    return NULL;
+  }
+
+  arena_handle_slot_t *slot = &handles->slots[index - 1];
+
+  if (!slot->live || slot->generation != handle >> SA_HANDLE_INDEX_BITS) {
+    return NULL;
+  }
+
+  return slot;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function creates a set of handles for blocks of any size carved out of arena ar. Blocks are bump
+ * allocated from the arena with arena_handles_alloc() and referred to by a stable 32-bit arena_handle_t
+ * rather than a pointer. That lets arena_handles_free() leave holes behind which arena_handles_compact()
+ * later removes by sliding the live blocks down and updating their handles, so that a long running
+ * program keeps its blocks dense without having to throw the whole arena away.
+ *
+ * The table of max_handles slots backing the handles is allocated from ar right away.
+ *
+ * arena_handles_t handles = arena_handles_init(&arena, 1024);
+ * arena_handle_t line = arena_handles_alloc(&handles, 80);
+ * char *text = arena_handles_get(&handles, line);
+ * ...
+ * arena_handles_free(&handles, line);
+ * arena_handles_compact(&handles); // pointers from arena_handles_get() are invalid after this
+ *
+ * RETURN VALUES
+ *
+ * Success: The handles are returned by value.
+ * Error: If max_handles is 0 or doesn't fit in SA_HANDLE_INDEX_BITS bits, if ar is a growable arena or if the
+ * slot table doesn't fit in the arena, then handles with a NULL "arena" are returned and the "err" property
+ * of the arena is set with the error message.
+ *
+ * NOTES
+ *
+ * Compaction walks the arena from the first block to the current offset, so nothing else may be allocated
+ * from ar after this call. Growable arenas aren't supported as their blocks aren't contiguous but reserved
+ * arenas are, which makes them a good fit when the total size of the blocks isn't known up front.
+ */
+arena_handles_t arena_handles_init(arena_t *const ar, const uint32_t max_handles)
 {
   ar_dbg(">>", ar);
-  dbg(">> requested size %zu", sz);
+  dbg(">> max handles %u", max_handles);
 
-  /*
-   * Strict validity check as we don't want to allocate in invalid arenas to prevent
-   * data loss for the user.
-   * Although, We don't check for ar->err, as, for e.g. a previous allocation attempt
-   * might have failed due to ARENA_ENOMEM but the currently requested allocation
-   * _might_ fit in the remaining arena memory. We want to allow that.
-   *
-   * Also, as mentioned in the struct definition of arena_t,  ar->err is more for
-   * signaling error to the caller rather than using it for checks within functions
-   * in this lib. Functions here should do their own validations on the arena before
-   * proceeding or signal an error of their own. They should always clobber ar->err
-   * with their own reason for failure.
-   */
-  if (sz <= 0 || ar->arena == NULL || ar->size <= 0 || ar->offset < 0 || ar->offset > ar->size) {
+  if (max_handles == 0 || max_handles > SA_HANDLE_MAX_INDEX || ar->curr_block_ != NULL) {
     ar->err = arena_get_err_msg_(ARENA_EINVAL);
 
     ar_dbg("<<", ar);
-    return NULL;
+    return (arena_handles_t){0};
   }
 
-  uintptr_t ptr = (uintptr_t)ar->arena + ar->offset;
+  arena_handle_slot_t *slots = arena_calloc_aligned(ar, max_handles, sizeof(*slots), _Alignof(arena_handle_slot_t));
 
-  if (sz > 0) {
-    size_t alignment = arena_get_alignment_(sz);
-    size_t remainder = 0;
+  if (slots == NULL) {
+    ar_dbg("<<", ar);
+    return (arena_handles_t){0};
+  }
 
-    if ((remainder = ptr % alignment) != 0) {
-      size_t padding = alignment - remainder;
-      ptr += padding;
-      dbg("++ padding %zu", padding);
-    }
-    /* not using ptrdiff_t as ptr is guaranteed to be greater than ar->arena due to checks and ptr assignment above */
-    size_t ptr_offset = ptr - (uintptr_t)ar->arena;
-    size_t remaining = ar->size - ptr_offset;
-    dbg("++ remaining %zu", remaining);
+  /* blocks are multiples of SA_DEFAULT_ALIGNMENT so they sit back to back after the padding of the first one */
+  const uintptr_t first = arena_round_up_to_multiple_((uintptr_t)ar->arena + ar->offset, SA_DEFAULT_ALIGNMENT);
 
-    /* non-resizeable arena hence we return NULL to signal error */
-    if (sz > remaining) {
-      ar->err = arena_get_err_msg_(ARENA_ENOMEM);
+  ar_dbg("<<", ar);
+  return (arena_handles_t){
+    .arena = ar,
+    .slots = slots,
+    .max_handles = max_handles,
+    .start = first - (uintptr_t)ar->arena,
+  };
+}
 
-      ar_dbg("<<", ar);
-      return NULL;
-    }
+/*
+ * DESCRIPTION
+ *
+ * This function allocates a block of sz bytes aligned to SA_DEFAULT_ALIGNMENT and returns its handle.
+ * Use arena_handles_get() to get to the memory of the block.
+ *
+ * RETURN VALUES
+ *
+ * Success: a non-zero handle is returned.
+ * Error: If the handles are invalid or sz is 0, 0 is returned. If all max_handles handles are in use or the
+ * arena is out of memory, 0 is returned and the "err" property of the arena is set with the error message.
+ * Compacting might make room for the block in the latter case.
+ *
+ * NOTES
+ *
+ * Blocks are not zeroed.
+ */
+arena_handle_t arena_handles_alloc(arena_handles_t *const handles, const size_t sz)
+{
+  dbg(">> size %zu", sz);
 
-    dbg("++ padded ptr %p", (void *)ptr);
+  if (handles->arena == NULL || sz == 0 || sz > SIZE_MAX - SA_HANDLE_HEADER_SIZE - SA_DEFAULT_ALIGNMENT) {
+    dbg("<< invalid handles or size");
+    return 0;
+  }
 
-    /* we need to point to address after the one we are returning in ptr */
-    ar->offset = ptr_offset + sz;
+  uint32_t index = handles->free_slot;
+  if (index == 0 && handles->slot_count == handles->max_handles) {
+    handles->arena->err = arena_get_err_msg_(ARENA_ENOMEM);
+
+    dbg("<< out of handles");
+    return 0;
   }
 
-  /* clear errors as the allocation was successful */
-  ar->err = NULL;
+  const size_t block_sz = SA_HANDLE_HEADER_SIZE + arena_round_up_to_multiple_(sz, SA_DEFAULT_ALIGNMENT);
+  arena_handle_block_t *block = arena_alloc_with_alignment_(handles->arena, block_sz, SA_DEFAULT_ALIGNMENT);
 
-  ar_dbg("<<", ar);
-  dbg("<< allocated ptr %p", (void *)ptr);
-  return (void *)ptr;
+  if (block == NULL) {
+    dbg("<< arena out of memory");
+    return 0;
+  }
+
+  /* pop the most recently freed slot or take a slot that was never used */
+  if (index) {
+    handles->free_slot = handles->slots[index - 1].next_free;
+  } else {
+    index = ++handles->slot_count;
+  }
+
+  arena_handle_slot_t *slot = &handles->slots[index - 1];
+  slot->offset = (uintptr_t)block - (uintptr_t)handles->arena->arena;
+  slot->next_free = 0;
+  slot->live = true;
+
+  block->size = block_sz;
+  block->slot = index - 1;
+  handles->live_bytes += block_sz;
+
+  const arena_handle_t handle = (slot->generation << SA_HANDLE_INDEX_BITS) | index;
+
+  dbg("<< handle %u \t| offset %zu", handle, slot->offset);
+  return handle;
 }
 
 /*
  * DESCRIPTION
  *
- * This function allocates memory for "count" objects, each of size bytes. It then zero-fills
- * the memory region and returns a pointer to the beginning of the allocated memory.
+ * This function returns a pointer to the memory of the block of handle.
  *
  * RETURN VALUES
  *
- * Success: If arena is "valid" and (count * size) is > zero it either returns a pointer to the beginning
- * of the allocated memory or NULL if out of memory.
- * Error: If either arena is "invalid" or size is <= 0, then it sets the "err" property of the arena with
- * the error message and returns NULL.
+ * Success: a pointer to atleast as many bytes as the block was allocated with.
+ * Error: NULL if handle is 0, was freed or didn't come from these handles.
+ *
+ * NOTES
+ *
+ * The pointer is only valid until the next call to arena_handles_compact(), which moves blocks.
+ * Store handles and not pointers in anything that outlives a compaction.
  */
-void *arena_calloc(arena_t *const ar, const size_t count, const size_t sz)
+void *arena_handles_get(const arena_handles_t *const handles, const arena_handle_t handle)
 {
-  dbg(">> count %zu \t| size %zu", count, sz);
-  size_t total_size = count * sz;
-  void *ptr = arena_alloc(ar, total_size);
+  const arena_handle_slot_t *slot = arena_handle_slot_(handles, handle);
 
-  if (ptr == NULL) {
-    dbg("<< Could not allocate memory");
-    return ptr;
+  if (slot == NULL) {
+    dbg("<< invalid handle %u", handle);
+    return NULL;
+  }
+
+  return (void *)((uintptr_t)handles->arena->arena + slot->offset + SA_HANDLE_HEADER_SIZE);
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function frees the block of handle. The handle and any handle with the same slot from before are
+ * invalid from then on. Freeing the most recently allocated block gives its memory back to the arena
+ * right away, any other block leaves a hole behind until the next arena_handles_compact().
+ *
+ * RETURN VALUES
+ *
+ * Success: true if the block was freed.
+ * Error: false if handle is 0, was already freed or didn't come from these handles.
+ */
+bool arena_handles_free(arena_handles_t *const handles, const arena_handle_t handle)
+{
+  dbg(">> handle %u", handle);
+
+  arena_handle_slot_t *slot = arena_handle_slot_(handles, handle);
+
+  if (slot == NULL) {
+    dbg("<< invalid handle %u", handle);
+    return false;
+  }
+
+  arena_handle_block_t *block = arena_handle_block_(handles, slot->offset);
+  const uint32_t index = (uint32_t)(slot - handles->slots) + 1;
+
+  handles->live_bytes -= block->size;
+
+  if (slot->offset + block->size == handles->arena->offset) {
+    handles->arena->offset = slot->offset;
+  } else {
+    block->slot = SA_HANDLE_DEAD;
+    handles->dead_bytes += block->size;
   }
 
-  /*
-   * not zeroing memory before returning as unix, linux and macos return zero-filled memory on MAP_ANONYMOUS
-   * unless DEBUG is defined as arena_create() in debug mode memset's the whole arena to SA_DEBUG_BYTE
-   * which is 0xcd by default. If we don't memset requested bytes to 0 in debug mode, functions that rely on
-   * arena_calloc zero-ing memory behavior will fail in debug mode.
-   */
 #if defined(DEBUG)
-  memset(ptr, 0, total_size);
+  // make use after free show up in debug tooling
+  memset((char *)block + SA_HANDLE_HEADER_SIZE, SA_DEBUG_BYTE, block->size - SA_HANDLE_HEADER_SIZE);
 #endif
 
-  dbg("<< allocated ptr %p", ptr);
-  return ptr;
+  slot->live = false;
+  slot->generation = (slot->generation + 1) & SA_HANDLE_GENERATION_MASK;
+  slot->next_free = handles->free_slot;
+  handles->free_slot = index;
+
+  dbg("<< freed \t| live bytes %zu \t| dead bytes %zu", handles->live_bytes, handles->dead_bytes);
+  return true;
 }
 
 /*
  * DESCRIPTION
  *
- * This function reallocates the memory pointed to by ptr from old_sz to new_sz. It does
- * so by allocating new_sz bytes ahead in the arena and then copying over old_sz bytes starting
- * from ptr to newly allocated memory. If ptr is NULL, then this function behaves like arena_alloc().
+ * This function slides every live block down over the holes left by freed blocks, in the order the blocks
+ * are in, updates the handles of the blocks that moved and gives the freed up memory at the end back to the
+ * arena. Blocks that were allocated together stay together which keeps walking over them cache friendly.
  *
  * RETURN VALUES
  *
- * Success: If arena is "valid" and the ptr + old_sz block is within the arena, a pointer to
- * the new memory allocation is returned.
- * Error: If either arena is "invalid" or ptr + old_sz block is outside of arena, then it sets
- * the "err" property of the arena with the error message and returns NULL.
+ * The number of bytes given back to the arena. It never fails.
  *
  * NOTES
  *
- * Since this is a simple arena allocator, we don't track the size of each allocation represented
- * by a pointer to the arena memory. This means that, if ptr + old_sz is greater than the actual
- * allocation size of the call that returned ptr but ptr + old_sz is still within the arena, then
- * arena_realloc will not complain and copy ptr + old_sz bytes to the new allocation. This means
- * that the new allocation will contain data from some other allocation.
- * We are ok with trading this off for simplicity though as this allocator is meant to be freed
- * often - for e.g., on each render loop of a game or text editor.
+ * Every pointer returned by arena_handles_get() before this call is invalid afterwards. It is O(n) in the
+ * number of blocks, live or dead, and copies every live block after the first hole.
  */
-void *arena_realloc(arena_t *const ar, void *ptr, const size_t old_sz, const size_t new_sz)
+size_t arena_handles_compact(arena_handles_t *const handles)
 {
-  ar_dbg(">>", ar);
-  dbg(">> ptr to realloc %p \t| old size %zu \t| new size %zu", ptr, old_sz, new_sz);
+  dbg(">> live bytes %zu \t| dead bytes %zu", handles->live_bytes, handles->dead_bytes);
 
-  /* if ptr is null, act like a call to arena_alloc() just like realloc() does */
-  /* also, old_sz is ignored when ptr is NULL so it can be 0, 12312, whatever */
-  if (ptr == NULL) {
-    void *new_ptr = arena_alloc(ar, new_sz);
+  if (handles->arena == NULL || handles->dead_bytes == 0) {
+    dbg("<< nothing to compact");
+    return 0;
+  }
 
-    if (new_ptr == NULL) {
-      dbg("<< Could not allocate memory");
-      return NULL;
+  arena_t *const ar = handles->arena;
+  size_t write = handles->start;
+  size_t read = handles->start;
+
+  while (read < ar->offset) {
+    arena_handle_block_t *block = arena_handle_block_(handles, read);
+    const size_t block_sz = block->size;
+
+    if (block->slot != SA_HANDLE_DEAD) {
+      if (write != read) {
+        handles->slots[block->slot].offset = write;
+        memmove(arena_handle_block_(handles, write), block, block_sz);
+      }
+      write += block_sz;
     }
 
-    ar_dbg("<<", ar);
-    return new_ptr;
+    read += block_sz;
   }
 
-  /* bounds check on the incoming ptr + old size combo to make sure they are within arena */
-  if (old_sz <= 0 || ptr < ar->arena || ((uintptr_t)ptr + old_sz) >= ((uintptr_t)ar->arena + ar->size)) {
-    ar->err = arena_get_err_msg_(ARENA_EINVAL);
+  const size_t reclaimed = ar->offset - write;
 
-    ar_dbg("<<", ar);
-    return NULL;
+#if defined(DEBUG)
+  memset(arena_handle_block_(handles, write), SA_DEBUG_BYTE, reclaimed); // same as arena_create()
+#endif
+
+  ar->offset = write;
+  handles->dead_bytes = 0;
+
+  dbg("<< reclaimed %zu", reclaimed);
+  return reclaimed;
+}
+
+/*
+ * DESCRIPTION
+ *
+ * This function frees every block at once and rewinds the arena to right after the slot table. Every
+ * handle handed out before is invalid afterwards.
+ */
+void arena_handles_reset(arena_handles_t *const handles)
+{
+  if (handles->arena == NULL) {
+    return;
   }
 
-  void *new_ptr = arena_alloc(ar, new_sz);
+  /* bump the generation of every live slot so that old handles stay invalid once their slot is reused */
+  handles->free_slot = 0;
+  for (uint32_t i = handles->slot_count; i > 0; i--) {
+    arena_handle_slot_t *slot = &handles->slots[i - 1];
 
-  if (new_ptr == NULL) {
-    dbg("<< Could not allocate memory");
-    return NULL;
+    if (slot->live) {
+      slot->live = false;
+      slot->generation = (slot->generation + 1) & SA_HANDLE_GENERATION_MASK;
+    }
+    slot->next_free = handles->free_slot;
+    handles->free_slot = i;
   }
 
-  memcpy(new_ptr, ptr, new_sz < old_sz ? new_sz : old_sz);
+  handles->arena->offset = handles->start < handles->arena->offset ? handles->start : handles->arena->offset;
+  handles->live_bytes = 0;
+  handles->dead_bytes = 0;
+}
 
-  ar_dbg("<<", ar);
-  return new_ptr;
+#if defined(SA_STATS_ENABLE)
+/*
+ * DESCRIPTION
+ *
+ * This function prints the usage statistics of the arena (see arena_stats_t) to stream, along with
+ * how much of the arena is used right now. It's meant to help with sizing arenas for a workload, e.g.,
+ * a peak offset far below the size of the arena means the arena can be made smaller whereas a non-zero
+ * ENOMEM count means it should be made larger or growable. Only available if SA_STATS_ENABLE is defined.
+ */
+void arena_stats_dump(const arena_t *const ar, FILE *const stream)
+{
+  const arena_stats_t *const stats = &ar->stats;
+  const size_t consumed = stats->bytes_requested + stats->bytes_padding;
+
+  fprintf(stream, "arena %p stats\n", ar->arena);
+  fprintf(stream, "  allocations     : %zu\n", stats->alloc_count);
+  fprintf(stream, "  bytes requested : %zu\n", stats->bytes_requested);
+  fprintf(stream, "  bytes consumed  : %zu (padding %zu, %.2f%%)\n",
+          consumed, stats->bytes_padding, consumed ? 100.0 * (double)stats->bytes_padding / (double)consumed : 0.0);
+  fprintf(stream, "  offset          : %zu of %zu\n", ar->offset, ar->size);
+  fprintf(stream, "  peak offset     : %zu\n", stats->peak_offset);
+  fprintf(stream, "  resets          : %zu\n", stats->reset_count);
+  fprintf(stream, "  ENOMEM failures : %zu\n", stats->enomem_count);
+
+  if (ar->first_block_) {
+    size_t block_count = 0;
+    size_t block_bytes = 0;
+
+    for (const arena_block_t *block = ar->first_block_; block; block = block->next) {
+      block_count++;
+      block_bytes += block->size;
+    }
+    fprintf(stream, "  blocks          : %zu (%zu bytes)\n", block_count, block_bytes);
+  }
+
+  if (ar->reserved_) {
+    fprintf(stream, "  committed       : %zu of %zu reserved\n", ar->size, ar->reserved_);
+  }
 }
+#endif // SA_STATS_ENABLE
 
 #elif defined(_WIN32) || defined(_WIN64)
 /* No support for windows yet */
@@ -536,4 +2850,4 @@ void *arena_realloc(arena_t *const ar, void *ptr, const size_t old_sz, const siz
 /* Unsupported OSes */
 #endif
 
-#endif // ZDX_SIMPLE_ARENA_IMPLEMENTATION
+#endif // ZDX_SIMPLE_ARENA_IMPLEMENTATION && !ZDX_SIMPLE_ARENA_IMPLEMENTATION_INCLUDED_
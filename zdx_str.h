@@ -62,10 +62,21 @@
 #define SB_MIN_CAPACITY 16
 #endif
 
+/*
+ * Defining SB_ALLOCATOR_ENABLE gives sb_t a `mem_allocator_t *allocator` member. When it is NULL sb->str
+ * is managed with SB_REALLOC and SB_FREE as usual, otherwise with the given allocator (see zdx_memory.h).
+ */
+#ifdef SB_ALLOCATOR_ENABLE
+#include "./zdx_memory.h"
+#endif // SB_ALLOCATOR_ENABLE
+
 typedef struct string_builder {
   size_t capacity;
   size_t length;
   char *str;
+#ifdef SB_ALLOCATOR_ENABLE
+  mem_allocator_t *allocator;
+#endif // SB_ALLOCATOR_ENABLE
 } sb_t;
 
 /* Calling sb_concat with a non-c string array will lead to undefined behaviour */
@@ -96,15 +107,37 @@ void sb_deinit(sb_t sb[const static 1]);
 
 /* ---- STRING BUILDER IMPLEMENTATION ---- */
 
+#ifdef SB_ALLOCATOR_ENABLE
+#define sb_realloc_str_(sb, old_sz, new_sz)                                    \
+  ((sb)->allocator                                                             \
+   ? (sb)->allocator->realloc((sb)->allocator, (sb)->str, (old_sz), (new_sz))  \
+   : SB_REALLOC((sb)->str, (new_sz)))
+
+#define sb_free_str_(sb)                                          \
+  do {                                                            \
+    if ((sb)->allocator) {                                        \
+      (sb)->allocator->free((sb)->allocator, (void *)(sb)->str);  \
+    } else {                                                      \
+      SB_FREE((void *)(sb)->str);                                 \
+    }                                                             \
+  } while(0)
+#else
+#define sb_realloc_str_(sb, old_sz, new_sz) ((void)(old_sz), SB_REALLOC((sb)->str, (new_sz)))
+#define sb_free_str_(sb) SB_FREE((void *)(sb)->str)
+#endif // SB_ALLOCATOR_ENABLE
+
 static void sb_resize_(sb_t sb[const static 1], const size_t reqd_capacity)
 {
+  const size_t old_capacity = sb->capacity;
+
   if (sb->capacity <= 0) {
     sb->capacity = SB_MIN_CAPACITY;
   }
   while(sb->capacity < reqd_capacity) {
     sb->capacity *= SB_RESIZE_FACTOR;
   }
-  sb->str = SB_REALLOC(sb->str, sb->capacity * sizeof(char));
+
+  sb->str = sb_realloc_str_(sb, old_capacity * sizeof(char), sb->capacity * sizeof(char));
   SB_ASSERT(sb->str != NULL, "[zdx str] string builder resize allocation failed");
 
   dbg("++ resized (capacity %zu)", sb->capacity);
@@ -176,9 +209,10 @@ size_t sb_append_buf(sb_t sb[const static 1], const char *buf, const size_t buf_
   return sb->length;
 }
 
+/* sb->allocator, if any, is left as is so the string builder can be reused with the same allocator */
 void sb_deinit(sb_t sb[const static 1])
 {
-  SB_FREE((void *)sb->str);
+  sb_free_str_(sb);
   sb->str = NULL;
   sb->length = 0;
   sb->capacity = 0;
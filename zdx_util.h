@@ -81,7 +81,7 @@
 
 #include <stdint.h> /* needed for uint<bits>_t types such as uint32_t, etc */
 
-// TODO(mudit): Remove POPCOUNTG and CLZG macros once __builtin_popcountg and __builtin_clzg
+// TODO(mudit): Remove POPCOUNTG, CLZG and CTZG macros once __builtin_popcountg, __builtin_clzg and __builtin_ctzg
 //              are widely available on default compilers for platforms.
 
 #define POPCOUNTG(n) _Generic((n),                                      \
@@ -98,6 +98,13 @@
                                  unsigned long long: __builtin_clzll    \
                                  )((n))
 
+// DO NOT pass n == 0 to this either, same as NONZERO_CLZG
+#define NONZERO_CTZG(n) _Generic((n),                                   \
+                                 unsigned int: __builtin_ctz,           \
+                                 unsigned long: __builtin_ctzl,         \
+                                 unsigned long long: __builtin_ctzll    \
+                                 )((n))
+
 #define CLOSESTPOWEROF2(n)                                                              \
   _Pragma("GCC diagnostic push")                                                        \
   _Pragma("GCC diagnostic ignored \"-Wgnu-statement-expression-from-macro-expansion\"") \
@@ -117,7 +124,7 @@
   })                                                                                    \
   _Pragma("GCC diagnostic pop")
 #else
-_Static_assert(0, "Unsupported compiler. Cannot define POPCOUNTG, NONZERO_CLZG and CLOSESTPOWEROF2");
+_Static_assert(0, "Unsupported compiler. Cannot define POPCOUNTG, NONZERO_CLZG, NONZERO_CTZG and CLOSESTPOWEROF2");
 #endif // gnu and clang version check ifdef
 
 